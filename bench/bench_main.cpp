@@ -0,0 +1,533 @@
+// ============================================================
+// BENCH_MAIN.CPP - GB-BENCH (BENCHMARKS DEL CORE)
+// ============================================================
+// Microbenchmarks por subsistema y throughput de frames completos,
+// con la salida en JSON por stdout para comparar entre commits:
+//
+//   gb-bench [rom.gb ...] [--frames N] [--quick]
+//            [--only cpu,mmu,ppu,apu,frame]
+//
+//   cpu    cpu::step sobre mezclas sintéticas de instrucciones
+//          (ALU, cargas, saltos/pila), con cada motor de dispatch
+//   mmu    readMemory/writeMemory por región del mapa de memoria
+//   ppu    un frame de scanlines con distintas configuraciones de LCDC
+//   apu    APU::tick con los cuatro canales sonando
+//   frame  gameboy::run_frame sobre ROMs reales (por defecto
+//          roms/examples.gb), con cada motor de dispatch
+//
+// Los logs del core se silencian igual que en gb-emu-headless.
+// ============================================================
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/gameboy.h"
+
+#ifndef GB_BENCH_DEFAULT_ROM
+#define GB_BENCH_DEFAULT_ROM "roms/examples.gb"
+#endif
+
+namespace {
+
+struct Options {
+    std::vector<std::string> roms;
+    uint64_t    frames = 600;       // Frames medidos por ROM y motor
+    bool        quick  = false;     // Menos iteraciones (smoke test)
+    std::string only;               // vacío = todos los grupos
+};
+
+void print_usage(const char* argv0)
+{
+    std::cerr << "Uso: " << argv0 << " [rom.gb ...] [opciones]\n"
+              << "  --frames N     Frames medidos por ROM y motor (default 600)\n"
+              << "  --quick        Menos iteraciones en todos los casos\n"
+              << "  --only LISTA   Grupos a ejecutar: cpu,mmu,ppu,apu,frame\n";
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (!std::strcmp(arg, "--frames") && has_value) {
+            opt.frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--quick")) {
+            opt.quick = true;
+        } else if (!std::strcmp(arg, "--only") && has_value) {
+            opt.only = argv[++i];
+        } else if (arg[0] != '-') {
+            opt.roms.push_back(arg);
+        } else {
+            std::cerr << "Argumento no reconocido: " << arg << "\n";
+            return false;
+        }
+    }
+    if (opt.roms.empty()) opt.roms.push_back(GB_BENCH_DEFAULT_ROM);
+    return true;
+}
+
+bool group_enabled(const Options& opt, const char* group)
+{
+    if (opt.only.empty()) return true;
+    std::stringstream list(opt.only);
+    std::string item;
+    while (std::getline(list, item, ',')) {
+        if (item == group) return true;
+    }
+    return false;
+}
+
+// ============================================================
+// SALIDA JSON
+// ============================================================
+// Cada caso es un objeto plano; los grupos son arrays de casos.
+class json_writer
+{
+public:
+    explicit json_writer(std::ostream& out_ref) : out(out_ref) { out << "{"; }
+    ~json_writer() { out << "\n}\n"; }
+
+    void begin_group(const char* name)
+    {
+        out << (first_group ? "\n" : ",\n") << "  \"" << name << "\": [";
+        first_group = false;
+        first_case = true;
+    }
+    void end_group() { out << (first_case ? "]" : "\n  ]"); }
+
+    void begin_case()
+    {
+        out << (first_case ? "\n" : ",\n") << "    {";
+        first_case = false;
+        first_field = true;
+    }
+    void end_case() { out << "}"; }
+
+    void field(const char* key, const std::string& value)
+    {
+        separator(key);
+        out << "\"" << value << "\"";
+    }
+    void field(const char* key, uint64_t value)
+    {
+        separator(key);
+        out << value;
+    }
+    void field(const char* key, double value, int precision)
+    {
+        separator(key);
+        out << std::fixed << std::setprecision(precision) << value;
+    }
+
+private:
+    std::ostream& out;
+    bool first_group = true;
+    bool first_case  = true;
+    bool first_field = true;
+
+    void separator(const char* key)
+    {
+        out << (first_field ? "" : ", ") << "\"" << key << "\": ";
+        first_field = false;
+    }
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+double elapsed_ns(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+}
+
+// Evita que el compilador elimine las lecturas medidas
+volatile uint32_t sink;
+
+struct EngineInfo { cpu::Engine engine; const char* name; };
+
+const EngineInfo ENGINES[] = {
+    { cpu::Engine::Table,      "table"  },
+    { cpu::Engine::Switch,     "switch" },
+    { cpu::Engine::BlockCache, "cached" },
+#ifdef GB_ENABLE_JIT
+    { cpu::Engine::Jit,        "jit"    },
+#endif
+};
+
+// ============================================================
+// ROM SINTÉTICA
+// ============================================================
+// ROM-only de 32 KB: 0x0100 salta a 0x0150, que inicializa SP/HL/BC/DE
+// y entra en un bucle con 'body' repetido 32 veces y un JP al inicio.
+// En 0x1000 hay un RET para las mezclas con CALL.
+constexpr uint16_t SYNTH_LOOP = 0x015C;
+constexpr uint16_t SYNTH_SUB  = 0x1000;
+
+std::string write_synthetic_rom(const char* name, const std::vector<uint8_t>& body)
+{
+    std::vector<uint8_t> rom(0x8000, 0x00);
+
+    const uint8_t entry[] = { 0x00, 0xC3, 0x50, 0x01 };   // NOP; JP 0x0150
+    std::memcpy(&rom[0x100], entry, sizeof(entry));
+    std::memcpy(&rom[0x134], "GB-BENCH", 8);
+    rom[0x147] = 0x00;   // ROM ONLY
+    rom[0x148] = 0x00;   // 32 KB
+    rom[0x149] = 0x00;   // Sin RAM
+
+    uint8_t checksum = 0;   // Header checksum (0x134-0x14C)
+    for (int i = 0x134; i <= 0x14C; i++) checksum = checksum - rom[i] - 1;
+    rom[0x14D] = checksum;
+
+    const uint8_t setup[] = {
+        0x31, 0xF0, 0xDF,   // LD SP,0xDFF0
+        0x21, 0x00, 0xC0,   // LD HL,0xC000
+        0x01, 0x34, 0x12,   // LD BC,0x1234
+        0x11, 0x78, 0x56,   // LD DE,0x5678
+    };
+    std::memcpy(&rom[0x150], setup, sizeof(setup));
+
+    size_t pc = SYNTH_LOOP;
+    for (int i = 0; i < 32; i++) {
+        std::memcpy(&rom[pc], body.data(), body.size());
+        pc += body.size();
+    }
+    rom[pc++] = 0xC3;                           // JP SYNTH_LOOP
+    rom[pc++] = SYNTH_LOOP & 0xFF;
+    rom[pc++] = SYNTH_LOOP >> 8;
+
+    rom[SYNTH_SUB] = 0xC9;                      // RET
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                 (std::string("gb-bench-") + name + ".gb");
+    std::ofstream out(path, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(rom.data()), rom.size());
+    return path.string();
+}
+
+// ============================================================
+// CPU: cpu::step SOBRE MEZCLAS SINTÉTICAS
+// ============================================================
+void bench_cpu(json_writer& json, const Options& opt)
+{
+    struct Mix { const char* name; std::vector<uint8_t> body; };
+    const Mix mixes[] = {
+        { "alu", {
+            0x80,               // ADD A,B
+            0x91,               // SUB C
+            0xA2,               // AND D
+            0xB3,               // OR E
+            0xAC,               // XOR H
+            0x3C,               // INC A
+            0x05,               // DEC B
+            0xCB, 0x37,         // SWAP A
+            0x2F,               // CPL
+            0x87,               // ADD A,A
+            0x09,               // ADD HL,BC
+        } },
+        { "load", {
+            0x78,               // LD A,B
+            0x41,               // LD B,C
+            0x06, 0x12,         // LD B,0x12
+            0x0E, 0x34,         // LD C,0x34
+            0x77,               // LD (HL),A
+            0x7E,               // LD A,(HL)
+            0x22,               // LD (HL+),A
+            0x2B,               // DEC HL
+            0xEA, 0x00, 0xC1,   // LD (0xC100),A
+            0xFA, 0x00, 0xC1,   // LD A,(0xC100)
+            0x1A,               // LD A,(DE)
+        } },
+        { "branch", {
+            0xAF,               // XOR A (Z=1)
+            0x20, 0x00,         // JR NZ,+0 (no tomado)
+            0x28, 0x00,         // JR Z,+0 (tomado)
+            0xCD, SYNTH_SUB & 0xFF, SYNTH_SUB >> 8,   // CALL SYNTH_SUB
+            0xC5,               // PUSH BC
+            0xC1,               // POP BC
+            0x18, 0x00,         // JR +0
+        } },
+    };
+
+    // Presupuesto en T-cycles: todos los motores ejecutan el mismo tramo
+    const uint64_t budget = opt.quick ? 10000000 : 100000000;
+
+    json.begin_group("cpu");
+    for (const Mix& mix : mixes) {
+        std::string path = write_synthetic_rom(mix.name, mix.body);
+
+        for (const EngineInfo& info : ENGINES) {
+            mmu memory(path);
+            cpu processor(memory);
+            processor.setEngine(info.engine);
+
+            // Calentar: cachés de bloques / JIT
+            for (int i = 0; i < 10000; i++) processor.step();
+
+            uint64_t cycles = 0;
+            uint64_t retired = 0;
+            auto start = bench_clock::now();
+            while (cycles < budget) {
+                cycles += processor.step();
+                retired += processor.stepInstructions();
+            }
+            double ns = elapsed_ns(start);
+
+            double instructions = static_cast<double>(retired);
+
+            json.begin_case();
+            json.field("mix", mix.name);
+            json.field("engine", info.name);
+            json.field("instructions", static_cast<uint64_t>(instructions));
+            json.field("ns_per_instruction", ns / instructions, 3);
+            json.field("mips", instructions / ns * 1000.0, 1);
+            json.field("cycles_per_instruction", cycles / instructions, 2);
+            json.end_case();
+        }
+
+        std::remove(path.c_str());
+    }
+    json.end_group();
+}
+
+// ============================================================
+// MMU: readMemory / writeMemory POR REGIÓN
+// ============================================================
+void bench_mmu(json_writer& json, const Options& opt)
+{
+    struct Region { const char* name; uint16_t start; uint16_t end; bool write; };
+    const Region regions[] = {
+        { "rom0",       0x0000, 0x3FFF, false },
+        { "romx",       0x4000, 0x7FFF, false },
+        { "vram",       0x8000, 0x9FFF, false },
+        { "wram",       0xC000, 0xDFFF, false },
+        { "echo",       0xE000, 0xFDFF, false },
+        { "oam",        0xFE00, 0xFE9F, false },
+        { "io",         0xFF47, 0xFF4B, false },
+        { "hram",       0xFFA0, 0xFFFE, false },
+        { "vram_tiles", 0x8000, 0x97FF, true  },
+        { "vram_map",   0x9800, 0x9FFF, true  },
+        { "wram",       0xC000, 0xDFFF, true  },
+        { "echo",       0xE000, 0xFDFF, true  },
+        { "oam",        0xFE00, 0xFE9F, true  },
+        { "hram",       0xFFA0, 0xFFFE, true  },
+    };
+
+    const uint64_t accesses = opt.quick ? 1000000 : 10000000;
+
+    std::string path = write_synthetic_rom("mmu", { 0x00 });
+    mmu memory(path);
+
+    json.begin_group("mmu");
+    for (const Region& region : regions) {
+        uint32_t span = region.end - region.start + 1;
+        uint32_t offset = 0;
+        uint32_t sum = 0;
+
+        auto start = bench_clock::now();
+        for (uint64_t i = 0; i < accesses; i++) {
+            uint16_t address = static_cast<uint16_t>(region.start + offset);
+            if (region.write) memory.writeMemory(address, static_cast<uint8_t>(i));
+            else              sum += memory.readMemory(address);
+            if (++offset == span) offset = 0;
+        }
+        double ns = elapsed_ns(start);
+        sink = sum;
+
+        json.begin_case();
+        json.field("region", region.name);
+        json.field("op", region.write ? "write" : "read");
+        json.field("accesses", accesses);
+        json.field("ns_per_access", ns / accesses, 3);
+        json.end_case();
+    }
+    json.end_group();
+
+    std::remove(path.c_str());
+}
+
+// ============================================================
+// PPU: SCANLINES CON DISTINTAS CONFIGURACIONES DE LCDC
+// ============================================================
+void bench_ppu(json_writer& json, const Options& opt)
+{
+    struct Config { const char* name; uint8_t lcdc; };
+    const Config configs[] = {
+        { "bg",           0x91 },   // BG, tiles 0x8000, mapa 0x9800
+        { "bg_signed",    0x81 },   // BG, tiles 0x8800 (IDs con signo)
+        { "bg_window",    0xF1 },   // BG + Window (mapa 0x9C00) a pantalla completa
+        { "sprites_8x8",  0x93 },   // BG + 40 sprites 8x8 (10 por línea)
+        { "sprites_8x16", 0x97 },   // BG + 40 sprites 8x16
+        { "all",          0xF7 },   // BG + Window + sprites 8x16
+        { "lcd_off",      0x11 },
+    };
+
+    const int frames = opt.quick ? 60 : 600;
+
+    std::string path = write_synthetic_rom("ppu", { 0x00 });
+    mmu memory(path);
+    ppu video(memory);
+
+    // VRAM y OAM con contenido pseudoaleatorio (LCG)
+    uint32_t seed = 0x12345678;
+    auto next = [&seed]() { seed = seed * 1664525 + 1013904223; return static_cast<uint8_t>(seed >> 24); };
+    for (uint16_t a = 0x8000; a <= 0x9FFF; a++) memory.writeMemory(a, next());
+    for (int i = 0; i < 40; i++) {
+        memory.writeMemory(0xFE00 + i * 4 + 0, static_cast<uint8_t>(16 + (i / 10) * 36));  // Y
+        memory.writeMemory(0xFE00 + i * 4 + 1, static_cast<uint8_t>(8 + (i % 10) * 16));   // X
+        memory.writeMemory(0xFE00 + i * 4 + 2, next());                                    // Tile
+        memory.writeMemory(0xFE00 + i * 4 + 3, next() & 0xF0);                             // Flags
+    }
+    memory.writeMemory(0xFF47, 0xE4);   // BGP
+    memory.writeMemory(0xFF48, 0xE4);   // OBP0
+    memory.writeMemory(0xFF49, 0x1B);   // OBP1
+    memory.writeMemory(0xFF4A, 0x00);   // WY
+    memory.writeMemory(0xFF4B, 0x07);   // WX
+
+    json.begin_group("ppu");
+    for (const Config& config : configs) {
+        memory.writeMemory(0xFF40, config.lcdc);
+        video.step(T_CYCLES_PER_FRAME);   // Calentar / estabilizar el modo
+
+        auto start = bench_clock::now();
+        for (int i = 0; i < frames; i++) video.step(T_CYCLES_PER_FRAME);
+        double ns = elapsed_ns(start);
+
+        std::ostringstream lcdc;
+        lcdc << "0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(config.lcdc);
+
+        json.begin_case();
+        json.field("config", config.name);
+        json.field("lcdc", lcdc.str());
+        json.field("frames", static_cast<uint64_t>(frames));
+        json.field("ns_per_frame", ns / frames, 1);
+        json.field("ns_per_scanline", ns / frames / 154, 1);
+        json.field("frames_per_sec", frames / ns * 1e9, 1);
+        json.end_case();
+    }
+    json.end_group();
+
+    std::remove(path.c_str());
+}
+
+// ============================================================
+// APU: TICK CON LOS CUATRO CANALES ACTIVOS
+// ============================================================
+void bench_apu(json_writer& json, const Options& opt)
+{
+    const int frames = opt.quick ? 300 : 3000;
+
+    APU apu;
+    const uint16_t setup[][2] = {
+        { 0xFF26, 0x80 }, { 0xFF24, 0x77 }, { 0xFF25, 0xFF },
+        // CH1: duty 50%, volumen 15, sin sweep ni length
+        { 0xFF10, 0x00 }, { 0xFF11, 0x80 }, { 0xFF12, 0xF0 }, { 0xFF13, 0x00 }, { 0xFF14, 0x87 },
+        // CH2: duty 25%
+        { 0xFF16, 0x40 }, { 0xFF17, 0xF0 }, { 0xFF18, 0x80 }, { 0xFF19, 0x86 },
+        // CH3: wave, volumen 100%
+        { 0xFF1A, 0x80 }, { 0xFF1C, 0x20 }, { 0xFF1D, 0x00 }, { 0xFF1E, 0x87 },
+        // CH4: ruido
+        { 0xFF21, 0xF0 }, { 0xFF22, 0x22 }, { 0xFF23, 0x80 },
+    };
+    for (uint16_t a = 0xFF30; a <= 0xFF3F; a++) apu.writeByte(a, static_cast<uint8_t>((a & 0x0F) * 0x11));
+    for (const auto& reg : setup) apu.writeByte(reg[0], static_cast<uint8_t>(reg[1]));
+
+    uint64_t samples = 0;
+    auto start = bench_clock::now();
+    for (int i = 0; i < frames; i++) {
+        apu.tick(T_CYCLES_PER_FRAME);
+        samples += apu.fillOutputBuffer(OUTPUT_BUFFER_SIZE);
+    }
+    double ns = elapsed_ns(start);
+
+    json.begin_group("apu");
+    json.begin_case();
+    json.field("config", "all_channels");
+    json.field("frames", static_cast<uint64_t>(frames));
+    json.field("ns_per_frame", ns / frames, 1);
+    json.field("frames_per_sec", frames / ns * 1e9, 1);
+    json.field("samples_per_frame", static_cast<double>(samples) / frames, 1);
+    json.end_case();
+    json.end_group();
+}
+
+// ============================================================
+// FRAME: gameboy::run_frame SOBRE ROMs REALES
+// ============================================================
+void bench_frames(json_writer& json, const Options& opt)
+{
+    const uint64_t frames = opt.quick ? std::min<uint64_t>(opt.frames, 120) : opt.frames;
+
+    json.begin_group("frame");
+    for (const std::string& rom : opt.roms) {
+        for (const EngineInfo& info : ENGINES) {
+            gameboy gb(rom);
+            if (!gb.is_loaded()) {
+                std::cerr << "[Bench] ERROR: no se pudo cargar la ROM: " << rom << "\n";
+                break;
+            }
+            gb.processor.setEngine(info.engine);
+
+            // Calentar (arranque del juego, cachés) y medir desde ahí
+            for (int i = 0; i < 60; i++) gb.run_frame();
+            uint64_t cycles0 = gb.total_cycles;
+            uint64_t instr0  = gb.total_instructions;
+            uint64_t halted0 = gb.halted_cycles;
+
+            auto start = bench_clock::now();
+            for (uint64_t i = 0; i < frames; i++) gb.run_frame();
+            double ns = elapsed_ns(start);
+
+            uint64_t cycles       = gb.total_cycles - cycles0;
+            uint64_t instructions = gb.total_instructions - instr0;
+            uint64_t halted       = gb.halted_cycles - halted0;
+
+            json.begin_case();
+            json.field("rom", std::filesystem::path(rom).filename().string());
+            json.field("engine", info.name);
+            json.field("frames", frames);
+            json.field("frames_per_sec", frames / ns * 1e9, 1);
+            json.field("ns_per_instruction", instructions ? ns / instructions : 0.0, 3);
+            json.field("cycles_per_frame", static_cast<double>(cycles) / frames, 1);
+            json.field("instructions_per_frame", static_cast<double>(instructions) / frames, 1);
+            json.field("halted_pct", cycles ? 100.0 * halted / cycles : 0.0, 1);
+            json.end_case();
+        }
+    }
+    json.end_group();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // El JSON va por 'report'; std::cout (logs del core) se silencia
+    std::ostream report(std::cout.rdbuf());
+    std::cout.rdbuf(nullptr);
+
+    {
+        json_writer json(report);
+        if (group_enabled(opt, "cpu"))   bench_cpu(json, opt);
+        if (group_enabled(opt, "mmu"))   bench_mmu(json, opt);
+        if (group_enabled(opt, "ppu"))   bench_ppu(json, opt);
+        if (group_enabled(opt, "apu"))   bench_apu(json, opt);
+        if (group_enabled(opt, "frame")) bench_frames(json, opt);
+    }
+
+    return 0;
+}
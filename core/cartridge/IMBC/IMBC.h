@@ -1,18 +1,50 @@
 #ifndef IMBC_H
 #define IMBC_H
 
+#include <cstdint>
 #include <fstream>
 #include <iostream>
 
+#include "state/state_io.h"
+#include "mmu/paged_ram.h"
+
+// Bancos mapeados actualmente. nullptr (o -1 en la RAM) significa
+// "no hay acceso directo" (RAM deshabilitada, RTC seleccionado, banco
+// fuera de rango...) y la lectura pasa por el método virtual del MBC.
+// La RAM externa va en páginas copy-on-write (paged_ram), así que se
+// publica como desplazamiento del banco y no como puntero.
+struct BankMap
+{
+    const uint8_t* rom0 = nullptr;   // 0x0000-0x3FFF
+    const uint8_t* romx = nullptr;   // 0x4000-0x7FFF
+    int32_t        ram  = -1;        // 0xA000-0xBFFF (lectura y escritura)
+};
+
 class IMBC
 {
     public:
         virtual ~IMBC() = default;
 
+        // Bancos publicados por el MBC. Solo cambian al escribir en sus
+        // registros de control, así que leer a través de ellos no
+        // necesita dispatch virtual.
+        const BankMap& bankMap() const { return banks; }
+
         //
         virtual uint8_t readROM(uint16_t address) = 0;
         virtual void writeROM(uint16_t address, uint8_t value) = 0;
         virtual uint8_t readRAM(uint16_t address) = 0;
         virtual void writeRAM(uint16_t address, uint8_t value) = 0;
+
+        // Banco de ROM mapeado actualmente en 0x4000-0x7FFF
+        virtual uint16_t currentRomBank() const = 0;
+
+        // Registros del MBC en el save state (la RAM la guarda el
+        // cartucho). loadState debe volver a publicar los bancos.
+        virtual void saveState(state_writer&) const {}
+        virtual void loadState(state_reader&) {}
+
+    protected:
+        BankMap banks;
 };
 #endif // CARTRIDGE_H
\ No newline at end of file
@@ -1,12 +1,23 @@
 #include "MBC1.h"
 
-MBC1::MBC1(std::vector<uint8_t>& rom_ref, std::vector<uint8_t>& ram_ref, uint16_t banks) 
+MBC1::MBC1(std::vector<uint8_t>& rom_ref, paged_ram& ram_ref, uint16_t banks) 
     : rom(rom_ref), ram(ram_ref), romBanksCount(banks)
 {
     romBank = 1; // El banco 1 es el default en 0x4000-0x7FFF
     ramBank = 0;
     ramEnabled = false;
     bankingMode = 0;
+    updateBanks();
+}
+
+void MBC1::updateBanks() {
+    banks.rom0 = (rom.size() >= 0x4000) ? rom.data() : nullptr;
+
+    uint32_t base = romBank * 0x4000;
+    banks.romx = (base + 0x4000 <= rom.size()) ? rom.data() + base : nullptr;
+
+    // RAM básica sin banking (igual que readRAM/writeRAM)
+    banks.ram = (ramEnabled && ram.size() >= 0x2000) ? 0 : -1;
 }
 
 uint8_t MBC1::readROM(uint16_t address) {
@@ -41,6 +52,7 @@ void MBC1::writeROM(uint16_t address, uint8_t value) {
     else if (address >= 0x6000 && address < 0x8000) {
         bankingMode = value & 0x01;
     }
+    updateBanks();
 }
 
 uint8_t MBC1::readRAM(uint16_t address) {
@@ -48,7 +60,7 @@ uint8_t MBC1::readRAM(uint16_t address) {
     
     // Simplificado para RAM básica
     uint16_t offset = address - 0xA000;
-    if (offset < ram.size()) return ram[offset];
+    if (offset < ram.size()) return ram.read(offset);
     return 0xFF;
 }
 
@@ -56,5 +68,20 @@ void MBC1::writeRAM(uint16_t address, uint8_t value) {
     if (!ramEnabled) return;
 
     uint16_t offset = address - 0xA000;
-    if (offset < ram.size()) ram[offset] = value;
-}
\ No newline at end of file
+    if (offset < ram.size()) ram.write(offset, value);
+}
+// --- Save state ---
+void MBC1::saveState(state_writer& out) const {
+    out.put(romBank);
+    out.put(ramBank);
+    out.put(ramEnabled);
+    out.put(bankingMode);
+}
+
+void MBC1::loadState(state_reader& in) {
+    in.get(romBank);
+    in.get(ramBank);
+    in.get(ramEnabled);
+    in.get(bankingMode);
+    updateBanks();
+}
@@ -5,7 +5,7 @@
 class MBC1 : public IMBC {
 private:
     std::vector<uint8_t>& rom;
-    std::vector<uint8_t>& ram;
+    paged_ram& ram;
     
     uint8_t romBank;
     uint8_t ramBank;
@@ -13,13 +13,20 @@ private:
     uint8_t bankingMode; 
     uint16_t romBanksCount;
 
+    void updateBanks(); // Recalcula banks tras escribir un registro
+
 public:
     // Nota: El constructor debe coincidir con la llamada en cartridge.cpp
-    MBC1(std::vector<uint8_t>& rom_ref, std::vector<uint8_t>& ram_ref, uint16_t banks);
+    MBC1(std::vector<uint8_t>& rom_ref, paged_ram& ram_ref, uint16_t banks);
 
     uint8_t readROM(uint16_t address) override;
     void writeROM(uint16_t address, uint8_t value) override;
     
     uint8_t readRAM(uint16_t address) override;
     void writeRAM(uint16_t address, uint8_t value) override;
+
+    uint16_t currentRomBank() const override { return romBank; }
+
+    void saveState(state_writer& out) const override;
+    void loadState(state_reader& in) override;
 };
\ No newline at end of file
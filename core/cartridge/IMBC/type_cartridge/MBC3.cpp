@@ -6,7 +6,7 @@
 // ============================================================
 
 MBC3::MBC3(std::vector<uint8_t>& rom_ref,
-           std::vector<uint8_t>& ram_ref,
+           paged_ram&            ram_ref,
            uint16_t              banks)
     : rom(rom_ref)
     , ram(ram_ref)
@@ -22,8 +22,24 @@ MBC3::MBC3(std::vector<uint8_t>& rom_ref,
         latchedRtcRegisters[i] = 0;
     }
 
-    std::cout << "[MBC3] Inicializado. ROM banks: " << std::dec
-              << totalRomBanks << " | RAM: " << ram.size() << " bytes\n";
+    updateBanks();
+}
+
+// ============================================================
+//  Bancos publicados (se recalculan solo al escribir registros)
+// ============================================================
+
+void MBC3::updateBanks()
+{
+    banks.rom0 = (rom.size() >= 0x4000) ? rom.data() : nullptr;
+
+    uint32_t base = static_cast<uint32_t>(currentRomBank()) * 0x4000u;
+    banks.romx = (base + 0x4000u <= rom.size()) ? rom.data() + base : nullptr;
+
+    // RTC seleccionado o banco fuera de rango → readRAM/writeRAM
+    uint32_t ram_base = static_cast<uint32_t>(ramRtcSelect) * 0x2000u;
+    bool ram_direct = ramEnabled && ramRtcSelect <= 0x03 && ram_base + 0x2000u <= ram.size();
+    banks.ram = ram_direct ? static_cast<int32_t>(ram_base) : -1;
 }
 
 // ============================================================
@@ -41,10 +57,7 @@ uint8_t MBC3::readROM(uint16_t address)
     // Banco conmutable: 0x4000 - 0x7FFF
     if (address >= 0x4000 && address <= 0x7FFF)
     {
-        // Máscara correcta: necesita manejar cuando totalRomBanks es potencia de 2
-        // Para Pokémon Rojo: 128 bancos → máscara 0x7F
-        uint8_t  bank   = romBank & (totalRomBanks - 1);
-        if (bank == 0) bank = 1; // MBC3 nunca mapea banco 0 en área conmutable
+        uint8_t  bank   = static_cast<uint8_t>(currentRomBank());
 
         uint32_t offset = static_cast<uint32_t>(address - 0x4000)
                         + static_cast<uint32_t>(bank) * 0x4000u;
@@ -62,6 +75,15 @@ uint8_t MBC3::readROM(uint16_t address)
     return 0xFF;
 }
 
+uint16_t MBC3::currentRomBank() const
+{
+    // Máscara correcta: necesita manejar cuando totalRomBanks es potencia de 2
+    // Para Pokémon Rojo: 128 bancos → máscara 0x7F
+    uint8_t bank = romBank & (totalRomBanks - 1);
+    if (bank == 0) bank = 1; // MBC3 nunca mapea banco 0 en área conmutable
+    return bank;
+}
+
 // ============================================================
 //  Escritura ROM (registros de control del MBC)
 // ============================================================
@@ -72,6 +94,7 @@ void MBC3::writeROM(uint16_t address, uint8_t value)
     if (address <= 0x1FFF)
     {
         ramEnabled = ((value & 0x0F) == 0x0A);
+        updateBanks();
         return;
     }
 
@@ -80,6 +103,7 @@ void MBC3::writeROM(uint16_t address, uint8_t value)
     {
         romBank = value & 0x7F;
         if (romBank == 0) romBank = 1; // El banco 0 no se puede seleccionar aquí
+        updateBanks();
         return;
     }
 
@@ -87,6 +111,7 @@ void MBC3::writeROM(uint16_t address, uint8_t value)
     if (address <= 0x5FFF)
     {
         ramRtcSelect = value;
+        updateBanks();
         return;
     }
 
@@ -129,7 +154,7 @@ uint8_t MBC3::readRAM(uint16_t address)
                       << " ram.size()=0x" << ram.size() << std::dec << "\n";
             return 0xFF;
         }
-        return ram[offset];
+        return ram.read(offset);
     }
 
     // Registros RTC latched: 0x08 (segundos) → 0x0C (DH)
@@ -163,7 +188,7 @@ void MBC3::writeRAM(uint16_t address, uint8_t value)
                       << std::dec << "\n";
             return;
         }
-        ram[offset] = value;
+        ram.write(offset, value);
         return;
     }
 
@@ -197,4 +222,30 @@ void MBC3::updateRTC()
     // Nota: DH también tiene bit 6 (halt) y bit 7 (day counter carry).
     // Preservamos los bits que el juego puede haber escrito previamente:
     rtcRegisters[4] |= (rtcRegisters[4] & 0xFE); // conserva halt/carry si se setearon
-}
\ No newline at end of file
+}
+// ============================================================
+//  Save state
+// ============================================================
+// El RTC se guarda tal cual: updateRTC lo vuelve a tomar del reloj
+// del host en el próximo latch.
+
+void MBC3::saveState(state_writer& out) const
+{
+    out.put(romBank);
+    out.put(ramRtcSelect);
+    out.put(ramEnabled);
+    out.put(rtcRegisters);
+    out.put(latchedRtcRegisters);
+    out.put(latchValue);
+}
+
+void MBC3::loadState(state_reader& in)
+{
+    in.get(romBank);
+    in.get(ramRtcSelect);
+    in.get(ramEnabled);
+    in.get(rtcRegisters);
+    in.get(latchedRtcRegisters);
+    in.get(latchValue);
+    updateBanks();
+}
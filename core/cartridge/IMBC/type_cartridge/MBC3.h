@@ -8,7 +8,7 @@ class MBC3 : public IMBC
 {
 public:
     MBC3(std::vector<uint8_t>& rom_ref,
-         std::vector<uint8_t>& ram_ref,
+         paged_ram&            ram_ref,
          uint16_t              banks);
 
     uint8_t readROM(uint16_t address) override;
@@ -16,9 +16,14 @@ public:
     uint8_t readRAM(uint16_t address) override;
     void    writeRAM(uint16_t address, uint8_t value) override;
 
+    uint16_t currentRomBank() const override;
+
+    void saveState(state_writer& out) const override;
+    void loadState(state_reader& in) override;
+
 private:
     std::vector<uint8_t>& rom;
-    std::vector<uint8_t>& ram;
+    paged_ram& ram;
 
     uint16_t totalRomBanks;
     uint8_t  romBank;         // Banco activo (1-127)
@@ -31,4 +36,5 @@ private:
     uint8_t  latchValue;             // Último valor escrito en 0x6000-0x7FFF
 
     void updateRTC();
+    void updateBanks(); // Recalcula banks tras escribir un registro
 };
\ No newline at end of file
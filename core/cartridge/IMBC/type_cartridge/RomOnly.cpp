@@ -1,7 +1,12 @@
 #include "RomOnly.h"
 
 // Constructor: Guardamos la referencia a la ROM
-RomOnly::RomOnly(std::vector<uint8_t>& rom_ref) : rom(rom_ref) {}
+RomOnly::RomOnly(std::vector<uint8_t>& rom_ref) : rom(rom_ref)
+{
+    // Sin bancos: los punteros se fijan una sola vez
+    if (rom.size() >= 0x4000) banks.rom0 = rom.data();
+    if (rom.size() >= 0x8000) banks.romx = rom.data() + 0x4000;
+}
 
 uint8_t RomOnly::readROM(uint16_t address) {
     if (address < rom.size())
@@ -14,4 +14,6 @@ public:
     
     uint8_t readRAM(uint16_t address) override;
     void writeRAM(uint16_t address, uint8_t value) override;
+
+    uint16_t currentRomBank() const override { return 1; }
 };
\ No newline at end of file
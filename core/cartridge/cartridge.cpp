@@ -2,6 +2,7 @@
 #include "IMBC/type_cartridge/RomOnly.h"
 #include "IMBC/type_cartridge/MBC1.h"
 #include "IMBC/type_cartridge/MBC3.h"
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 
@@ -15,6 +16,18 @@ cartridge::cartridge(const std::string& path)
         parseHeader();
 }
 
+cartridge::cartridge(const cartridge& parent, Fork)
+    : ROM(parent.ROM)
+    , RAM(parent.RAM)
+    , Title(parent.Title)
+    , cartridge_type(parent.cartridge_type)
+    , ROM_type(parent.ROM_type)
+    , RAM_type(parent.RAM_type)
+    , rom_banks_count(parent.rom_banks_count)
+{
+    if (parent.mbc) createMBC(false);   // Sin banner: un fork por nodo de búsqueda
+}
+
 cartridge::~cartridge() = default;
 
 // ============================================================
@@ -37,13 +50,13 @@ bool cartridge::loadRom(const std::string& path)
         return false;
     }
 
-    ROM.resize(static_cast<size_t>(size));
+    ROM->resize(static_cast<size_t>(size));
     rom.seekg(0, std::ios::beg);
 
-    if (!rom.read(reinterpret_cast<char*>(ROM.data()), size))
+    if (!rom.read(reinterpret_cast<char*>(ROM->data()), size))
     {
         std::cerr << "[Cartridge] ERROR: Fallo al leer el archivo.\n";
-        ROM.clear();
+        ROM->clear();
         return false;
     }
 
@@ -55,15 +68,23 @@ bool cartridge::loadRom(const std::string& path)
 //  Lectura / Escritura pública
 // ============================================================
 
+// Los accesos usan los bancos publicados por el MBC; el método virtual
+// solo se llama cuando no hay puntero directo (RTC, RAM deshabilitada,
+// banco fuera de rango).
 uint8_t cartridge::readCartridge(uint16_t address)
 {
     if (!mbc) return 0xFF;
 
+    const BankMap& banks = mbc->bankMap();
+
+    if (address <= 0x3FFF)
+        return banks.rom0 ? banks.rom0[address] : mbc->readROM(address);
+
     if (address <= 0x7FFF)
-        return mbc->readROM(address);
+        return banks.romx ? banks.romx[address - 0x4000] : mbc->readROM(address);
 
     if (address >= 0xA000 && address <= 0xBFFF)
-        return mbc->readRAM(address);
+        return banks.ram >= 0 ? RAM.read(banks.ram + (address - 0xA000)) : mbc->readRAM(address);
 
     return 0xFF;
 }
@@ -75,7 +96,55 @@ void cartridge::writeCartridge(uint16_t address, uint8_t value)
     if (address <= 0x7FFF)
         mbc->writeROM(address, value);
     else if (address >= 0xA000 && address <= 0xBFFF)
-        mbc->writeRAM(address, value);
+    {
+        int32_t ram = mbc->bankMap().ram;
+        if (ram >= 0) RAM.write(ram + (address - 0xA000), value);
+        else          mbc->writeRAM(address, value);
+    }
+}
+
+// ============================================================
+//  Save state
+// ============================================================
+
+void cartridge::saveState(state_writer& out, bool with_ram) const
+{
+    out.put(static_cast<uint32_t>(RAM.size()));
+    if (with_ram) RAM.saveState(out);
+    if (mbc) mbc->saveState(out);
+}
+
+bool cartridge::loadState(state_reader& in, bool with_ram)
+{
+    uint32_t ram_size = 0;
+    if (!in.get(ram_size) || ram_size != RAM.size())
+    {
+        std::cerr << "[Cartridge] Save state con otro tamaño de RAM externa.\n";
+        return false;
+    }
+    if (with_ram && !RAM.loadState(in)) return false;
+    if (mbc) mbc->loadState(in);
+    return in.ok();
+}
+
+// Título (0x0134-0x0143) y checksum global (0x014E-0x014F, big-endian)
+void cartridge::stampState(state_header& header) const
+{
+    std::fill(std::begin(header.title), std::end(header.title), 0);
+    header.checksum = 0;
+    const std::vector<uint8_t>& rom = *ROM;
+    if (rom.size() < 0x0150) return;
+
+    std::copy(rom.begin() + 0x0134, rom.begin() + 0x0144, header.title);
+    header.checksum = static_cast<uint16_t>((rom[0x014E] << 8) | rom[0x014F]);
+}
+
+bool cartridge::matchesState(const state_header& header) const
+{
+    state_header own{};
+    stampState(own);
+    return std::equal(std::begin(own.title), std::end(own.title), header.title)
+        && own.checksum == header.checksum;
 }
 
 // ============================================================
@@ -84,7 +153,7 @@ void cartridge::writeCartridge(uint16_t address, uint8_t value)
 
 bool cartridge::verifyChecksum()
 {
-    if (ROM.size() < 0x014E)
+    if (ROM->size() < 0x014E)
     {
         std::cerr << "[Cartridge] ROM demasiado pequeña para checksum.\n";
         return false;
@@ -92,12 +161,12 @@ bool cartridge::verifyChecksum()
 
     uint8_t x = 0;
     for (uint16_t i = 0x0134; i <= 0x014C; ++i)
-        x = x - ROM[i] - 1;
+        x = x - (*ROM)[i] - 1;
 
-    bool ok = (x == ROM[0x014D]);
+    bool ok = (x == (*ROM)[0x014D]);
     if (!ok)
         std::cerr << "[Cartridge] Checksum FALLO. Calc: "
-                  << (int)x << " Leído: " << (int)ROM[0x014D] << "\n";
+                  << (int)x << " Leído: " << (int)(*ROM)[0x014D] << "\n";
     return ok;
 }
 
@@ -107,15 +176,15 @@ void cartridge::Get_Title()
     // 0x0134-0x0143: título en ASCII (bytes nulos terminan el string)
     for (uint16_t i = 0x0134; i <= 0x0143; ++i)
     {
-        if (ROM[i] == 0) break;
-        Title += static_cast<char>(ROM[i]);
+        if ((*ROM)[i] == 0) break;
+        Title += static_cast<char>((*ROM)[i]);
     }
     std::cout << "[Cartridge] Título: " << Title << "\n";
 }
 
 void cartridge::setCartridgeType()
 {
-    cartridge_type = ROM[0x0147];
+    cartridge_type = (*ROM)[0x0147];
 }
 
 uint16_t cartridge::resolveRomBanks(uint8_t rom_byte)
@@ -158,30 +227,32 @@ void cartridge::resolveRamSize(uint8_t ram_byte)
 
     if (size > 0)
     {
-        RAM.assign(size, 0xFF);  // ← IMPORTANTE: inicializar a 0xFF, no a 0x00
+        RAM = paged_ram(size);
+        RAM.fill(0xFF);          // ← IMPORTANTE: inicializar a 0xFF, no a 0x00
         std::cout << "[Cartridge] RAM: " << size << " bytes inicializada.\n";
     }
 }
 
-void cartridge::createMBC()
+void cartridge::createMBC(bool verbose)
 {
-    std::cout << "[Cartridge] Tipo MBC: 0x" << std::hex << (int)cartridge_type
-              << std::dec << " | ROM banks: " << rom_banks_count << "\n";
+    if (verbose)
+        std::cout << "[Cartridge] Tipo MBC: 0x" << std::hex << (int)cartridge_type
+                  << std::dec << " | ROM banks: " << rom_banks_count << "\n";
 
     switch (cartridge_type)
     {
         // ---- ROM Only ----
         case 0x00:
-            mbc = std::make_unique<RomOnly>(ROM);
-            std::cout << "[Cartridge] MBC: RomOnly\n";
+            mbc = std::make_unique<RomOnly>(*ROM);
+            if (verbose) std::cout << "[Cartridge] MBC: RomOnly\n";
             break;
 
         // ---- MBC1 ----
         case 0x01:  // MBC1
         case 0x02:  // MBC1 + RAM
         case 0x03:  // MBC1 + RAM + BATTERY
-            mbc = std::make_unique<MBC1>(ROM, RAM, rom_banks_count);
-            std::cout << "[Cartridge] MBC: MBC1\n";
+            mbc = std::make_unique<MBC1>(*ROM, RAM, rom_banks_count);
+            if (verbose) std::cout << "[Cartridge] MBC: MBC1\n";
             break;
 
         // ---- MBC3 ----
@@ -190,22 +261,26 @@ void cartridge::createMBC()
         case 0x11:  // MBC3
         case 0x12:  // MBC3 + RAM
         case 0x13:  // MBC3 + RAM + BATTERY  ← Pokémon Rojo
-            mbc = std::make_unique<MBC3>(ROM, RAM, rom_banks_count);
-            std::cout << "[Cartridge] MBC: MBC3\n";
+            mbc = std::make_unique<MBC3>(*ROM, RAM, rom_banks_count);
+            if (verbose) {
+                std::cout << "[MBC3] Inicializado. ROM banks: " << std::dec
+                          << rom_banks_count << " | RAM: " << RAM.size() << " bytes\n";
+                std::cout << "[Cartridge] MBC: MBC3\n";
+            }
             break;
 
         default:
             std::cerr << "[Cartridge] Tipo MBC no implementado: 0x"
                       << std::hex << (int)cartridge_type << std::dec
                       << " → usando RomOnly como fallback.\n";
-            mbc = std::make_unique<RomOnly>(ROM);
+            mbc = std::make_unique<RomOnly>(*ROM);
             break;
     }
 }
 
 void cartridge::parseHeader()
 {
-    if (ROM.size() < 0x0150)
+    if (ROM->size() < 0x0150)
     {
         std::cerr << "[Cartridge] ROM demasiado pequeña para tener header válido.\n";
         return;
@@ -215,10 +290,10 @@ void cartridge::parseHeader()
     Get_Title();
     setCartridgeType();
 
-    ROM_type        = ROM[0x0148];
+    ROM_type        = (*ROM)[0x0148];
     rom_banks_count = resolveRomBanks(ROM_type);
 
-    RAM_type        = ROM[0x0149];
+    RAM_type        = (*ROM)[0x0149];
     resolveRamSize(RAM_type);   // ← RAM se dimensiona ANTES de crear el MBC
 
     createMBC();                // ← MBC recibe referencias ya válidas
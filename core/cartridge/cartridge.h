@@ -9,19 +9,44 @@ class cartridge
 {
 public:
     explicit cartridge(const std::string& path);
+    cartridge() = default;   // Sin ROM (MMU en modo RAM plana)
     ~cartridge();
 
+    // Copia para gameboy::fork: comparte la ROM y las páginas de la RAM
+    // externa (copy-on-write). Los registros del MBC llegan después con
+    // el save state del padre.
+    struct Fork {};
+    cartridge(const cartridge& parent, Fork);
+
     uint8_t  readCartridge(uint16_t address);
     void     writeCartridge(uint16_t address, uint8_t value);
 
+    uint16_t currentRomBank() const { return mbc ? mbc->currentRomBank() : 1; }
+    uint16_t romBankCount()   const { return static_cast<uint16_t>((ROM->size() + 0x3FFF) / 0x4000); }
+
+    // Bancos mapeados ahora mismo (tabla de páginas del MMU)
+    BankMap bankMap() const { return mbc ? mbc->bankMap() : BankMap{}; }
+
+    // RAM externa en páginas (la tabla de páginas del MMU apunta a ellas)
+    paged_ram&       externalRam()       { return RAM; }
+    const paged_ram& externalRam() const { return RAM; }
+
+    // Save state: RAM externa y registros del MBC. stampState/matchesState
+    // escriben y comprueban la identidad de la ROM en la cabecera.
+    // Sin 'with_ram' solo se guarda el tamaño de la RAM (gameboy::fork).
+    void saveState(state_writer& out, bool with_ram) const;
+    bool loadState(state_reader& in, bool with_ram);
+    void stampState(state_header& header) const;
+    bool matchesState(const state_header& header) const;
+
     const std::string& getTitle()         const { return Title; }
     uint8_t            getCartridgeType() const { return cartridge_type; }
-    bool               isLoaded()         const { return !ROM.empty() && mbc != nullptr; }
+    bool               isLoaded()         const { return !ROM->empty() && mbc != nullptr; }
 
 private:
-    // ROM y RAM crudas
-    std::vector<uint8_t> ROM;
-    std::vector<uint8_t> RAM;
+    // ROM (de solo lectura, compartida entre máquinas hermanas) y RAM
+    std::shared_ptr<std::vector<uint8_t>> ROM = std::make_shared<std::vector<uint8_t>>();
+    paged_ram                             RAM;
 
     // MBC polimórfico
     std::unique_ptr<IMBC> mbc;
@@ -41,5 +66,5 @@ private:
     void setCartridgeType();
     uint16_t resolveRomBanks(uint8_t rom_byte);
     void     resolveRamSize(uint8_t ram_byte);
-    void     createMBC();
+    void     createMBC(bool verbose = true);   // verbose = false en los forks
 };
\ No newline at end of file
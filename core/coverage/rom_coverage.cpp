@@ -0,0 +1,115 @@
+#include "rom_coverage.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// --- Constructor ---
+rom_coverage::rom_coverage(uint16_t bank_count)
+    : banks(bank_count ? bank_count : 1)
+{
+    for (auto& set : bits) set.assign(banks * (BANK_SIZE / 64), 0);
+}
+
+void rom_coverage::clear()
+{
+    for (auto& set : bits) std::fill(set.begin(), set.end(), 0);
+}
+
+uint32_t rom_coverage::covered(Kind kind, uint16_t bank) const
+{
+    uint32_t count = 0;
+    size_t first = static_cast<size_t>(bank) * (BANK_SIZE / 64);
+    for (size_t i = first; i < first + BANK_SIZE / 64; i++)
+        count += static_cast<uint32_t>(__builtin_popcountll(bits[kind][i]));
+    return count;
+}
+
+// Bytes de un bitset de banco en el orden del archivo (LE dentro de cada palabra)
+static std::vector<uint8_t> bankBytes(const std::vector<uint64_t>& set, uint16_t bank)
+{
+    std::vector<uint8_t> bytes(rom_coverage::BANK_SIZE / 8);
+    size_t first = static_cast<size_t>(bank) * (rom_coverage::BANK_SIZE / 64);
+    for (size_t j = 0; j < bytes.size(); j++)
+        bytes[j] = static_cast<uint8_t>(set[first + j / 8] >> (8 * (j % 8)));
+    return bytes;
+}
+
+// ============================================================
+// EXPORTACIÓN
+// ============================================================
+bool rom_coverage::write(const std::string& path) const
+{
+    bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    return json ? writeJson(path) : writeBinary(path);
+}
+
+bool rom_coverage::writeBinary(const std::string& path) const
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "[Coverage] ERROR: no se pudo escribir " << path << "\n";
+        return false;
+    }
+
+    out.write("GBCOV001", 8);
+    uint8_t count[4] = {
+        static_cast<uint8_t>(banks), static_cast<uint8_t>(banks >> 8), 0, 0
+    };
+    out.write(reinterpret_cast<const char*>(count), 4);
+
+    for (uint16_t bank = 0; bank < banks; bank++) {
+        for (const auto& set : bits) {
+            std::vector<uint8_t> bytes = bankBytes(set, bank);
+            out.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+        }
+    }
+    return static_cast<bool>(out);
+}
+
+static std::string base64(const std::vector<uint8_t>& data)
+{
+    static const char table[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string text;
+    text.reserve((data.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < data.size(); i += 3) {
+        uint32_t chunk = data[i] << 16;
+        if (i + 1 < data.size()) chunk |= data[i + 1] << 8;
+        if (i + 2 < data.size()) chunk |= data[i + 2];
+
+        text += table[(chunk >> 18) & 63];
+        text += table[(chunk >> 12) & 63];
+        text += (i + 1 < data.size()) ? table[(chunk >> 6) & 63] : '=';
+        text += (i + 2 < data.size()) ? table[chunk & 63] : '=';
+    }
+    return text;
+}
+
+//   {"bank_size":16384,"banks":[
+//     {"bank":0,"opcode":1234,"operand":567,"data":89,
+//      "opcode_bits":"<base64>","operand_bits":"...","data_bits":"..."},
+//   ...]}
+bool rom_coverage::writeJson(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Coverage] ERROR: no se pudo escribir " << path << "\n";
+        return false;
+    }
+
+    static const char* const names[KindCount] = { "opcode", "operand", "data" };
+
+    out << "{\"bank_size\":" << BANK_SIZE << ",\"banks\":[";
+    for (uint16_t bank = 0; bank < banks; bank++) {
+        out << (bank ? ",\n" : "\n") << "  {\"bank\":" << bank;
+        for (int kind = 0; kind < KindCount; kind++)
+            out << ",\"" << names[kind] << "\":" << covered(static_cast<Kind>(kind), bank);
+        for (int kind = 0; kind < KindCount; kind++)
+            out << ",\"" << names[kind] << "_bits\":\"" << base64(bankBytes(bits[kind], bank)) << "\"";
+        out << "}";
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================
+// ROM_COVERAGE - Qué bytes de la ROM se ejecutaron o se leyeron
+// ============================================================
+// Tres bitsets por banco de 16 KB:
+//
+//   Opcode   byte leído como opcode (cpu::fetch o la caché de bloques)
+//   Operand  byte leído como inmediato (readImmediateByte)
+//   Data     byte leído como dato por cualquier otra lectura del bus
+//            (LD A,(HL), POP, DMA...)
+//
+// Solo existe con la opción CMake GB_COVERAGE=ON (define GB_COVERAGE):
+// sin ella el MMU y la CPU no tienen ni el miembro ni las llamadas.
+//
+// Exporta a binario compacto o JSON (según la extensión):
+//
+//   binario  "GBCOV001", uint32 bancos (LE) y por banco los bitsets
+//            Opcode, Operand y Data (2048 bytes cada uno, bit i del
+//            byte j = dirección j*8+i del banco)
+//   JSON     bytes cubiertos por banco y tipo, y los bitsets en base64
+// ============================================================
+
+class rom_coverage
+{
+public:
+    enum Kind : uint8_t {
+        Opcode,
+        Operand,
+        Data,
+        KindCount
+    };
+
+    static constexpr uint32_t BANK_SIZE = 0x4000;
+
+    explicit rom_coverage(uint16_t bank_count);
+
+    // 'address' en 0x0000-0x7FFF; 'bank' es el banco mapeado en 0x4000
+    void mark(Kind kind, uint16_t address, uint16_t bank)
+    {
+        if (!enabled) return;
+        uint32_t offset = (address < BANK_SIZE)
+                        ? address
+                        : (bank % banks) * BANK_SIZE + (address - BANK_SIZE);
+        bits[kind][offset >> 6] |= 1ULL << (offset & 63);
+    }
+
+    void clear();
+
+    // false = mark no hace nada (frames ocultos del run-ahead)
+    void setEnabled(bool on) { enabled = on; }
+
+    uint16_t bankCount() const { return banks; }
+    uint32_t covered(Kind kind, uint16_t bank) const;   // Bytes marcados en el banco
+
+    bool write(const std::string& path) const;
+
+private:
+    uint16_t banks;
+    bool     enabled = true;
+    std::vector<uint64_t> bits[KindCount];   // Toda la ROM, banco tras banco
+
+    bool writeBinary(const std::string& path) const;
+    bool writeJson(const std::string& path) const;
+};
@@ -3,11 +3,53 @@
 #include <algorithm>
 #include <cmath>
 
+#include "state/state_io.h"
+#include "trace/timeline.h"
+
 // ============================================================================
 // Divisor table for noise channel
 // ============================================================================
 static const int NOISE_DIVISORS[8] = { 8, 16, 32, 48, 64, 80, 96, 112 };
 
+// ============================================================================
+// Band-limited step kernel
+// ============================================================================
+// BLIP_PHASES windowed-sinc impulses, one per sub-sample offset. Adding
+// an impulse to the delta buffer and integrating gives a step whose
+// spectrum stops short of Nyquist, so square edges no longer alias.
+// The step is centred BLIP_TAPS/2 samples late (fixed output latency).
+
+struct BlipKernel {
+    float taps[BLIP_PHASES][BLIP_TAPS];
+
+    BlipKernel() {
+        const double pi = 3.14159265358979323846;
+        const double cutoff = 0.45;          // Fraction of the host sample rate
+        const double half = BLIP_TAPS / 2;
+
+        for (int phase = 0; phase < BLIP_PHASES; phase++) {
+            double offset = (double)phase / BLIP_PHASES;
+            double sum = 0.0;
+            double kernel[BLIP_TAPS];
+
+            for (int i = 0; i < BLIP_TAPS; i++) {
+                double x = i - half - offset + 1.0;
+                double sinc = (x == 0.0) ? 1.0 : std::sin(2.0 * pi * cutoff * x) / (2.0 * pi * cutoff * x);
+                double window = 0.42 + 0.5 * std::cos(pi * x / half) + 0.08 * std::cos(2.0 * pi * x / half);
+                kernel[i] = sinc * window;
+                sum += kernel[i];
+            }
+
+            // Each impulse sums to 1 so the integrated step settles exactly
+            for (int i = 0; i < BLIP_TAPS; i++) {
+                taps[phase][i] = (float)(kernel[i] / sum);
+            }
+        }
+    }
+};
+
+static const BlipKernel BLIP_KERNEL;
+
 // ============================================================================
 // Square Channel 1 Implementation (with Sweep)
 // ============================================================================
@@ -67,15 +109,6 @@ void SquareChannel1::trigger() {
     }
 }
 
-void SquareChannel1::tickFrequency() {
-    if (--frequencyTimer <= 0) {
-        // Reload timer
-        frequencyTimer = (2048 - frequency) * 4;
-        // Advance waveform position
-        waveformPosition = (waveformPosition + 1) & 7;
-    }
-}
-
 void SquareChannel1::tickLength() {
     if (lengthEnabled && lengthCounter > 0) {
         if (--lengthCounter == 0) {
@@ -182,13 +215,6 @@ void SquareChannel2::trigger() {
     envelopeTimer = envelopePace;
 }
 
-void SquareChannel2::tickFrequency() {
-    if (--frequencyTimer <= 0) {
-        frequencyTimer = (2048 - frequency) * 4;
-        waveformPosition = (waveformPosition + 1) & 7;
-    }
-}
-
 void SquareChannel2::tickLength() {
     if (lengthEnabled && lengthCounter > 0) {
         if (--lengthCounter == 0) {
@@ -255,21 +281,17 @@ void WaveChannel::trigger() {
     waveformPosition = 0;
 }
 
-void WaveChannel::tickFrequency() {
-    if (--frequencyTimer <= 0) {
-        frequencyTimer = (2048 - frequency) * 2;
-        
-        // Advance position (0-31)
-        waveformPosition = (waveformPosition + 1) & 31;
-        
-        // Read sample from wave RAM
-        // Each byte contains 2 samples (high nibble first, then low nibble)
-        uint8_t byteIndex = waveformPosition / 2;
-        if (waveformPosition & 1) {
-            sampleBuffer = waveRAM[byteIndex] & 0x0F;
-        } else {
-            sampleBuffer = (waveRAM[byteIndex] >> 4) & 0x0F;
-        }
+void WaveChannel::skip(int steps) {
+    // Advance position (0-31)
+    waveformPosition = (waveformPosition + steps) & 31;
+    
+    // Read sample from wave RAM
+    // Each byte contains 2 samples (high nibble first, then low nibble)
+    uint8_t byteIndex = waveformPosition / 2;
+    if (waveformPosition & 1) {
+        sampleBuffer = waveRAM[byteIndex] & 0x0F;
+    } else {
+        sampleBuffer = (waveRAM[byteIndex] >> 4) & 0x0F;
     }
 }
 
@@ -338,25 +360,21 @@ void NoiseChannel::trigger() {
     frequencyTimer = divisor << clockShift;
 }
 
-void NoiseChannel::tickFrequency() {
-    if (--frequencyTimer <= 0) {
-        frequencyTimer = divisor << clockShift;
-        
-        // LFSR clock tick
-        // XOR bits 0 and 1
-        uint8_t xorResult = (lfsr & 0x01) ^ ((lfsr >> 1) & 0x01);
-        
-        // Shift LFSR right by 1
-        lfsr >>= 1;
-        
-        // Put XOR result in bit 14 (high bit of 15-bit LFSR)
-        lfsr |= (xorResult << 14);
-        
-        // If width mode (7-bit), also put in bit 6
-        if (widthMode) {
-            lfsr &= ~(1 << 6);
-            lfsr |= (xorResult << 6);
-        }
+void NoiseChannel::step() {
+    // LFSR clock tick
+    // XOR bits 0 and 1
+    uint8_t xorResult = (lfsr & 0x01) ^ ((lfsr >> 1) & 0x01);
+    
+    // Shift LFSR right by 1
+    lfsr >>= 1;
+    
+    // Put XOR result in bit 14 (high bit of 15-bit LFSR)
+    lfsr |= (xorResult << 14);
+    
+    // If width mode (7-bit), also put in bit 6
+    if (widthMode) {
+        lfsr &= ~(1 << 6);
+        lfsr |= (xorResult << 6);
     }
 }
 
@@ -416,15 +434,16 @@ void APU::reset() {
     frameSequencerTimer = 0;
     frameSequencerStep = 0;
     
-    sampleTimer = 0;
-    sampleAccumulator = 0.0f;
-    sampleCount = 0;
+    // Reset band-limited synthesis
+    setSampleRate(hostSampleRate);
+    std::memset(blipDeltas, 0, sizeof(blipDeltas));
+    blipOffset = 0;
+    blipIntegrator = 0.0f;
+    for (int i = 0; i < 4; i++) channelLevel[i] = 0.0f;
+    updateMixWeights();
     
-    // Reset audio filters
-    lastLeftSample = 0.0f;
-    lastRightSample = 0.0f;
-    highPassLeft = 0.0f;
-    highPassRight = 0.0f;
+    // Reset audio filter
+    highPass = 0.0f;
     
     bufferWritePos = 0;
     bufferReadPos = 0;
@@ -437,39 +456,285 @@ void APU::reset() {
 
 void APU::setSampleRate(int rate) {
     hostSampleRate = rate;
-    cyclesPerSample = CPU_CLOCK / rate;
+    
+    // Host samples per CPU cycle, 32.32 fixed point
+    blipFactor = ((uint64_t)rate << 32) / CPU_CLOCK;
+    
+    // Keep every chunk well inside blipDeltas (half of it, kernel included)
+    blipMaxCycles = (int)(((uint64_t)(BLIP_BUFFER_SIZE / 2) * CPU_CLOCK) / rate);
+}
+
+// ============================================================================
+// Save State
+// ============================================================================
+void SquareChannel1::saveState(state_writer& out) const {
+    out.put(NR10);
+    out.put(NR11);
+    out.put(NR12);
+    out.put(NR13);
+    out.put(NR14);
+    out.put(enabled);
+    out.put(dacEnabled);
+    out.put(frequency);
+    out.put(frequencyTimer);
+    out.put(waveformPosition);
+    out.put(lengthCounter);
+    out.put(lengthEnabled);
+    out.put(volume);
+    out.put(envelopeTimer);
+    out.put(envelopePace);
+    out.put(envelopeIncrease);
+    out.put(sweepTimer);
+    out.put(sweepPace);
+    out.put(sweepStep);
+    out.put(sweepDecrease);
+    out.put(sweepEnabled);
+    out.put(shadowFrequency);
+}
+
+void SquareChannel1::loadState(state_reader& in) {
+    in.get(NR10);
+    in.get(NR11);
+    in.get(NR12);
+    in.get(NR13);
+    in.get(NR14);
+    in.get(enabled);
+    in.get(dacEnabled);
+    in.get(frequency);
+    in.get(frequencyTimer);
+    in.get(waveformPosition);
+    in.get(lengthCounter);
+    in.get(lengthEnabled);
+    in.get(volume);
+    in.get(envelopeTimer);
+    in.get(envelopePace);
+    in.get(envelopeIncrease);
+    in.get(sweepTimer);
+    in.get(sweepPace);
+    in.get(sweepStep);
+    in.get(sweepDecrease);
+    in.get(sweepEnabled);
+    in.get(shadowFrequency);
+}
+
+void SquareChannel2::saveState(state_writer& out) const {
+    out.put(NR21);
+    out.put(NR22);
+    out.put(NR23);
+    out.put(NR24);
+    out.put(enabled);
+    out.put(dacEnabled);
+    out.put(frequency);
+    out.put(frequencyTimer);
+    out.put(waveformPosition);
+    out.put(lengthCounter);
+    out.put(lengthEnabled);
+    out.put(volume);
+    out.put(envelopeTimer);
+    out.put(envelopePace);
+    out.put(envelopeIncrease);
+}
+
+void SquareChannel2::loadState(state_reader& in) {
+    in.get(NR21);
+    in.get(NR22);
+    in.get(NR23);
+    in.get(NR24);
+    in.get(enabled);
+    in.get(dacEnabled);
+    in.get(frequency);
+    in.get(frequencyTimer);
+    in.get(waveformPosition);
+    in.get(lengthCounter);
+    in.get(lengthEnabled);
+    in.get(volume);
+    in.get(envelopeTimer);
+    in.get(envelopePace);
+    in.get(envelopeIncrease);
+}
+
+void WaveChannel::saveState(state_writer& out) const {
+    out.put(NR30);
+    out.put(NR31);
+    out.put(NR32);
+    out.put(NR33);
+    out.put(NR34);
+    out.put(waveRAM);
+    out.put(enabled);
+    out.put(dacEnabled);
+    out.put(frequency);
+    out.put(frequencyTimer);
+    out.put(waveformPosition);
+    out.put(sampleBuffer);
+    out.put(lengthCounter);
+    out.put(lengthEnabled);
+    out.put(volumeShift);
+}
+
+void WaveChannel::loadState(state_reader& in) {
+    in.get(NR30);
+    in.get(NR31);
+    in.get(NR32);
+    in.get(NR33);
+    in.get(NR34);
+    in.get(waveRAM);
+    in.get(enabled);
+    in.get(dacEnabled);
+    in.get(frequency);
+    in.get(frequencyTimer);
+    in.get(waveformPosition);
+    in.get(sampleBuffer);
+    in.get(lengthCounter);
+    in.get(lengthEnabled);
+    in.get(volumeShift);
+}
+
+void NoiseChannel::saveState(state_writer& out) const {
+    out.put(NR41);
+    out.put(NR42);
+    out.put(NR43);
+    out.put(NR44);
+    out.put(enabled);
+    out.put(dacEnabled);
+    out.put(lfsr);
+    out.put(widthMode);
+    out.put(frequencyTimer);
+    out.put(divisor);
+    out.put(clockShift);
+    out.put(lengthCounter);
+    out.put(lengthEnabled);
+    out.put(volume);
+    out.put(envelopeTimer);
+    out.put(envelopePace);
+    out.put(envelopeIncrease);
+}
+
+void NoiseChannel::loadState(state_reader& in) {
+    in.get(NR41);
+    in.get(NR42);
+    in.get(NR43);
+    in.get(NR44);
+    in.get(enabled);
+    in.get(dacEnabled);
+    in.get(lfsr);
+    in.get(widthMode);
+    in.get(frequencyTimer);
+    in.get(divisor);
+    in.get(clockShift);
+    in.get(lengthCounter);
+    in.get(lengthEnabled);
+    in.get(volume);
+    in.get(envelopeTimer);
+    in.get(envelopePace);
+    in.get(envelopeIncrease);
+}
+
+// blipFactor and blipMaxCycles follow the host sample rate, which is a
+// host setting rather than machine state, so they are not saved.
+void APU::saveState(state_writer& out) const {
+    saveSoundState(out);
+    out.put(blipDeltas);
+    out.put(blipOffset);
+    out.put(blipIntegrator);
+    out.put(channelLevel);
+    out.put(channelWeight);
+    out.put(highPass);
+}
+
+void APU::saveSoundState(state_writer& out) const {
+    channel1.saveState(out);
+    channel2.saveState(out);
+    channel3.saveState(out);
+    channel4.saveState(out);
+    out.put(NR50);
+    out.put(NR51);
+    out.put(NR52);
+    out.put(masterEnabled);
+    out.put(frameSequencerTimer);
+    out.put(frameSequencerStep);
+}
+
+bool APU::loadState(state_reader& in) {
+    channel1.loadState(in);
+    channel2.loadState(in);
+    channel3.loadState(in);
+    channel4.loadState(in);
+    in.get(NR50);
+    in.get(NR51);
+    in.get(NR52);
+    in.get(masterEnabled);
+    in.get(frameSequencerTimer);
+    in.get(frameSequencerStep);
+    in.get(blipDeltas);
+    in.get(blipOffset);
+    in.get(blipIntegrator);
+    in.get(channelLevel);
+    in.get(channelWeight);
+    in.get(highPass);
+    return in.ok();
 }
 
 void APU::tick(int cpuCycles) {
     if (!masterEnabled) return;
     
-    for (int i = 0; i < cpuCycles; i++) {
-        // Tick Frame Sequencer
-        frameSequencerTimer++;
+    // Run in chunks that end at the next frame sequencer step, so length,
+    // envelope and sweep changes land at the right time in the output
+    while (cpuCycles > 0) {
+        int chunk = std::min(cpuCycles, CYCLES_PER_FRAME_SEQ - frameSequencerTimer);
+        chunk = std::min(chunk, blipMaxCycles);
+        
+        runChannels(chunk);
+        
+        frameSequencerTimer += chunk;
         if (frameSequencerTimer >= CYCLES_PER_FRAME_SEQ) {
             frameSequencerTimer = 0;
             tickFrameSequencer();
+            refreshLevels(chunk);
         }
         
-        // Tick all channel frequency timers
-        channel1.tickFrequency();
-        channel2.tickFrequency();
-        channel3.tickFrequency();
-        channel4.tickFrequency();
-        
-        // Downsampling: accumulate samples
-        sampleAccumulator += mixChannels();
-        sampleCount++;
-        
-        // Generate host sample when enough cycles have passed
-        sampleTimer++;
-        if (sampleTimer >= cyclesPerSample) {
-            sampleTimer = 0;
-            generateSample();
-        }
+        if (outputEnabled) endChunk(chunk);
+        cpuCycles -= chunk;
     }
 }
 
+void APU::runChannels(int cycles) {
+    runChannel(channel1, 0, cycles);
+    runChannel(channel2, 1, cycles);
+    runChannel(channel3, 2, cycles);
+    runChannel(channel4, 3, cycles);
+}
+
+// Advances one channel by 'cycles', jumping straight from one waveform
+// edge to the next. frequencyTimer holds the cycles left until the next
+// edge (0 behaves like 1, as the old per-cycle countdown did).
+template <typename Channel>
+void APU::runChannel(Channel& channel, int index, int cycles) {
+    int period = channel.period();
+    int next = std::max(channel.frequencyTimer, 1);
+    
+    if (next > cycles) {
+        channel.frequencyTimer = next - cycles;
+        return;
+    }
+    
+    if (channel.silent() || !outputEnabled) {
+        // Output cannot change (or is not heard) before the end of the
+        // chunk: count the edges. With output off the noise LFSR stands
+        // still, which only the output would ever reveal.
+        int steps = 1 + (cycles - next) / period;
+        channel.skip(steps);
+        channel.frequencyTimer = next + steps * period - cycles;
+        return;
+    }
+    
+    while (next <= cycles) {
+        channel.step();
+        setLevel(index, channel.getOutput(), next);
+        next += period;
+    }
+    channel.frequencyTimer = next - cycles;
+}
+
 void APU::tickFrameSequencer() {
     // Frame Sequencer runs at 512 Hz, divided into 8 steps
     // Step 0: Length
@@ -518,68 +783,73 @@ void APU::tickFrameSequencer() {
     frameSequencerStep = (frameSequencerStep + 1) & 7;
 }
 
-float APU::mixChannels() {
-    // Get output from each channel
-    float ch1 = channel1.getOutput();
-    float ch2 = channel2.getOutput();
-    float ch3 = channel3.getOutput();
-    float ch4 = channel4.getOutput();
-    
-    // Apply panning (NR51)
-    float left = 0.0f;
-    float right = 0.0f;
-    
-    // Left channel panning (bits 4-7)
-    if (NR51 & 0x10) left += ch1;
-    if (NR51 & 0x20) left += ch2;
-    if (NR51 & 0x40) left += ch3;
-    if (NR51 & 0x80) left += ch4;
-    
-    // Right channel panning (bits 0-3)
-    if (NR51 & 0x01) right += ch1;
-    if (NR51 & 0x02) right += ch2;
-    if (NR51 & 0x04) right += ch3;
-    if (NR51 & 0x08) right += ch4;
-    
-    // Apply master volume (NR50) - scaled down
-    int leftVol = ((NR50 >> 4) & 0x07) + 1;
-    int rightVol = (NR50 & 0x07) + 1;
-    
-    left *= leftVol / 8.0f;
-    right *= rightVol / 8.0f;
-    
-    // Normalize (4 channels max)
-    left /= 4.0f;
-    right /= 4.0f;
-    
-    // Apply LOW-PASS FILTER to smooth harsh square waves
-    // This emulates the analog filtering of real Game Boy hardware
-    left = lastLeftSample + LP_FACTOR * (left - lastLeftSample);
-    right = lastRightSample + LP_FACTOR * (right - lastRightSample);
-    lastLeftSample = left;
-    lastRightSample = right;
-    
-    // Apply HIGH-PASS FILTER to remove DC offset (prevents speaker "thump")
-    float filteredLeft = left - highPassLeft;
-    highPassLeft = left - filteredLeft * HP_FACTOR;
-    
-    float filteredRight = right - highPassRight;
-    highPassRight = right - filteredRight * HP_FACTOR;
-    
-    // Mix to mono
-    float mixed = (filteredLeft + filteredRight) * 0.5f;
-    
-    // Apply master volume
-    mixed *= masterVolume;
-    
-    return mixed;
+// ============================================================================
+// Mixing and Band-Limited Output
+// ============================================================================
+
+void APU::updateMixWeights() {
+    // NR50 master volume per side (1-8), NR51 panning per channel
+    float leftVol = (((NR50 >> 4) & 0x07) + 1) / 8.0f;
+    float rightVol = ((NR50 & 0x07) + 1) / 8.0f;
+    
+    for (int i = 0; i < 4; i++) {
+        float weight = 0.0f;
+        if (NR51 & (0x10 << i)) weight += leftVol;   // Left (bits 4-7)
+        if (NR51 & (0x01 << i)) weight += rightVol;  // Right (bits 0-3)
+        
+        // Normalize (4 channels max), mix to mono, apply master volume
+        channelWeight[i] = weight / 4.0f * 0.5f * masterVolume;
+    }
 }
 
-void APU::generateSample() {
-    if (sampleCount == 0) return;
+void APU::refreshLevels(int time) {
+    setLevel(0, channel1.getOutput(), time);
+    setLevel(1, channel2.getOutput(), time);
+    setLevel(2, channel3.getOutput(), time);
+    setLevel(3, channel4.getOutput(), time);
+}
+
+void APU::setLevel(int index, float output, int time) {
+    if (!outputEnabled) return;
+    float level = output * channelWeight[index];
+    if (level != channelLevel[index]) {
+        addDelta(time, level - channelLevel[index]);
+        channelLevel[index] = level;
+    }
+}
+
+void APU::addDelta(int time, float delta) {
+    uint64_t pos = blipOffset + (uint64_t)time * blipFactor;
+    int index = (int)(pos >> 32);
+    int phase = (int)(pos >> (32 - BLIP_PHASE_BITS)) & (BLIP_PHASES - 1);
+    
+    const float* kernel = BLIP_KERNEL.taps[phase];
+    float* out = &blipDeltas[index];
+    for (int i = 0; i < BLIP_TAPS; i++) {
+        out[i] += delta * kernel[i];
+    }
+}
+
+void APU::endChunk(int cycles) {
+    blipOffset += (uint64_t)cycles * blipFactor;
+    int count = (int)(blipOffset >> 32);
+    
+    // Samples before the chunk end can no longer receive deltas
+    for (int i = 0; i < count; i++) {
+        blipIntegrator += blipDeltas[i];
+        outputSample(blipIntegrator);
+    }
     
-    // Average the accumulated samples for better quality
-    float sample = sampleAccumulator / sampleCount;
+    // Keep the kernel tails that spill past the emitted samples
+    std::memmove(blipDeltas, blipDeltas + count, BLIP_TAPS * sizeof(float));
+    std::memset(blipDeltas + BLIP_TAPS, 0, count * sizeof(float));
+    blipOffset -= (uint64_t)count << 32;
+}
+
+void APU::outputSample(float amplitude) {
+    // Apply HIGH-PASS FILTER to remove DC offset (prevents speaker "thump")
+    float sample = amplitude - highPass;
+    highPass = amplitude - sample * HP_FACTOR;
     
     // Soft clipping using tanh - sounds much better than hard clipping
     // This prevents harsh digital distortion when audio is too loud
@@ -591,10 +861,6 @@ void APU::generateSample() {
     sample = std::max(-1.0f, std::min(1.0f, sample));
     
     pushSample(sample);
-    
-    // Reset accumulator
-    sampleAccumulator = 0.0f;
-    sampleCount = 0;
 }
 
 void APU::pushSample(float sample) {
@@ -607,6 +873,7 @@ void APU::pushSample(float sample) {
     audioBuffer[bufferWritePos] = sample;
     bufferWritePos = (bufferWritePos + 1) % AUDIO_BUFFER_SIZE;
     samplesAvailable++;
+    samplesProduced++;
 }
 
 // ============================================================================
@@ -636,6 +903,12 @@ int APU::fillOutputBuffer(int maxSamples) {
     }
     
     int toCopy = (samplesAvailable < maxSamples) ? samplesAvailable : maxSamples;
+    if (toCopy < maxSamples) underruns++;
+
+    if (trace_timeline) {
+        trace_timeline->hostInstant(timeline::Audio, toCopy < maxSamples ? "underrun" : "refill",
+                                    "samples", static_cast<uint32_t>(toCopy));
+    }
     
     for (int i = 0; i < toCopy; i++) {
         outputBuffer[i] = audioBuffer[bufferReadPos];
@@ -851,9 +1124,11 @@ void APU::writeByte(uint16_t address, uint8_t value) {
         // Control registers (NR50-NR52)
         case 0xFF24:
             NR50 = value;
+            updateMixWeights();
             break;
         case 0xFF25:
             NR51 = value;
+            updateMixWeights();
             break;
         case 0xFF26:
             NR52 = value;
@@ -866,6 +1141,7 @@ void APU::writeByte(uint16_t address, uint8_t value) {
                 channel4.reset();
                 NR50 = 0;
                 NR51 = 0;
+                updateMixWeights();
             }
             break;
         
@@ -877,6 +1153,10 @@ void APU::writeByte(uint16_t address, uint8_t value) {
             writeWaveRAM(address, value);
             break;
     }
+    
+    // Register writes land between tick() calls: any level change
+    // (trigger, DAC off, duty, panning...) starts at the current chunk
+    refreshLevels(0);
 }
 
 uint8_t APU::readWaveRAM(uint16_t address) {
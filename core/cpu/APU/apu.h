@@ -1,13 +1,23 @@
 #ifndef APU_H
 #define APU_H
 
+#include <algorithm>
 #include <cstdint>
 
+class timeline;
+class state_writer;
+class state_reader;
+
 // ============================================================================
 // Game Boy APU (Audio Processing Unit) - DMG-01
 // ============================================================================
 // Generates audio for all 4 sound channels without external libraries.
 // Outputs float samples (-1.0 to 1.0) into a ring buffer for Web Audio API.
+//
+// Channels are not ticked per T-cycle: tick() jumps each channel from one
+// waveform edge to the next, and every change in a channel's output level
+// is written as a band-limited step (blip buffer) at its exact position
+// between host samples. Silent channels skip their edges in closed form.
 // ============================================================================
 
 // Constants
@@ -20,6 +30,12 @@ constexpr int CYCLES_PER_SAMPLE = CPU_CLOCK / HOST_SAMPLE_RATE;  // ~95 cycles
 constexpr int CYCLES_PER_FRAME_SEQ = CPU_CLOCK / FRAME_SEQUENCER_RATE; // 8192 cycles
 constexpr int SAMPLES_PER_FRAME = 44100 / 60; // ~735 samples per frame at 60 FPS
 
+// Band-limited step synthesis (blip buffer)
+constexpr int BLIP_TAPS = 16;                // Kernel width in host samples
+constexpr int BLIP_PHASE_BITS = 6;
+constexpr int BLIP_PHASES = 1 << BLIP_PHASE_BITS; // Sub-sample positions
+constexpr int BLIP_BUFFER_SIZE = 1024;       // Host samples per tick chunk (max)
+
 // Wave duty cycle patterns (12.5%, 25%, 50%, 75%)
 constexpr uint8_t DUTY_PATTERNS[4] = {
     0b00000001,  // 12.5% duty
@@ -68,12 +84,21 @@ struct SquareChannel1 {
     
     void reset();
     void trigger();
-    void tickFrequency();
     void tickLength();
     void tickEnvelope();
     void tickSweep();
     uint16_t calculateSweepFrequency();
     float getOutput() const;
+
+    // Save state, field by field (the struct has padding between members)
+    void saveState(state_writer& out) const;
+    void loadState(state_reader& in);
+
+    // Waveform timer (see APU::runChannel)
+    int period() const { return (2048 - frequency) * 4; }
+    void step() { waveformPosition = (waveformPosition + 1) & 7; }
+    void skip(int steps) { waveformPosition = (waveformPosition + steps) & 7; }
+    bool silent() const { return !enabled || !dacEnabled || volume == 0; }
 };
 
 // ============================================================================
@@ -107,10 +132,16 @@ struct SquareChannel2 {
     
     void reset();
     void trigger();
-    void tickFrequency();
     void tickLength();
     void tickEnvelope();
     float getOutput() const;
+    void saveState(state_writer& out) const;
+    void loadState(state_reader& in);
+
+    int period() const { return (2048 - frequency) * 4; }
+    void step() { waveformPosition = (waveformPosition + 1) & 7; }
+    void skip(int steps) { waveformPosition = (waveformPosition + steps) & 7; }
+    bool silent() const { return !enabled || !dacEnabled || volume == 0; }
 };
 
 // ============================================================================
@@ -146,9 +177,15 @@ struct WaveChannel {
     
     void reset();
     void trigger();
-    void tickFrequency();
     void tickLength();
     float getOutput() const;
+    void saveState(state_writer& out) const;
+    void loadState(state_reader& in);
+
+    int period() const { return (2048 - frequency) * 2; }
+    void step() { skip(1); }
+    void skip(int steps);   // Advances position and reloads sampleBuffer
+    bool silent() const { return !enabled || !dacEnabled || volumeShift == 0; }
 };
 
 // ============================================================================
@@ -186,10 +223,18 @@ struct NoiseChannel {
     
     void reset();
     void trigger();
-    void tickFrequency();
     void tickLength();
     void tickEnvelope();
     float getOutput() const;
+    void saveState(state_writer& out) const;
+    void loadState(state_reader& in);
+
+    // The LFSR has no closed form, so only a disabled channel (which
+    // trigger() will reseed anyway) skips its clocks.
+    int period() const { return std::max(divisor << clockShift, 1); }
+    void step();
+    void skip(int) {}
+    bool silent() const { return !enabled || !dacEnabled; }
 };
 
 // ============================================================================
@@ -221,6 +266,28 @@ public:
     void setSampleRate(int rate);
     int getHostSampleRate() const { return hostSampleRate; }
 
+    // Save state: channels, registers, frame sequencer and the pending
+    // blip deltas. Host-side buffers (ring and output) are left alone so
+    // a load does not drop audio that is already queued for playback.
+    void saveState(state_writer& out) const;
+    bool loadState(state_reader& in);
+
+    // The hardware part of saveState only (channels, registers, frame
+    // sequencer), without the output synthesis: what gameboy::stateHash
+    // covers, so two equal machines hash equal whatever they played
+    void saveSoundState(state_writer& out) const;
+
+    // Optional timeline: output buffer refills go to its host audio track
+    void setTimeline(timeline* tl) { trace_timeline = tl; }
+
+    // false = channels keep running (length, envelope, sweep, NR52) but
+    // no samples are synthesized (hidden run-ahead frames)
+    bool outputEnabled = true;
+
+    // Telemetry since the last read (gb_perf_stats)
+    uint32_t samplesProduced = 0;   // Host samples pushed to the ring buffer
+    uint32_t underruns = 0;         // fillOutputBuffer calls that came up short
+
 private:
     // Audio channels
     SquareChannel1 channel1;
@@ -239,23 +306,25 @@ private:
     int frameSequencerTimer = 0;
     int frameSequencerStep = 0;  // 0-7 steps
     
-    // Downsampling for host sample rate
-    int sampleTimer = 0;
-    int cyclesPerSample = CYCLES_PER_SAMPLE;
     int hostSampleRate = HOST_SAMPLE_RATE;
     
-    // Sample accumulator for better downsampling
-    float sampleAccumulator = 0.0f;
-    int sampleCount = 0;
+    // Blip buffer: output level deltas, integrated into host samples.
+    // Positions are in host samples, 32.32 fixed point.
+    float blipDeltas[BLIP_BUFFER_SIZE + BLIP_TAPS] = {0};
+    uint64_t blipFactor = 0;       // Host samples per CPU cycle
+    uint64_t blipOffset = 0;       // Position of cycle 0 of the current chunk
+    int blipMaxCycles = 0;         // Longest chunk that fits in blipDeltas
+    float blipIntegrator = 0.0f;   // Running sum of the deltas = mixed amplitude
     
-    // Audio filters for smoother output
-    float lastLeftSample = 0.0f;   // For low-pass filter
-    float lastRightSample = 0.0f;
-    float highPassLeft = 0.0f;     // For DC offset removal (high-pass)
-    float highPassRight = 0.0f;
+    // Last level written per channel and its weight in the mono mix
+    // (panning, NR50 volume and master volume folded together)
+    float channelLevel[4] = {0};
+    float channelWeight[4] = {0};
+    
+    // Audio filter for smoother output
+    float highPass = 0.0f;         // For DC offset removal (high-pass)
     float masterVolume = 0.25f;    // Master volume (0.0 - 1.0) - lower to avoid clipping
-    static constexpr float LP_FACTOR = 0.65f;   // Low-pass filter strength (0-1, higher = more filtering)
-    static constexpr float HP_FACTOR = 0.999f;  // High-pass filter (removes DC offset)
+    static constexpr float HP_FACTOR = 0.996f;  // High-pass filter per host sample (~28 Hz at 44.1 kHz)
     
     // Ring buffer for audio output (internal)
     float audioBuffer[AUDIO_BUFFER_SIZE] = {0};
@@ -266,12 +335,22 @@ private:
     // Linear output buffer for JS (external reads)
     float outputBuffer[OUTPUT_BUFFER_SIZE] = {0};
     int outputSamplesReady = 0;
+
+    timeline* trace_timeline = nullptr;
     
     // Internal methods
     void tickFrameSequencer();
-    void tickChannels(int cycles);
-    void generateSample();
-    float mixChannels();
+    void runChannels(int cycles);
+    template <typename Channel>
+    void runChannel(Channel& channel, int index, int cycles);
+    
+    // Mixing and band-limited output
+    void updateMixWeights();
+    void refreshLevels(int time);
+    void setLevel(int index, float output, int time);
+    void addDelta(int time, float delta);
+    void endChunk(int cycles);
+    void outputSample(float amplitude);
     void pushSample(float sample);
     
     // Wave RAM access helpers
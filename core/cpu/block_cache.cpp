@@ -0,0 +1,200 @@
+#include "block_cache.h"
+#include "cpu.h"
+
+// ============================================================
+// TABLAS DEL SM83
+// ============================================================
+// Longitud de cada opcode en bytes (incluye el opcode). Los opcodes
+// ilegales cuentan como 1 byte, igual que en cpu::ILLEGAL.
+const uint8_t block_cache::OPCODE_LENGTH[256] = {
+//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+    1, 3, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1, 1, 1, 2, 1, // 0x00
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 0x10
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 0x20
+    2, 3, 1, 1, 1, 1, 2, 1, 2, 1, 1, 1, 1, 1, 2, 1, // 0x30
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x40
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x50
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x60
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x70
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x80
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0x90
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xA0
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, // 0xB0
+    1, 1, 3, 3, 3, 1, 2, 1, 1, 1, 3, 2, 3, 3, 2, 1, // 0xC0
+    1, 1, 3, 1, 3, 1, 2, 1, 1, 1, 3, 1, 3, 1, 2, 1, // 0xD0
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1, // 0xE0
+    2, 1, 1, 1, 1, 1, 2, 1, 2, 1, 3, 1, 1, 1, 2, 1, // 0xF0
+};
+
+// Ciclos base (T-cycles) con la rama NO tomada. 0xCB se completa con
+// el segundo byte en decode().
+const uint8_t block_cache::OPCODE_CYCLES[256] = {
+//  0   1   2   3   4   5   6   7   8   9   A   B   C   D   E   F
+    4, 12,  8,  8,  4,  4,  8,  4, 20,  8,  8,  8,  4,  4,  8,  4, // 0x00
+    4, 12,  8,  8,  4,  4,  8,  4, 12,  8,  8,  8,  4,  4,  8,  4, // 0x10
+    8, 12,  8,  8,  4,  4,  8,  4,  8,  8,  8,  8,  4,  4,  8,  4, // 0x20
+    8, 12,  8,  8, 12, 12, 12,  4,  8,  8,  8,  8,  4,  4,  8,  4, // 0x30
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0x40
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0x50
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0x60
+    8,  8,  8,  8,  8,  8,  4,  8,  4,  4,  4,  4,  4,  4,  8,  4, // 0x70
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0x80
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0x90
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0xA0
+    4,  4,  4,  4,  4,  4,  8,  4,  4,  4,  4,  4,  4,  4,  8,  4, // 0xB0
+    8, 12, 12, 16, 12, 16,  8, 16,  8, 16, 12,  0, 12, 24,  8, 16, // 0xC0
+    8, 12, 12,  4, 12, 16,  8, 16,  8, 16, 12,  4, 12,  4,  8, 16, // 0xD0
+   12, 12,  8,  4,  4, 16,  8, 16, 16,  4, 16,  4,  4,  4,  8, 16, // 0xE0
+   12, 12,  8,  4,  4, 16,  8, 16, 12,  8, 16,  4,  4,  4,  8, 16, // 0xF0
+};
+
+// ¿Esta instrucción cambia el flujo de control (o detiene la CPU)?
+bool block_cache::endsBlock(uint8_t opcode)
+{
+    switch (opcode) {
+        case 0x10: case 0x76:                               // STOP, HALT
+        case 0x18: case 0x20: case 0x28: case 0x30: case 0x38: // JR
+        case 0xC3: case 0xC2: case 0xCA: case 0xD2: case 0xDA: // JP
+        case 0xE9:                                          // JP HL
+        case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC: // CALL
+        case 0xC9: case 0xD9:                               // RET, RETI
+        case 0xC0: case 0xC8: case 0xD0: case 0xD8:         // RET cc
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:         // RST
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+        // Ilegales: la CPU real se cuelga, aquí se ejecutan como NOP con log
+        case 0xD3: case 0xDB: case 0xDD: case 0xE3: case 0xE4:
+        case 0xEB: case 0xEC: case 0xED: case 0xF4: case 0xFC: case 0xFD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// ============================================================
+// REGIONES CACHEABLES
+// ============================================================
+// Devuelve el final (inclusive) de la región de 'pc', o 0 si no se cachea.
+// Un bloque nunca cruza el final de su región.
+static uint16_t regionEnd(uint16_t pc)
+{
+    if (pc <= 0x3FFF)                  return 0x3FFF; // ROM banco 0
+    if (pc <= 0x7FFF)                  return 0x7FFF; // ROM banco N
+    if (pc >= 0xC000 && pc <= 0xDFFF)  return 0xDFFF; // WRAM
+    if (pc >= 0xE000 && pc <= 0xFDFF)  return 0xFDFF; // ECHO
+    if (pc >= 0xFF80 && pc <= 0xFFFE)  return 0xFFFE; // HRAM
+    return 0;
+}
+
+bool block_cache::isCacheable(uint16_t pc)
+{
+    return regionEnd(pc) != 0;
+}
+
+// ============================================================
+// LOOKUP
+// ============================================================
+DecodedBlock* block_cache::lookup(uint16_t pc, mmu& memory, const Table& table)
+{
+    if (pc <= 0x3FFF) {
+        DecodedBlock*& slot = rom0[pc];
+        if (!slot) slot = decode(pc, 0, memory, table);
+        return slot;
+    }
+
+    if (pc <= 0x7FFF) {
+        uint16_t bank = memory.currentRomBank();
+        if (bank >= romx.size()) romx.resize(bank + 1);
+        if (!romx[bank]) romx[bank] = std::make_unique<PageMap>();
+
+        DecodedBlock*& slot = (*romx[bank])[pc - 0x4000];
+        if (!slot) slot = decode(pc, bank, memory, table);
+        return slot;
+    }
+
+    if (!isCacheable(pc)) return nullptr;
+
+    DecodedBlock*& slot = ram[pc - 0x8000];
+    if (!slot) slot = decode(pc, 0, memory, table);
+    return slot;
+}
+
+// ============================================================
+// DECODE
+// ============================================================
+DecodedBlock* block_cache::decode(uint16_t pc, uint16_t bank, mmu& memory, const Table& table)
+{
+    const uint16_t end   = regionEnd(pc);
+    const bool     inRam = (pc >= 0x8000);
+
+    auto block = std::make_unique<DecodedBlock>();
+    block->start_pc = pc;
+    block->bank     = bank;
+    block->cycles   = 0;
+
+    uint32_t addr = pc;
+    while ((int)block->ops.size() < MAX_BLOCK_OPS)
+    {
+        uint8_t opcode = memory.peek(static_cast<uint16_t>(addr));
+        uint8_t length = OPCODE_LENGTH[opcode];
+
+        // La instrucción completa debe caber en la región
+        if (addr + length - 1 > end) break;
+
+        DecodedOp op;
+        op.handler    = table[opcode];
+        op.opcode     = opcode;
+        op.length     = length;
+        op.operand[0] = (length > 1) ? memory.peek(static_cast<uint16_t>(addr + 1)) : 0;
+        op.operand[1] = (length > 2) ? memory.peek(static_cast<uint16_t>(addr + 2)) : 0;
+        op.cycles     = OPCODE_CYCLES[opcode];
+
+        if (opcode == 0xCB) {
+            bool hl  = (op.operand[0] & 0x07) == 6;
+            bool bit = (op.operand[0] >> 6) == 1;
+            op.cycles = hl ? (bit ? 12 : 16) : 8;
+        }
+
+        if (inRam) {
+            for (int i = 0; i < length; i++)
+                memory.markCode(static_cast<uint16_t>(addr + i));
+        }
+
+        block->ops.push_back(op);
+        block->cycles += op.cycles;
+        addr += length;
+
+        if (endsBlock(opcode)) break;
+    }
+
+    // Ni una instrucción entera cabe (cruza el final de la región)
+    if (block->ops.empty()) return nullptr;
+
+    block->end_pc = static_cast<uint16_t>(addr);
+
+    DecodedBlock* raw = block.get();
+    if (inRam) ram_blocks.push_back(std::move(block));
+    else       rom_blocks.push_back(std::move(block));
+    return raw;
+}
+
+// ============================================================
+// INVALIDACIÓN
+// ============================================================
+void block_cache::flushRam()
+{
+    for (auto& block : ram_blocks)
+        ram[block->start_pc - 0x8000] = nullptr;
+    ram_blocks.clear();
+}
+
+void block_cache::flushAll()
+{
+    flushRam();
+
+    // Igual que flushRam: solo las entradas de los bloques existentes
+    for (auto& block : rom_blocks) {
+        if (block->start_pc <= 0x3FFF) rom0[block->start_pc] = nullptr;
+        else (*romx[block->bank])[block->start_pc - 0x4000] = nullptr;
+    }
+    rom_blocks.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ============================================================
+// BLOCK_CACHE - Caché de bloques decodificados (cached interpreter)
+// ============================================================
+// Un bloque es una secuencia de instrucciones que empieza en un PC y
+// termina en la primera instrucción de control de flujo (JP/JR/CALL/
+// RET/RST/HALT/STOP). Cada instrucción guarda su handler ya resuelto,
+// sus bytes inmediatos y sus ciclos base, así la CPU no vuelve a leer
+// el opcode ni los operandos de memoria en cada pasada por un loop.
+//
+// Claves:
+//   0x0000-0x3FFF  ROM banco 0           → por PC
+//   0x4000-0x7FFF  ROM banco conmutable  → por (banco activo, PC)
+//   0xC000-0xFDFF  WRAM (+echo)          → por PC, invalidable
+//   0xFF80-0xFFFE  HRAM                  → por PC, invalidable
+// El resto (VRAM, RAM externa, OAM, I/O) no se cachea.
+// ============================================================
+
+class cpu;
+class mmu;
+
+struct DecodedOp
+{
+    int     (cpu::*handler)(uint8_t); // Handler de table_opcode
+    uint8_t opcode;
+    uint8_t length;                   // 1-3 bytes
+    uint8_t operand[2];               // Bytes inmediatos (d8/d16/a16/r8/CB)
+    uint8_t cycles;                   // Ciclos base (rama no tomada)
+};
+
+struct DecodedBlock
+{
+    // Código nativo generado por el JIT: devuelve los T-cycles ejecutados
+    using NativeBlock = int (*)(cpu*);
+
+    uint16_t start_pc;
+    uint16_t end_pc;                  // PC después de la última instrucción
+    uint16_t bank;                    // Banco ROM (0 fuera de 0x4000-0x7FFF)
+    uint32_t cycles;                  // Suma de ciclos base del bloque
+    std::vector<DecodedOp> ops;
+
+    // --- JIT (solo Engine::Jit) ---
+    uint32_t    exec_count = 0;       // Entradas al bloque antes de compilarlo
+    NativeBlock native = nullptr;
+    bool        jit_failed = false;   // No volver a intentar compilarlo
+};
+
+class block_cache
+{
+public:
+    using Table = std::array<int (cpu::*)(uint8_t), 256>;
+
+    static constexpr int MAX_BLOCK_OPS = 64;
+
+    // Devuelve el bloque que empieza en 'pc' (decodificándolo si hace
+    // falta) o nullptr si la región no es cacheable.
+    DecodedBlock* lookup(uint16_t pc, mmu& memory, const Table& table);
+
+    // Descarta los bloques de WRAM/HRAM (código automodificable)
+    void flushRam();
+
+    // Descarta todo (p. ej. al cambiar de ROM)
+    void flushAll();
+
+    static bool isCacheable(uint16_t pc);
+
+    // Tablas estándar del SM83 (longitud en bytes y ciclos base)
+    static const uint8_t OPCODE_LENGTH[256];
+    static const uint8_t OPCODE_CYCLES[256];
+    static bool endsBlock(uint8_t opcode);
+
+private:
+    using PageMap = std::array<DecodedBlock*, 0x4000>;
+
+    PageMap rom0{};                                // 0x0000-0x3FFF
+    std::vector<std::unique_ptr<PageMap>> romx;    // Un mapa por banco
+    std::array<DecodedBlock*, 0x8000> ram{};       // 0x8000-0xFFFF
+
+    std::vector<std::unique_ptr<DecodedBlock>> rom_blocks;
+    std::vector<std::unique_ptr<DecodedBlock>> ram_blocks;
+
+    DecodedBlock* decode(uint16_t pc, uint16_t bank, mmu& memory, const Table& table);
+};
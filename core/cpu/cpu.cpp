@@ -1,13 +1,8 @@
 #include "cpu.h"
-#include <iomanip>
-
-// Debug simple de interrupciones en CPU (desactivado para producción)
-static bool cpu_irq_debug_enabled = false;
-
-// DEBUG: Rastrear opcodes ejecutados
-static int opcode_counts[256] = {0};
-static int total_instructions = 0;
-static int last_dump_instructions = 0;
+#include "profiler/profiler.h"
+#include "profiler/opcode_profile.h"
+#include "trace/timeline.h"
+#include "trace/trace.h"
 
 // --- Constructor ---
 cpu::cpu(mmu& mmu_ref) : memory(mmu_ref) 
@@ -22,6 +17,18 @@ cpu::cpu(mmu& mmu_ref) : memory(mmu_ref)
     SP = 0xFFFE;
     r8.fill(0);
 
+#if defined(GB_CPU_ENGINE_TABLE)
+    engine = Engine::Table;
+#elif defined(GB_CPU_ENGINE_CACHED)
+    engine = Engine::Switch;
+    setEngine(Engine::BlockCache);
+#elif defined(GB_CPU_ENGINE_JIT)
+    engine = Engine::Switch;
+    setEngine(Engine::Jit);
+#else
+    engine = Engine::Switch;
+#endif
+
     // 2. Inicialización de la tabla (Limpiar todo a nullptr)
     table_opcode.fill(nullptr);
 
@@ -381,32 +388,15 @@ void cpu::requestInterrupt(int bit) {
 }
 
 int cpu::executeInterrupt(int bit) {
-    // DEBUG: Ver si las interrupciones se sirven
-    static int irq_served_count = 0;
-    irq_served_count++;
-    if (irq_served_count <= 20) {
-        std::cout << "[IRQ SERVICED #" << irq_served_count << "] bit=" << bit
-                  << " PC_before=0x" << std::hex << PC
-                  << " vector=0x" << (0x0040 + (bit * 8))
-                  << " IME_was=" << (IME ? 1 : 0) << std::dec << "\n";
-    }
+    GB_TRACE_EVENT(Irq, "serviced", { trace::dec("bit", bit), trace::hex("pc", PC),
+                                      trace::hex("vector", 0x0040 + bit * 8) });
     
     // 1. Deshabilitar IME inmediatamente es CRUCIAL
     IME = false;
     IME_scheduled = false; // Por seguridad, cancelamos cualquier EI pendiente
 
     // 2. Limpiar el bit en IF ANTES de saltar
-    uint8_t if_before = memory.readMemory(0xFF0F);
-    uint8_t if_new = if_before & ~(1 << bit);
-    memory.writeMemory(0xFF0F, if_new);
-    uint8_t if_after = memory.readMemory(0xFF0F);
-    
-    if (cpu_irq_debug_enabled) {
-        std::cout << "[IRQ CLEAR] bit=" << bit 
-                  << " IF_before=0x" << std::hex << (int)if_before
-                  << " IF_new=0x" << (int)if_new
-                  << " IF_after=0x" << (int)if_after << std::dec << "\n";
-    }
+    memory.IO[0x0F] &= ~(1 << bit);
 
     // 3. Guardar el PC actual (donde la CPU debería volver después)
     push(PC);
@@ -419,38 +409,23 @@ int cpu::executeInterrupt(int bit) {
 }
 
 int cpu::handleInterrupts() {
-    uint8_t if_reg = memory.readMemory(0xFF0F);
-    uint8_t ie_reg = memory.readMemory(0xFFFF);
+    // Directo a los registros: esta comprobación es del hardware, no un
+    // acceso de la CPU al bus (no pasa por readSlow ni sus contadores)
+    uint8_t if_reg = memory.IO[0x0F] | 0xE0;
+    uint8_t ie_reg = memory.IE;
 
     // Interrupciones pendientes = Solicitadas (IF) AND Habilitadas (IE)
     uint8_t pending = if_reg & ie_reg & 0x1F; // Solo bits 0-4 son válidos
 
     if (pending > 0) {
-        // DEBUG: Log wake-up from HALT
-        static int wakeup_count = 0;
-        if (isHalted && wakeup_count < 20) {
-            wakeup_count++;
-            std::cout << "[CPU WAKEUP #" << wakeup_count << "] Waking from HALT!"
-                      << " IF=0x" << std::hex << (int)if_reg
-                      << " IE=0x" << (int)ie_reg
-                      << " PENDING=0x" << (int)pending
-                      << " IME=" << std::dec << (IME ? 1 : 0)
-                      << "\n";
-        }
-        
-        if (cpu_irq_debug_enabled) {
-            std::cout << "[CPU IRQ] IF=0x" << std::hex << (int)if_reg
-                      << " IE=0x" << (int)ie_reg
-                      << " PENDING=0x" << (int)pending
-                      << " IME=" << std::dec << (IME ? 1 : 0)
-                      << " HALT=" << (isHalted ? 1 : 0)
-                      << " STOP=" << (isStopped ? 1 : 0)
-                      << " PC=0x" << std::hex << (int)PC << std::dec << "\n";
-        }
+        GB_TRACE_ACCESS(Irq, "pending", { trace::hex("pending", pending), trace::dec("ime", IME),
+                                          trace::hex("pc", PC) });
 
         // IMPORTANTE: Despertar a la CPU si estaba dormida
         // Esto ocurre INCLUSO si IME está deshabilitado
         if (isHalted) {
+            GB_TRACE_EVENT(Cpu, "wakeup", { trace::hex("if", if_reg), trace::hex("ie", ie_reg),
+                                            trace::dec("ime", IME) });
             isHalted = false;
             // HALT bug: Si IME=0 y hay interrupciones pendientes,
             // el PC no se incrementa después de HALT
@@ -468,16 +443,9 @@ int cpu::handleInterrupts() {
             // Prioridad: VBlank (0) > LCD (1) > Timer (2) > Serial (3) > Joypad (4)
             for (int i = 0; i < 5; i++) {
                 if ((pending >> i) & 1) {
-                    if (cpu_irq_debug_enabled) {
-                        std::cout << "[CPU IRQ] Servicing IRQ " << i
-                                  << " vector=0x" << std::hex << (0x40 + i * 8)
-                                  << std::dec << "\n";
-                    }
                     return executeInterrupt(i); // Retorna los ciclos consumidos
                 }
             }
-        } else if (cpu_irq_debug_enabled) {
-            std::cout << "[CPU IRQ] Pending but IME=0, not serviced\n";
         }
     }
     
@@ -494,161 +462,386 @@ void cpu::maskF()
 // --- Ciclo Principal (Step) ---
 int cpu::step()
 {
+    step_instructions = 1;
+
     // 1. PRIMERO: Revisar y servir interrupciones
     int interrupt_cycles = handleInterrupts();
     
     if (interrupt_cycles > 0) {
         // Se sirvió una interrupción, retornar los ciclos consumidos
+        if (prof) prof->onInterrupt(PC, SP, interrupt_cycles);
+        if (trace_timeline) {
+            static const char* const names[] = { "vblank", "stat", "timer", "serial", "joypad" };
+            trace_timeline->instant(timeline::Interrupts, names[(PC - 0x40) >> 3]);
+        }
         return interrupt_cycles;
     }
 
     // 2. Si la CPU está en HALT o STOP, solo consumir ciclos
     if (isHalted || isStopped) {
+        if (prof) prof->onIdle(4);
         return 4; // Consumir 4 ciclos (1 M-cycle) mientras esperamos
     }
 
-    // 3. Fetch (Traer instrucción)
-    uint16_t pc_before = PC;
-    uint8_t opcode = fetch();
-    
-    // ============================================================
-    // DEBUG: EARLY BOOT TRACE - First 100 instructions
-    // ============================================================
-    static int boot_trace_count = 0;
-    boot_trace_count++;
-    if (boot_trace_count <= 100) {
-        std::cout << "[BOOT TRACE #" << std::dec << boot_trace_count 
-                  << "] PC=0x" << std::hex << pc_before
-                  << " OP=0x" << std::setw(2) << std::setfill('0') << (int)opcode;
-        
-        // Decode common opcodes for readability
-        if (opcode == 0x00) std::cout << " (NOP)";
-        else if (opcode == 0xC3) std::cout << " (JP a16)";
-        else if (opcode == 0xAF) std::cout << " (XOR A)";
-        else if (opcode == 0x21) std::cout << " (LD HL,d16)";
-        else if (opcode == 0x31) std::cout << " (LD SP,d16)";
-        else if (opcode == 0xE0) std::cout << " (LDH [a8],A)";
-        else if (opcode == 0x3E) std::cout << " (LD A,d8)";
-        else if (opcode == 0xCD) std::cout << " (CALL a16)";
-        else if (opcode == 0xC9) std::cout << " (RET)";
-        else if (opcode == 0xFB) std::cout << " (EI)";
-        
-        std::cout << std::dec << "\n";
-        
-        // Log key PC values we expect to see
-        if (pc_before == 0x0100) std::cout << "  ^-- Entry point (should see JP)\n";
-        if (pc_before == 0x0150) std::cout << "  ^-- Start: (should see JP to Init)\n";
-        if (pc_before == 0x0211) std::cout << "  ^-- Init: (game initialization begins!)\n";
+#ifdef GB_ENABLE_JIT
+    // 2b. Bloque nativo (si PC está en un bloque de ROM ya compilado)
+    if (engine == Engine::Jit && !prof && !opcodes) {
+        int jit_cycles = runJit();
+        if (jit_cycles > 0) return jit_cycles;
+        step_instructions = 1;   // Side exit en el primer op: va por el intérprete
     }
+#endif
+
+    // 3. Fetch (Traer instrucción). Con opcode_profile, algunas se cronometran
+    //    desde aquí: fetch + dispatch + handler
+    const bool sample_host = opcodes && opcodes->sampleHost();
+    const uint64_t host_start = sample_host ? opcode_profile::hostTicks() : 0;
+    uint16_t pc_before = PC;
+    uint16_t sp_before = SP;
+    const bool use_cache = (engine == Engine::BlockCache || engine == Engine::Jit);
+    const DecodedOp* cached_op = use_cache ? fetchCached() : nullptr;
+    uint8_t opcode = cached_op ? cached_op->opcode : fetch();
+#ifdef GB_COVERAGE
+    if (cached_op && pc_before < 0x8000)
+        memory.romCoverage().mark(rom_coverage::Opcode, pc_before, memory.currentRomBank());
+#endif
     
-    // DEBUG: Trace when game EXITS the polling loop at 0x2F0
-    // JR Z at 0x2F0 doesn't jump when Z=0 (A != 0), so next PC would be 0x2F2
-    static int loop_exit_count = 0;
-    static uint16_t last_pc = 0;
-    if (last_pc == 0x2F0 && pc_before != 0x2ED) {
-        // We just executed JR Z but didn't jump back - we exited the loop!
-        loop_exit_count++;
-        if (loop_exit_count <= 50 || loop_exit_count % 1000 == 0) {
-            std::cout << "[LOOP EXIT #" << loop_exit_count << "] Exited to PC=0x" << std::hex << pc_before
-                      << " OP=0x" << (int)opcode << " A=0x" << (int)r8[A] 
-                      << " FF85=" << (int)memory.HRAM[0x05] << std::dec << "\n";
-        }
+    GB_TRACE_ACCESS(Cpu, "exec", { trace::hex("pc", pc_before), trace::hex("op", opcode) });
+
+    // 4. Decode & Execute
+    int cycles;
+    if (cached_op) {
+        // Handler ya resuelto al decodificar; los inmediatos salen de imm_cursor
+        cycles = cached_op->handler ? (this->*cached_op->handler)(opcode)
+                                    : ILLEGAL(opcode);
+        imm_cursor = nullptr;
+    } else {
+        cycles = (engine == Engine::Switch) ? executeSwitch(opcode)
+                                            : executeTable(opcode);
     }
-    last_pc = pc_before;
-    
-    // DEBUG: Trace stuck loop at PC=0x2ED-0x2F2
-    static int stuck_loop_trace = 0;
-    if (pc_before >= 0x2ED && pc_before <= 0x2F2) {
-        stuck_loop_trace++;
-        if (stuck_loop_trace <= 20 || stuck_loop_trace % 500000 == 0) {
-            std::cout << "[LOOP TRACE #" << stuck_loop_trace << "] PC=0x" << std::hex << pc_before
-                      << " OP=0x" << (int)opcode
-                      << " A=0x" << (int)r8[A]
-                      << " Z=" << (int)getZ()
-                      << " FF44=" << (int)memory.IO[0x44]
-                      << " FF85=" << (int)memory.HRAM[0x05]
-                      << std::dec << "\n";
-        }
+
+    if (opcodes) {
+        int slot = (opcode == 0xCB) ? 0x100 | cb_opcode : opcode;
+        if (sample_host) opcodes->recordHost(slot, opcode_profile::hostTicks() - host_start);
+        opcodes->record(slot, cycles);
     }
     
-    // DEBUG: Contar opcodes y detectar loops
-    opcode_counts[opcode]++;
-    total_instructions++;
-    
-    // Log periódico cada ~1 millón de instrucciones
-    if (total_instructions - last_dump_instructions >= 1000000) {
-        last_dump_instructions = total_instructions;
-        std::cout << "\n[CPU DEBUG] After " << total_instructions << " instructions:\n";
-        std::cout << "  HALT(0x76) executed: " << opcode_counts[0x76] << " times\n";
-        std::cout << "  Current PC=0x" << std::hex << pc_before << std::dec << "\n";
-        std::cout << "  IME=" << (IME ? 1 : 0) << " isHalted=" << (isHalted ? 1 : 0) << "\n";
-        std::cout << "  IF=0x" << std::hex << (int)memory.IO[0x0F]
-                  << " IE=0x" << (int)memory.readMemory(0xFFFF) << std::dec << "\n";
-        
-        // Mostrar los 5 opcodes más ejecutados
-        int top5[5] = {0, 0, 0, 0, 0};
-        for (int i = 0; i < 256; i++) {
-            for (int j = 0; j < 5; j++) {
-                if (opcode_counts[i] > opcode_counts[top5[j]]) {
-                    for (int k = 4; k > j; k--) top5[k] = top5[k-1];
-                    top5[j] = i;
-                    break;
-                }
-            }
-        }
-        std::cout << "  Top opcodes: ";
-        for (int j = 0; j < 5; j++) {
-            std::cout << "0x" << std::hex << top5[j] << "(" << std::dec << opcode_counts[top5[j]] << ") ";
-        }
-        std::cout << "\n";
+    // 5. DESPUÉS de ejecutar la instrucción: Activar IME si estaba programado
+    // EI habilita interrupciones DESPUÉS de la siguiente instrucción
+    if (IME_scheduled) {
+        IME = true;
+        IME_scheduled = false;
+        GB_TRACE_ACCESS(Irq, "ime_enabled", { trace::hex("pc", pc_before) });
     }
 
-    // DEBUG: Imprimir estado de CPU antes de ejecutar
-    uint8_t if_reg = memory.readMemory(0xFF0F);
-    uint8_t ie_reg = memory.readMemory(0xFFFF);
-    // std::cout << "[CPU] PC=0x" << std::hex << pc_before 
-    //           << " OP=0x" << (int)opcode
-    //           << " IME=" << std::dec << (IME ? 1 : 0)
-    //           << " IME_sched=" << (IME_scheduled ? 1 : 0)
-    //           << " IF=0x" << std::hex << (int)if_reg
-    //           << " IE=0x" << (int)ie_reg
-    //           << " A=" << (int)r8[A] << " F=" << (int)r8[F]
-    //           << " SP=0x" << SP << std::dec << "\n";
-
-    // 4. Decode & Execute
-    int cycles = 4;
+    if (prof) prof->onInstruction(pc_before, opcode, cycles, sp_before, PC, SP);
     
+    return cycles;
+}
+
+bool cpu::sleeping() const
+{
+    if (!isHalted && !isStopped) return false;
+    return (memory.IO[0x0F] & memory.IE & 0x1F) == 0;
+}
+
+// ============================================================
+// DISPATCH: TABLA (original)
+// ============================================================
+int cpu::executeTable(uint8_t opcode)
+{
     if (table_opcode[opcode] != nullptr)
     {
-        cycles = (this->*table_opcode[opcode])(opcode);
-    } 
-    else
-    {
-        std::cout << "Opcode no implementado: 0x" << std::hex << (int)opcode 
-                  << " at PC=0x" << (PC-1) << "\n";
-        cycles = 4; // Retornar al menos 4 ciclos para evitar loops infinitos
+        return (this->*table_opcode[opcode])(opcode);
     }
-    
-    // 5. DESPUÉS de ejecutar la instrucción: Activar IME si estaba programado
-    // EI habilita interrupciones DESPUÉS de la siguiente instrucción
+    return ILLEGAL(opcode);
+}
+
+// ============================================================
+// DISPATCH: SWITCH
+// ============================================================
+// Cada case llama al handler con el opcode como constante. Con 'flatten'
+// el compilador inlinea el handler en su case y resuelve en compilación
+// la decodificación de registros/condiciones (opcode >> 3, opcode & 7...),
+// así cada opcode termina con su propio código especializado, sin la
+// llamada indirecta de table_opcode. Los ciclos son los mismos porque
+// se ejecutan exactamente los mismos handlers.
+#if defined(__GNUC__)
+__attribute__((flatten))
+#endif
+int cpu::executeSwitch(uint8_t opcode)
+{
+#define OP(code, handler) case code: return handler(code);
+    switch (opcode) {
+        // 0x00 - 0x0F
+        OP(0x00, NOP)             OP(0x01, LD_r16_d16)      OP(0x02, LD_BC_A)         OP(0x03, INC_r16)
+        OP(0x04, INC_r8)          OP(0x05, DEC_r8)          OP(0x06, LD_r8_d8)        OP(0x07, RLCA)
+        OP(0x08, LD_a16_SP)       OP(0x09, ADD_HL_r16)      OP(0x0A, LD_A_BC)         OP(0x0B, DEC_r16)
+        OP(0x0C, INC_r8)          OP(0x0D, DEC_r8)          OP(0x0E, LD_r8_d8)        OP(0x0F, RRCA)
+        // 0x10 - 0x1F
+        OP(0x10, STOP)            OP(0x11, LD_r16_d16)      OP(0x12, LD_DE_A)         OP(0x13, INC_r16)
+        OP(0x14, INC_r8)          OP(0x15, DEC_r8)          OP(0x16, LD_r8_d8)        OP(0x17, RLA)
+        OP(0x18, JR_d8)           OP(0x19, ADD_HL_r16)      OP(0x1A, LD_A_DE)         OP(0x1B, DEC_r16)
+        OP(0x1C, INC_r8)          OP(0x1D, DEC_r8)          OP(0x1E, LD_r8_d8)        OP(0x1F, RRA)
+        // 0x20 - 0x2F
+        OP(0x20, JR_cc_d8)        OP(0x21, LD_r16_d16)      OP(0x22, LDI_HL_A)        OP(0x23, INC_r16)
+        OP(0x24, INC_r8)          OP(0x25, DEC_r8)          OP(0x26, LD_r8_d8)        OP(0x27, DAA)
+        OP(0x28, JR_cc_d8)        OP(0x29, ADD_HL_r16)      OP(0x2A, LDI_A_HL)        OP(0x2B, DEC_r16)
+        OP(0x2C, INC_r8)          OP(0x2D, DEC_r8)          OP(0x2E, LD_r8_d8)        OP(0x2F, CPL)
+        // 0x30 - 0x3F
+        OP(0x30, JR_cc_d8)        OP(0x31, LD_SP_d16)       OP(0x32, LDD_HL_A)        OP(0x33, INC_r16)
+        OP(0x34, INC_r8)          OP(0x35, DEC_r8)          OP(0x36, LD_r8_d8)        OP(0x37, SCF)
+        OP(0x38, JR_cc_d8)        OP(0x39, ADD_HL_r16)      OP(0x3A, LDD_A_HL)        OP(0x3B, DEC_r16)
+        OP(0x3C, INC_r8)          OP(0x3D, DEC_r8)          OP(0x3E, LD_r8_d8)        OP(0x3F, CCF)
+        // 0x40 - 0x4F
+        OP(0x40, LD_r8_r8)        OP(0x41, LD_r8_r8)        OP(0x42, LD_r8_r8)        OP(0x43, LD_r8_r8)
+        OP(0x44, LD_r8_r8)        OP(0x45, LD_r8_r8)        OP(0x46, LD_r8_r8)        OP(0x47, LD_r8_r8)
+        OP(0x48, LD_r8_r8)        OP(0x49, LD_r8_r8)        OP(0x4A, LD_r8_r8)        OP(0x4B, LD_r8_r8)
+        OP(0x4C, LD_r8_r8)        OP(0x4D, LD_r8_r8)        OP(0x4E, LD_r8_r8)        OP(0x4F, LD_r8_r8)
+        // 0x50 - 0x5F
+        OP(0x50, LD_r8_r8)        OP(0x51, LD_r8_r8)        OP(0x52, LD_r8_r8)        OP(0x53, LD_r8_r8)
+        OP(0x54, LD_r8_r8)        OP(0x55, LD_r8_r8)        OP(0x56, LD_r8_r8)        OP(0x57, LD_r8_r8)
+        OP(0x58, LD_r8_r8)        OP(0x59, LD_r8_r8)        OP(0x5A, LD_r8_r8)        OP(0x5B, LD_r8_r8)
+        OP(0x5C, LD_r8_r8)        OP(0x5D, LD_r8_r8)        OP(0x5E, LD_r8_r8)        OP(0x5F, LD_r8_r8)
+        // 0x60 - 0x6F
+        OP(0x60, LD_r8_r8)        OP(0x61, LD_r8_r8)        OP(0x62, LD_r8_r8)        OP(0x63, LD_r8_r8)
+        OP(0x64, LD_r8_r8)        OP(0x65, LD_r8_r8)        OP(0x66, LD_r8_r8)        OP(0x67, LD_r8_r8)
+        OP(0x68, LD_r8_r8)        OP(0x69, LD_r8_r8)        OP(0x6A, LD_r8_r8)        OP(0x6B, LD_r8_r8)
+        OP(0x6C, LD_r8_r8)        OP(0x6D, LD_r8_r8)        OP(0x6E, LD_r8_r8)        OP(0x6F, LD_r8_r8)
+        // 0x70 - 0x7F
+        OP(0x70, LD_r8_r8)        OP(0x71, LD_r8_r8)        OP(0x72, LD_r8_r8)        OP(0x73, LD_r8_r8)
+        OP(0x74, LD_r8_r8)        OP(0x75, LD_r8_r8)        OP(0x76, HALT)            OP(0x77, LD_r8_r8)
+        OP(0x78, LD_r8_r8)        OP(0x79, LD_r8_r8)        OP(0x7A, LD_r8_r8)        OP(0x7B, LD_r8_r8)
+        OP(0x7C, LD_r8_r8)        OP(0x7D, LD_r8_r8)        OP(0x7E, LD_r8_r8)        OP(0x7F, LD_r8_r8)
+        // 0x80 - 0x8F
+        OP(0x80, ADD_A_r8)        OP(0x81, ADD_A_r8)        OP(0x82, ADD_A_r8)        OP(0x83, ADD_A_r8)
+        OP(0x84, ADD_A_r8)        OP(0x85, ADD_A_r8)        OP(0x86, ADD_A_r8)        OP(0x87, ADD_A_r8)
+        OP(0x88, ADC_A_r8)        OP(0x89, ADC_A_r8)        OP(0x8A, ADC_A_r8)        OP(0x8B, ADC_A_r8)
+        OP(0x8C, ADC_A_r8)        OP(0x8D, ADC_A_r8)        OP(0x8E, ADC_A_r8)        OP(0x8F, ADC_A_r8)
+        // 0x90 - 0x9F
+        OP(0x90, SUB_r8)          OP(0x91, SUB_r8)          OP(0x92, SUB_r8)          OP(0x93, SUB_r8)
+        OP(0x94, SUB_r8)          OP(0x95, SUB_r8)          OP(0x96, SUB_r8)          OP(0x97, SUB_r8)
+        OP(0x98, SBC_A_r8)        OP(0x99, SBC_A_r8)        OP(0x9A, SBC_A_r8)        OP(0x9B, SBC_A_r8)
+        OP(0x9C, SBC_A_r8)        OP(0x9D, SBC_A_r8)        OP(0x9E, SBC_A_r8)        OP(0x9F, SBC_A_r8)
+        // 0xA0 - 0xAF
+        OP(0xA0, AND_r8)          OP(0xA1, AND_r8)          OP(0xA2, AND_r8)          OP(0xA3, AND_r8)
+        OP(0xA4, AND_r8)          OP(0xA5, AND_r8)          OP(0xA6, AND_r8)          OP(0xA7, AND_r8)
+        OP(0xA8, XOR_r8)          OP(0xA9, XOR_r8)          OP(0xAA, XOR_r8)          OP(0xAB, XOR_r8)
+        OP(0xAC, XOR_r8)          OP(0xAD, XOR_r8)          OP(0xAE, XOR_r8)          OP(0xAF, XOR_r8)
+        // 0xB0 - 0xBF
+        OP(0xB0, OR_r8)           OP(0xB1, OR_r8)           OP(0xB2, OR_r8)           OP(0xB3, OR_r8)
+        OP(0xB4, OR_r8)           OP(0xB5, OR_r8)           OP(0xB6, OR_r8)           OP(0xB7, OR_r8)
+        OP(0xB8, CP_r8)           OP(0xB9, CP_r8)           OP(0xBA, CP_r8)           OP(0xBB, CP_r8)
+        OP(0xBC, CP_r8)           OP(0xBD, CP_r8)           OP(0xBE, CP_r8)           OP(0xBF, CP_r8)
+        // 0xC0 - 0xCF
+        OP(0xC0, RET_cc)          OP(0xC1, POP_r16)         OP(0xC2, JP_cc_a16)       OP(0xC3, JP)
+        OP(0xC4, CALL_cc)         OP(0xC5, PUSH_r16)        OP(0xC6, ADD_A_d8)        OP(0xC7, RST)
+        OP(0xC8, RET_cc)          OP(0xC9, RET)             OP(0xCA, JP_cc_a16)       OP(0xCB, PREFIX_CB)
+        OP(0xCC, CALL_cc)         OP(0xCD, CALL)            OP(0xCE, ADC_A_d8)        OP(0xCF, RST)
+        // 0xD0 - 0xDF
+        OP(0xD0, RET_cc)          OP(0xD1, POP_r16)         OP(0xD2, JP_cc_a16)       OP(0xD3, ILLEGAL)
+        OP(0xD4, CALL_cc)         OP(0xD5, PUSH_r16)        OP(0xD6, SUB_A_d8)        OP(0xD7, RST)
+        OP(0xD8, RET_cc)          OP(0xD9, RETI)            OP(0xDA, JP_cc_a16)       OP(0xDB, ILLEGAL)
+        OP(0xDC, CALL_cc)         OP(0xDD, ILLEGAL)         OP(0xDE, SBC_A_d8)        OP(0xDF, RST)
+        // 0xE0 - 0xEF
+        OP(0xE0, LDH_n_A)         OP(0xE1, POP_r16)         OP(0xE2, LD_C_A)          OP(0xE3, ILLEGAL)
+        OP(0xE4, ILLEGAL)         OP(0xE5, PUSH_r16)        OP(0xE6, AND_d8)          OP(0xE7, RST)
+        OP(0xE8, ADD_SP_r8)       OP(0xE9, JP_HL)           OP(0xEA, LD_a16_A)        OP(0xEB, ILLEGAL)
+        OP(0xEC, ILLEGAL)         OP(0xED, ILLEGAL)         OP(0xEE, XOR_d8)          OP(0xEF, RST)
+        // 0xF0 - 0xFF
+        OP(0xF0, LDH_A_n)         OP(0xF1, POP_r16)         OP(0xF2, LD_A_C)          OP(0xF3, DI)
+        OP(0xF4, ILLEGAL)         OP(0xF5, PUSH_r16)        OP(0xF6, OR_d8)           OP(0xF7, RST)
+        OP(0xF8, LD_HL_SP_r8)     OP(0xF9, LD_SP_HL)        OP(0xFA, LD_A_a16)        OP(0xFB, EI)
+        OP(0xFC, ILLEGAL)         OP(0xFD, ILLEGAL)         OP(0xFE, CP_d8)           OP(0xFF, RST)
+    }
+#undef OP
+    return ILLEGAL(opcode);
+}
+
+// ============================================================
+// DISPATCH: CACHÉ DE BLOQUES
+// ============================================================
+void cpu::setEngine(Engine e)
+{
+    engine = e;
+    cur_block = nullptr;
+    imm_cursor = nullptr;
+
+#ifdef GB_COVERAGE
+    // La cobertura se marca en cada fetch: los bloques nativos no pasan por ahí
+    if (engine == Engine::Jit) engine = Engine::BlockCache;
+#endif
+
+    if (engine == Engine::Jit) {
+#ifdef GB_ENABLE_JIT
+        if (!jit_backend) jit_backend = std::make_unique<jit>();
+        if (!jit_backend->available()) engine = Engine::BlockCache;
+#else
+        std::cout << "[CPU] JIT no disponible en esta build, usando BlockCache\n";
+        engine = Engine::BlockCache;
+#endif
+    }
+
+    if ((engine == Engine::BlockCache || engine == Engine::Jit) && !blocks) {
+        blocks = std::make_unique<block_cache>();
+        seen_code_epoch = memory.codeEpoch();
+        seen_ram_epoch = memory.ramCodeEpoch();
+    }
+}
+
+cpu::Registers cpu::getRegisters() const
+{
+    Registers regs;
+    regs.pc = PC;
+    regs.sp = SP;
+    regs.a = r8[A]; regs.f = r8[F];
+    regs.b = r8[B]; regs.c = r8[C];
+    regs.d = r8[D]; regs.e = r8[E];
+    regs.h = r8[H]; regs.l = r8[L];
+    regs.ime           = IME;
+    regs.ime_scheduled = IME_scheduled;
+    regs.halted        = isHalted;
+    regs.stopped       = isStopped;
+    return regs;
+}
+
+void cpu::setRegisters(const Registers& regs)
+{
+    restoreRegisters(regs);
+    if (blocks) blocks->flushAll();
+}
+
+bool cpu::loadState(state_reader& in)
+{
+    Registers regs;
+    if (!in.get(regs)) return false;
+    restoreRegisters(regs);
+    return true;
+}
+
+void cpu::restoreRegisters(const Registers& regs)
+{
+    PC = regs.pc;
+    SP = regs.sp;
+    r8[A] = regs.a; r8[F] = regs.f;
+    r8[B] = regs.b; r8[C] = regs.c;
+    r8[D] = regs.d; r8[E] = regs.e;
+    r8[H] = regs.h; r8[L] = regs.l;
+    IME           = regs.ime;
+    IME_scheduled = regs.ime_scheduled;
+    isHalted      = regs.halted;
+    isStopped     = regs.stopped;
+
+    cur_block  = nullptr;
+    imm_cursor = nullptr;
+}
+
+void cpu::setJitPerfMap(bool on)
+{
+#ifdef GB_ENABLE_JIT
+    if (jit_backend) jit_backend->enablePerfMap(on);
+#else
+    (void)on;
+#endif
+}
+
+// Devuelve el op decodificado en PC y lo "consume" como lo haría fetch():
+// avanza PC y deja imm_cursor apuntando a sus bytes inmediatos.
+// Devuelve nullptr si PC no está en una región cacheable.
+const DecodedOp* cpu::fetchCached()
+{
+    // Escrituras en código (cambio de banco o automodificación en RAM)
+    if (memory.ramCodeEpoch() != seen_ram_epoch) {
+        seen_ram_epoch = memory.ramCodeEpoch();
+        blocks->flushRam();
+        cur_block = nullptr;
+    }
+    if (memory.codeEpoch() != seen_code_epoch) {
+        seen_code_epoch = memory.codeEpoch();
+        cur_block = nullptr;
+    }
+
+    // Seguir dentro del bloque actual si no hubo salto ni interrupción
+    if (!cur_block || PC != cur_next_pc || cur_index >= cur_block->ops.size()) {
+        cur_block = blocks->lookup(PC, memory, table_opcode);
+        cur_index = 0;
+        if (!cur_block) return nullptr;
+    }
+
+    const DecodedOp* op = &cur_block->ops[cur_index++];
+    cur_next_pc = PC + op->length;
+    imm_cursor = (op->length > 1) ? op->operand : nullptr;
+    PC++;
+    return op;
+}
+
+#ifdef GB_ENABLE_JIT
+// ============================================================
+// DISPATCH: JIT
+// ============================================================
+// Solo bloques de ROM: el código en RAM (posible automodificación)
+// sigue por el intérprete. Un bloque se compila tras HOT_THRESHOLD
+// entradas; si el primer op ya necesita sincronizar, devuelve 0 y
+// step() lo ejecuta interpretado.
+int cpu::runJit()
+{
+    if (PC >= 0x8000) return 0;
+
+    DecodedBlock* block = blocks->lookup(PC, memory, table_opcode);
+    if (!block) return 0;
+
+    if (!block->native) {
+        if (block->jit_failed || ++block->exec_count < jit::HOT_THRESHOLD) return 0;
+
+        block->native = jit_backend->compile(*this, *block);
+        if (!block->native) {
+            block->jit_failed = true;
+            return 0;
+        }
+    }
+
+    cur_block = nullptr; // El intérprete debe re-resolver su posición
+    int cycles = block->native(this);
+
     if (IME_scheduled) {
         IME = true;
         IME_scheduled = false;
-        std::cout << "[CPU] IME activado tras instrucción en PC=0x" << std::hex << pc_before << std::dec << "\n";
     }
-    
     return cycles;
 }
+#endif
+
+int cpu::ILLEGAL(uint8_t opcode)
+{
+    std::cout << "Opcode no implementado: 0x" << std::hex << (int)opcode 
+              << " at PC=0x" << (PC-1) << "\n";
+    return 4; // Retornar al menos 4 ciclos para evitar loops infinitos
+}
 
 // --- Helpers de Lectura ---
 uint8_t cpu::fetch() {
+#ifdef GB_COVERAGE
+    uint8_t opcode = memory.readCode(PC, rom_coverage::Opcode);
+#else
     uint8_t opcode = memory.readMemory(PC);
+#endif
     PC++;
     return opcode;
 }
 
 uint8_t cpu::readImmediateByte() {
+    if (imm_cursor) {
+#ifdef GB_COVERAGE
+        if (PC < 0x8000) memory.romCoverage().mark(rom_coverage::Operand, PC, memory.currentRomBank());
+#endif
+        PC++;
+        return *imm_cursor++;
+    }
+#ifdef GB_COVERAGE
+    uint8_t value = memory.readCode(PC, rom_coverage::Operand);
+#else
     uint8_t value = memory.readMemory(PC);
+#endif
     PC++; 
     return value;
 }
@@ -713,27 +906,25 @@ int cpu::HALT(uint8_t opcode)
 {
     (void)opcode;
     
-    // DEBUG: Log CADA ejecución de HALT
-    std::cout << "[CPU] *** HALT EXECUTED *** PC=0x" << std::hex << PC
-              << " IME=" << std::dec << (IME ? 1 : 0)
-              << " IF=0x" << std::hex << (int)memory.IO[0x0F]
-              << " IE=0x" << (int)memory.readMemory(0xFFFF)
-              << std::dec << "\n";
-    
     isHalted = true;
     
     // HALT bug del hardware real:
     // Si IME=0 y hay interrupciones pendientes,
     // el PC no se incrementa después de HALT
-    uint8_t if_reg = memory.readMemory(0xFF0F);
-    uint8_t ie_reg = memory.readMemory(0xFFFF);
+    // Directo a los registros: esta comprobación es del hardware, no un
+    // acceso de la CPU al bus (no pasa por readSlow ni sus contadores)
+    uint8_t if_reg = memory.IO[0x0F] | 0xE0;
+    uint8_t ie_reg = memory.IE;
     uint8_t pending = if_reg & ie_reg & 0x1F;
     
     if (!IME && pending > 0) {
         // HALT bug: salir inmediatamente de HALT
         isHalted = false;
-        std::cout << "[CPU] HALT BUG triggered - exiting immediately\n";
     }
+
+    GB_TRACE_EVENT(Cpu, "halt", { trace::hex("pc", PC), trace::dec("ime", IME),
+                                  trace::hex("if", if_reg), trace::hex("ie", ie_reg),
+                                  trace::dec("halt_bug", !isHalted) });
     
     return 4;
 }
@@ -782,7 +973,6 @@ int cpu::LD_r8_r8(uint8_t opcode) {
 
     // 3. Caso especial: 0x76 es HALT, no LD [HL], [HL]
     if (opcode == 0x76) {
-            std::cout <<"halt " << "\n";
         return HALT(opcode); 
     }
 
@@ -899,21 +1089,6 @@ int cpu::DEC_r8(uint8_t opcode) {
     uint8_t prevValue = r8[target];
     r8[target]--;
 
-    // DEBUG: Track DEC B during Init loop (PC=0x215)
-    static int dec_b_trace = 0;
-    if (opcode == 0x05) {  // DEC B
-        dec_b_trace++;
-        if (dec_b_trace <= 10 || (dec_b_trace % 256 == 0 && dec_b_trace <= 5000)) {
-            std::cout << "[DEC B #" << dec_b_trace << "] Before=" << std::hex 
-                      << (int)prevValue << " After=" << (int)r8[target]
-                      << " Z=" << std::dec << (r8[target] == 0 ? 1 : 0) << "\n";
-        }
-        // Special trace when B becomes 0
-        if (r8[target] == 0 && dec_b_trace <= 5000) {
-            std::cout << "[DEC B] B reached 0! Should exit inner loop. Z will be set to 1\n";
-        }
-    }
-
     // Banderas
     setZ(r8[target] == 0);
     setN(true); // Siempre true en decrementos
@@ -923,12 +1098,8 @@ int cpu::DEC_r8(uint8_t opcode) {
     return 4;
 }
 int cpu::JR_cc_r8(uint8_t opcode) {
-    // PC BEFORE reading operand (gives us the instruction address)
-    uint16_t instr_pc = PC - 1;  // -1 because opcode was already fetched
-    
     // Leer el desplazamiento (signed!)
     int8_t offset = (int8_t)readImmediateByte(); 
-    uint16_t target_pc = PC + offset;
     
     // Determinar la condición
     int condition = (opcode >> 3) & 0x03;
@@ -941,35 +1112,6 @@ int cpu::JR_cc_r8(uint8_t opcode) {
         case 3: jump = (getC() == 1); break; // C
     }
 
-    // DEBUG: Trace JR NZ at Init loop (PC=0x216)
-    static int jr_init_trace = 0;
-    if (instr_pc == 0x216 && opcode == 0x20) {  // JR NZ in Init loop
-        jr_init_trace++;
-        if (jr_init_trace <= 10 || (jr_init_trace % 256 == 0 && jr_init_trace <= 5000)) {
-            std::cout << "[JR NZ @0x216 #" << jr_init_trace << "] Z=" << (int)getZ()
-                      << " Jump=" << (jump ? "YES" : "NO")
-                      << " B=" << std::hex << (int)r8[B] 
-                      << " C=" << (int)r8[C] << std::dec << "\n";
-        }
-        // Trace when we should NOT jump (Z=1)
-        if (getZ() == 1) {
-            std::cout << "[JR NZ @0x216] Z=1, should NOT jump! Continuing to 0x218\n";
-        }
-    }
-
-    // DEBUG: Trace jump decisions in critical loop (0x2ED-0x2F2)
-    static int jr_trace_count = 0;
-    if ((PC - 2) >= 0x2ED && (PC - 2) <= 0x2F2) {  // PC already advanced by 2 (opcode + offset)
-        jr_trace_count++;
-        if (jr_trace_count <= 50) {
-            const char* cond_names[] = {"NZ", "Z", "NC", "C"};
-            std::cout << "[JR TRACE #" << jr_trace_count << "] Cond=" << cond_names[condition]
-                      << " Z=" << (int)getZ() << " Jump=" << (jump ? "YES" : "NO")
-                      << " Offset=" << (int)offset
-                      << " Target=0x" << std::hex << target_pc << std::dec << "\n";
-        }
-    }
-
     if (jump) {
         PC += offset;
         return 12; // Saltando tarda más
@@ -1034,19 +1176,6 @@ int cpu::LDH_n_A(uint8_t opcode) {
     // Lee el offset (ej: 0x40)
     uint8_t offset = readImmediateByte();
     
-    // DEBUG: Track writes to 0xFF85 with PC context
-    if (offset == 0x85) {
-        static int ff85_ldh_write_count = 0;
-        ff85_ldh_write_count++;
-        if (ff85_ldh_write_count <= 30) {
-            // PC-2 because we already fetched the opcode (E0) and operand (85)
-            uint16_t instr_pc = PC - 2;
-            std::cout << "[FF85 WRITE #" << ff85_ldh_write_count << "] PC=0x" 
-                      << std::hex << instr_pc << " A=0x" << (int)r8[A]
-                      << " (LDH [0xFF85],A)" << std::dec << "\n";
-        }
-    }
-    
     // Escribe A en 0xFF00 + offset
     memory.writeMemory(0xFF00 | offset, r8[A]);
     
@@ -1058,22 +1187,6 @@ int cpu::LDH_A_n(uint8_t opcode) {
     (void)opcode;
     uint8_t offset = readImmediateByte();
     
-    // DEBUG: Rastrear qué registros lee el juego en su polling loop
-    static int ldh_counts[256] = {0};
-    static int total_ldh = 0;
-    ldh_counts[offset]++;
-    total_ldh++;
-    
-    if (total_ldh == 10000) {
-        std::cout << "[LDH DEBUG] After 10K LDH reads:\n";
-        for (int i = 0; i < 256; i++) {
-            if (ldh_counts[i] > 100) {
-                std::cout << "  0xFF" << std::hex << std::setw(2) << std::setfill('0') << i 
-                          << ": " << std::dec << ldh_counts[i] << " reads\n";
-            }
-        }
-    }
-    
     // Lee de 0xFF00 + offset y guarda en A
     r8[A] = memory.readMemory(0xFF00 | offset);
     
@@ -1100,19 +1213,6 @@ int cpu::LD_a16_A(uint8_t opcode) {
     // 1. Leer la dirección de destino (2 bytes)
     uint16_t addr = readImmediateWord();
     
-    // DEBUG: Track writes to 0xFF85 with PC context
-    if (addr == 0xFF85) {
-        static int ff85_ld16_write_count = 0;
-        ff85_ld16_write_count++;
-        if (ff85_ld16_write_count <= 30) {
-            // PC-3 because we already fetched opcode (EA) and 2-byte operand
-            uint16_t instr_pc = PC - 3;
-            std::cout << "[FF85 WRITE via LD #" << ff85_ld16_write_count << "] PC=0x" 
-                      << std::hex << instr_pc << " A=0x" << (int)r8[A]
-                      << " (LD [0xFF85],A)" << std::dec << "\n";
-        }
-    }
-    
     // 2. Escribir A en esa dirección
     memory.writeMemory(addr, r8[A]);
     
@@ -1341,6 +1441,7 @@ int cpu::PREFIX_CB(uint8_t opcode) {
     (void)opcode;
     // 1. LEER el verdadero opcode CB
     uint8_t cb_op = readImmediateByte();
+    cb_opcode = cb_op;
     
     // Decodificar
     int regIndex = cb_op & 0x07;       // 0-7: Registro afectado
@@ -1624,19 +1725,6 @@ int cpu::LD_C_A(uint8_t opcode) {
     // Dirección base de IO (0xFF00) + Registro C
     uint16_t addr = 0xFF00 | r8[C];
     
-    // DEBUG: Track writes to 0xFF85 via LD (C),A
-    if (addr == 0xFF85) {
-        static int ff85_ldc_write_count = 0;
-        ff85_ldc_write_count++;
-        if (ff85_ldc_write_count <= 30) {
-            // PC-1 because we already fetched opcode (E2)
-            uint16_t instr_pc = PC - 1;
-            std::cout << "[FF85 WRITE via LD(C) #" << ff85_ldc_write_count << "] PC=0x" 
-                      << std::hex << instr_pc << " A=0x" << (int)r8[A]
-                      << " C=0x" << (int)r8[C] << std::dec << "\n";
-        }
-    }
-    
     memory.writeMemory(addr, r8[A]);
     
     // std::cout << "LD [FF" << std::hex << (int)r8[C] << "], A\n";
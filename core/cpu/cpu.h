@@ -3,9 +3,18 @@
 #include <array>
 #include <cstdint>
 #include <iostream>
+#include <memory>
 
 // Asegúrate de que la ruta sea la correcta en tu proyecto
 #include "mmu/mmu.h" 
+#include "block_cache.h"
+#ifdef GB_ENABLE_JIT
+#include "jit/jit.h"
+#endif
+
+class profiler;
+class opcode_profile;
+class timeline;
 
 class cpu
 {
@@ -19,7 +28,76 @@ public:
     // Permite que componentes externos (Timer, PPU, Joypad) soliciten una interrupción
     void requestInterrupt(int bit);
 
+    // HALT/STOP sin ninguna interrupción (IF & IE) que la despierte:
+    // step() solo consumiría ciclos hasta el próximo evento del hardware
+    bool sleeping() const;
+
+    // T-cycles hasta el próximo evento del scheduler o el fin de frame.
+    // Un bloque del JIT sale al alcanzarlos: PPU, timer e interrupciones
+    // se atienden tras la misma instrucción que en el intérprete.
+    void setCycleBudget(int32_t cycles) { cycle_budget = cycles; }
+
+    // Instrucciones retiradas por el último step(): 1 en el intérprete
+    // (o al servir una interrupción), todas las del bloque con el JIT
+    uint32_t stepInstructions() const { return step_instructions; }
+
+    // --- MOTOR DE DISPATCH ---
+    // Table:  tabla de punteros a función miembro (implementación original)
+    // Switch: switch denso con un handler especializado por opcode
+    // BlockCache: bloques decodificados (opcode + inmediatos ya leídos)
+    // Jit: bloques calientes de ROM compilados a x86-64 (build nativa
+    //      con GB_ENABLE_JIT; si no está disponible se usa BlockCache)
+    // El motor por defecto se elige en build (opción CMake GB_CPU_ENGINE)
+    // y se puede cambiar en runtime para comparar ambos en benchmarks.
+    enum class Engine : uint8_t {
+        Table,
+        Switch,
+        BlockCache,
+        Jit
+    };
+
+    void   setEngine(Engine e);
+    Engine getEngine() const   { return engine; }
+
+    // Escribe /tmp/perf-<pid>.map con los bloques del JIT (no-op sin JIT)
+    void   setJitPerfMap(bool on);
+
+    // Profiler de ciclos por (banco, PC) y pila de llamadas (nullptr = apagado).
+    // Mientras está conectado el JIT no se usa: sus bloques no se pueden
+    // atribuir instrucción a instrucción.
+    void      setProfiler(profiler* p) { prof = p; }
+    profiler* getProfiler() const      { return prof; }
+
+    // Coste por opcode base/CB (nullptr = apagado). Igual que el
+    // profiler, desactiva el JIT mientras está conectado.
+    void            setOpcodeProfile(opcode_profile* p) { opcodes = p; }
+    opcode_profile* getOpcodeProfile() const            { return opcodes; }
+
+    // Timeline opcional: interrupciones servidas (nullptr = apagado)
+    void      setTimeline(timeline* tl) { trace_timeline = tl; }
+
+    // --- ESTADO DE REGISTROS ---
+    // Para tests de conformidad y para guardar/restaurar la máquina.
+    // setRegisters descarta los bloques decodificados: la memoria de
+    // código puede haber cambiado sin pasar por el MMU.
+    struct Registers {
+        uint16_t pc, sp;
+        uint8_t  a, f, b, c, d, e, h, l;
+        bool     ime, ime_scheduled, halted, stopped;
+    };
+
+    Registers getRegisters() const;
+    void      setRegisters(const Registers& regs);
+
+    // Save state: solo los registros. A diferencia de setRegisters
+    // conserva los bloques de ROM decodificados (y compilados): la ROM
+    // no cambia, y el MMU invalida los de RAM al cargar su estado.
+    void saveState(state_writer& out) const { out.put(getRegisters()); }
+    bool loadState(state_reader& in);
+
 private:
+    friend class jit;   // El código generado lee/escribe el estado directamente
+
     // Referencia a la memoria (MMU)
     mmu& memory;
 
@@ -85,6 +163,39 @@ private:
     // Tabla de opcodes (256 instrucciones posibles)
     std::array<Instruction, 256> table_opcode; 
 
+    Engine engine;
+
+    profiler* prof = nullptr;
+    opcode_profile* opcodes = nullptr;
+    timeline* trace_timeline = nullptr;
+
+    uint8_t cb_opcode = 0;   // Último opcode tras el prefijo CB (opcode_profile)
+
+    int executeTable(uint8_t opcode);   // Dispatch vía table_opcode
+    int executeSwitch(uint8_t opcode);  // Dispatch vía switch (un case por opcode)
+
+    // --- CACHÉ DE BLOQUES (Engine::BlockCache) ---
+    std::unique_ptr<block_cache> blocks;
+    DecodedBlock*  cur_block = nullptr;    // Bloque en ejecución
+    size_t         cur_index = 0;          // Siguiente op dentro del bloque
+    uint16_t       cur_next_pc = 0;        // PC esperado si no hubo salto
+    uint32_t       seen_code_epoch = 0;    // Épocas del MMU vistas por última vez
+    uint32_t       seen_ram_epoch = 0;
+    const uint8_t* imm_cursor = nullptr;   // Inmediatos del op actual (o nullptr)
+
+    const DecodedOp* fetchCached();
+    void restoreRegisters(const Registers& regs);   // Sin vaciar la caché     // Trae el siguiente op decodificado (o nullptr)
+
+    int32_t        cycle_budget = INT32_MAX;
+    uint32_t       step_instructions = 1;
+
+#ifdef GB_ENABLE_JIT
+    std::unique_ptr<jit> jit_backend;
+    int runJit();                       // Ejecuta un bloque nativo (0 = usar intérprete)
+#endif
+
+    int ILLEGAL(uint8_t opcode);        // 0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD
+
     // Instrucciones Misceláneas y de Control
     int NOP(uint8_t opcode);
     int STOP(uint8_t opcode);
@@ -0,0 +1,309 @@
+#include "jit.h"
+#include "../cpu.h"
+
+#include <cstring>
+#include <iostream>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ============================================================
+// ARENA
+// ============================================================
+jit::jit()
+{
+    void* mem = mmap(nullptr, ARENA_SIZE, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[JIT] ERROR: no se pudo reservar la arena de código\n";
+        return;
+    }
+    arena = static_cast<uint8_t*>(mem);
+}
+
+jit::~jit()
+{
+    if (perf_map) fclose(perf_map);
+    if (arena) munmap(arena, ARENA_SIZE);
+}
+
+void jit::enablePerfMap(bool on)
+{
+    if (!on) {
+        if (perf_map) fclose(perf_map);
+        perf_map = nullptr;
+        return;
+    }
+    if (perf_map) return;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", static_cast<int>(getpid()));
+    perf_map = fopen(path, "w");
+    if (!perf_map) {
+        std::cerr << "[JIT] ERROR: no se pudo abrir " << path << "\n";
+    }
+}
+
+// ============================================================
+// SINCRONIZACIÓN
+// ============================================================
+// I/O (PPU, timer, APU, joypad, IF) e IE: el intérprete debe hacer
+// el acceso con el resto de componentes al día.
+static bool isIO(uint16_t address)
+{
+    return (address >= 0xFF00 && address <= 0xFF7F) || address == 0xFFFF;
+}
+
+// Escritura que además puede cambiar el banco o habilitar RAM del MBC
+static bool isSyncWrite(uint16_t address)
+{
+    return isIO(address) || address <= 0x7FFF;
+}
+
+bool jit::needsSync(const cpu& self, const DecodedOp& op)
+{
+    const uint8_t  o  = op.opcode;
+    const uint16_t hl = self.getHL();
+    const uint16_t sp = self.SP;
+    const uint16_t a16 = static_cast<uint16_t>(op.operand[0] | (op.operand[1] << 8));
+
+    // CB xx con operando (HL): BIT solo lee, el resto lee y escribe
+    if (o == 0xCB) {
+        if ((op.operand[0] & 0x07) != 6) return false;
+        return ((op.operand[0] >> 6) == 1) ? isIO(hl) : isSyncWrite(hl);
+    }
+
+    // LD r,r' / ALU A,r con (HL)
+    if (o >= 0x40 && o <= 0xBF && o != 0x76) {
+        if (o < 0x80 && ((o >> 3) & 0x07) == 6) return isSyncWrite(hl);
+        if ((o & 0x07) == 6) return isIO(hl);
+        return false;
+    }
+
+    switch (o) {
+        case 0x34: case 0x35: case 0x36:             // INC/DEC/LD (HL)
+        case 0x22: case 0x32:                        // LD (HL+/-),A
+            return isSyncWrite(hl);
+        case 0x2A: case 0x3A:                        // LD A,(HL+/-)
+            return isIO(hl);
+        case 0x02: return isSyncWrite(self.getBC()); // LD (BC),A
+        case 0x12: return isSyncWrite(self.getDE()); // LD (DE),A
+        case 0x0A: return isIO(self.getBC());        // LD A,(BC)
+        case 0x1A: return isIO(self.getDE());        // LD A,(DE)
+        case 0x08:                                   // LD (a16),SP
+            return isSyncWrite(a16) || isSyncWrite(a16 + 1);
+        case 0xEA: return isSyncWrite(a16);          // LD (a16),A
+        case 0xFA: return isIO(a16);                 // LD A,(a16)
+        case 0xE0: case 0xF0:                        // LDH (a8)
+            return isIO(0xFF00 | op.operand[0]);
+        case 0xE2: case 0xF2:                        // LDH (C)
+            return isIO(0xFF00 | self.r8[cpu::C]);
+
+        // Escrituras en el stack
+        case 0xC5: case 0xD5: case 0xE5: case 0xF5:  // PUSH
+        case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC: // CALL
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:  // RST
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+            return isSyncWrite(sp - 1) || isSyncWrite(sp - 2);
+
+        // Lecturas del stack
+        case 0xC1: case 0xD1: case 0xE1: case 0xF1:  // POP
+        case 0xC9: case 0xD9:                        // RET, RETI
+        case 0xC0: case 0xC8: case 0xD0: case 0xD8:  // RET cc
+            return isIO(sp) || isIO(sp + 1);
+
+        case 0x10:                                   // STOP (toca DIV/joypad)
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+int jit::execOp(cpu* self, const DecodedOp* op)
+{
+    if (needsSync(*self, *op)) return -1;
+
+    // Igual que cpu::fetchCached(): el opcode ya está consumido
+    self->PC++;
+    self->imm_cursor = (op->length > 1) ? op->operand : nullptr;
+    int cycles = op->handler ? (self->*op->handler)(op->opcode)
+                             : self->ILLEGAL(op->opcode);
+    self->imm_cursor = nullptr;
+    return cycles;
+}
+
+// ============================================================
+// COMPILADOR
+// ============================================================
+// Registros del host dentro del bloque:
+//   rbx  = cpu* (estado del SM83)
+//   r12d = T-cycles acumulados
+//   r13d = instrucciones retiradas (-> cpu::step_instructions)
+// Entre op y op se compara r12d con cpu::cycle_budget: el bloque no
+// pasa por encima de un evento del scheduler ni del fin de frame.
+// ABI System V: rdi = primer argumento, rax = retorno; rbx/r12/r13
+// son callee-saved (tres push dejan el stack alineado a 16).
+DecodedBlock::NativeBlock jit::compile(cpu& owner, const DecodedBlock& block)
+{
+    if (!arena || block.start_pc >= 0x8000 || block.ops.empty()) return nullptr;
+
+    const uint8_t* base = reinterpret_cast<const uint8_t*>(&owner);
+    const int32_t off_r8 = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(owner.r8.data()) - base);
+    const int32_t off_pc = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&owner.PC) - base);
+    const int32_t off_sp = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&owner.SP) - base);
+    const int32_t off_retired = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&owner.step_instructions) - base);
+    const int32_t off_budget = static_cast<int32_t>(reinterpret_cast<const uint8_t*>(&owner.cycle_budget) - base);
+
+    // Código de registro del hardware (0=B ... 7=A) -> índice en r8
+    static const uint8_t REG[8] = { cpu::B, cpu::C, cpu::D, cpu::E, cpu::H, cpu::L, 0xFF, cpu::A };
+
+    auto storeByte = [&](int32_t off, uint8_t value) {   // mov byte [rbx+off], imm8
+        emit8(0xC6); emit8(0x83); emit32(off); emit8(value);
+    };
+    auto storePC = [&](uint16_t value) {                 // mov word [rbx+PC], imm16
+        emit8(0x66); emit8(0xC7); emit8(0x83); emit32(off_pc); emit16(value);
+    };
+
+    code.clear();
+
+    // Prólogo
+    emit8(0x53);                                 // push rbx
+    emit8(0x41); emit8(0x54);                    // push r12
+    emit8(0x41); emit8(0x55);                    // push r13
+    emit8(0x48); emit8(0x89); emit8(0xFB);       // mov rbx, rdi
+    emit8(0x45); emit8(0x31); emit8(0xE4);       // xor r12d, r12d
+    emit8(0x45); emit8(0x31); emit8(0xED);       // xor r13d, r13d
+
+    std::vector<size_t> exits;   // Posiciones de los rel32 de side exit
+    uint32_t pending = 0;        // Ciclos de ops en línea aún no sumados
+    uint8_t  pending_ops = 0;    // Ops completados aún no contados en r13d
+    uint16_t pc = block.start_pc;
+    bool     pc_stored = false;  // El último op dejó PC correcto
+
+    auto flushCycles = [&]() {
+        if (pending_ops) {
+            emit8(0x41); emit8(0x83); emit8(0xC5); emit8(pending_ops); // add r13d, imm8
+            pending_ops = 0;
+        }
+        if (pending == 0) return;
+        emit8(0x41); emit8(0x81); emit8(0xC4); emit32(pending); // add r12d, imm32
+        pending = 0;
+    };
+
+    for (const DecodedOp& op : block.ops)
+    {
+        const uint8_t o = op.opcode;
+        const uint16_t next_pc = static_cast<uint16_t>(pc + op.length);
+        pc_stored = false;
+
+        if (o == 0x00) {                                        // NOP
+            pending += 4;
+        }
+        else if (o >= 0x40 && o <= 0x7F && o != 0x76 &&
+                 ((o >> 3) & 0x07) != 6 && (o & 0x07) != 6) {   // LD r,r'
+            uint8_t dst = REG[(o >> 3) & 0x07];
+            uint8_t src = REG[o & 0x07];
+            if (dst != src) {
+                emit8(0x0F); emit8(0xB6); emit8(0x83); emit32(off_r8 + src); // movzx eax, byte [rbx+src]
+                emit8(0x88); emit8(0x83); emit32(off_r8 + dst);              // mov [rbx+dst], al
+            }
+            pending += 4;
+        }
+        else if (o <= 0x3F && (o & 0x07) == 6 && o != 0x36) {  // LD r,d8
+            storeByte(off_r8 + REG[(o >> 3) & 0x07], op.operand[0]);
+            pending += 8;
+        }
+        else if (o == 0x01 || o == 0x11 || o == 0x21) {         // LD rr,d16
+            static const uint8_t HI[3] = { cpu::B, cpu::D, cpu::H };
+            static const uint8_t LO[3] = { cpu::C, cpu::E, cpu::L };
+            storeByte(off_r8 + HI[o >> 4], op.operand[1]);
+            storeByte(off_r8 + LO[o >> 4], op.operand[0]);
+            pending += 12;
+        }
+        else if (o == 0x31) {                                   // LD SP,d16
+            emit8(0x66); emit8(0xC7); emit8(0x83); emit32(off_sp);
+            emit16(static_cast<uint16_t>(op.operand[0] | (op.operand[1] << 8)));
+            pending += 12;
+        }
+        else if (o == 0xC3) {                                   // JP a16
+            storePC(static_cast<uint16_t>(op.operand[0] | (op.operand[1] << 8)));
+            pending += 16;
+            pc_stored = true;
+        }
+        else if (o == 0x18) {                                   // JR r8
+            storePC(static_cast<uint16_t>(next_pc + static_cast<int8_t>(op.operand[0])));
+            pending += 12;
+            pc_stored = true;
+        }
+        else {
+            // Llamada al intérprete: execOp(rbx, &op)
+            flushCycles();
+            storePC(pc);
+            emit8(0x48); emit8(0x89); emit8(0xDF);                      // mov rdi, rbx
+            emit8(0x48); emit8(0xBE); emit64(reinterpret_cast<uint64_t>(&op));        // mov rsi, imm64
+            emit8(0x48); emit8(0xB8); emit64(reinterpret_cast<uint64_t>(&jit::execOp)); // mov rax, imm64
+            emit8(0xFF); emit8(0xD0);                                   // call rax
+            emit8(0x85); emit8(0xC0);                                   // test eax, eax
+            emit8(0x0F); emit8(0x88); exits.push_back(code.size()); emit32(0); // js exit
+            emit8(0x41); emit8(0x01); emit8(0xC4);                      // add r12d, eax
+            pc_stored = true;
+        }
+
+        pc = next_pc;
+        pending_ops++;
+
+        // EI: IME se activa al terminar el step(), como en el intérprete
+        if (o == 0xFB || &op == &block.ops.back()) break;
+
+        // Presupuesto agotado: vence un evento (PPU, timer...) antes del
+        // siguiente op. Se sale con PC al día, igual que el intérprete
+        // volvería al scheduler tras esta instrucción.
+        flushCycles();
+        if (!pc_stored) {
+            storePC(pc);
+            pc_stored = true;
+        }
+        emit8(0x44); emit8(0x3B); emit8(0xA3); emit32(off_budget);     // cmp r12d, [rbx+budget]
+        emit8(0x0F); emit8(0x8D); exits.push_back(code.size()); emit32(0); // jge exit
+    }
+
+    if (!pc_stored) storePC(pc);
+    flushCycles();
+
+    // Salida (normal y side exits)
+    size_t exit_pos = code.size();
+    for (size_t at : exits) {
+        int32_t rel = static_cast<int32_t>(exit_pos - (at + 4));
+        std::memcpy(&code[at], &rel, 4);
+    }
+    emit8(0x44); emit8(0x89); emit8(0xAB); emit32(off_retired); // mov [rbx+retired], r13d
+    emit8(0x44); emit8(0x89); emit8(0xE0);       // mov eax, r12d
+    emit8(0x41); emit8(0x5D);                    // pop r13
+    emit8(0x41); emit8(0x5C);                    // pop r12
+    emit8(0x5B);                                 // pop rbx
+    emit8(0xC3);                                 // ret
+
+    // Copiar a la arena (alineado a 16) y volver a marcarla ejecutable
+    size_t start = (arena_used + 15) & ~static_cast<size_t>(15);
+    if (start + code.size() > ARENA_SIZE) return nullptr;
+
+    const size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t first_page = start & ~(page - 1);
+    size_t last_page  = (start + code.size() + page - 1) & ~(page - 1);
+
+    if (mprotect(arena + first_page, last_page - first_page, PROT_READ | PROT_WRITE) != 0) return nullptr;
+    std::memcpy(arena + start, code.data(), code.size());
+    if (mprotect(arena + first_page, last_page - first_page, PROT_READ | PROT_EXEC) != 0) return nullptr;
+
+    arena_used = start + code.size();
+    compiled_blocks++;
+
+    if (perf_map) {
+        fprintf(perf_map, "%lx %zx gb_jit_b%02X_%04X\n",
+                reinterpret_cast<unsigned long>(arena + start), code.size(),
+                block.bank, block.start_pc);
+        fflush(perf_map);
+    }
+
+    return reinterpret_cast<DecodedBlock::NativeBlock>(arena + start);
+}
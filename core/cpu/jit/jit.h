@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "../block_cache.h"
+
+// ============================================================
+// JIT - Recompilador dinámico SM83 -> x86-64 (solo build nativa)
+// ============================================================
+// Traduce los bloques calientes de ROM (ya decodificados por
+// block_cache) a código máquina del host:
+//
+//   - Las instrucciones de solo registros (NOP, LD r,r', LD r,d8,
+//     LD rr,d16, JP a16, JR r8) se emiten en línea sobre el estado
+//     de la CPU.
+//   - El resto se emite como una llamada directa a execOp(), que
+//     ejecuta el handler del intérprete con los inmediatos ya leídos.
+//
+// Antes de cada instrucción con acceso a memoria, execOp() comprueba
+// la dirección real: si toca I/O (0xFF00-0xFF7F, IE) o los registros
+// del MBC (escritura en 0x0000-0x7FFF), el bloque sale en ese punto
+// (side exit) y el intérprete ejecuta esa instrucción con PPU, timer
+// y APU sincronizados. Así un bloque nativo nunca tiene efectos que
+// otro componente deba ver a mitad de bloque.
+//
+// Tampoco cruza eventos del hardware: entre op y op compara los ciclos
+// acumulados con cpu::cycle_budget y sale si ya vence uno, así que las
+// interrupciones se sirven en la misma instrucción que sin JIT.
+//
+// Solo se compila código de ROM: el código en WRAM/HRAM puede ser
+// automodificable y siempre lo ejecuta el intérprete.
+//
+// Con enablePerfMap() se escribe /tmp/perf-<pid>.map para que
+// `perf report` muestre cada bloque como gb_jit_bXX_PPPP.
+// ============================================================
+
+class cpu;
+
+class jit
+{
+public:
+    jit();
+    ~jit();
+
+    jit(const jit&) = delete;
+    jit& operator=(const jit&) = delete;
+
+    // ¿Hay arena ejecutable? (false si mmap falló)
+    bool available() const { return arena != nullptr; }
+
+    // Compila el bloque. Devuelve nullptr si no se puede (arena llena,
+    // bloque vacío tras los cortes...), y el bloque sigue interpretado.
+    DecodedBlock::NativeBlock compile(cpu& owner, const DecodedBlock& block);
+
+    void enablePerfMap(bool on);
+
+    // Ejecuciones de un bloque antes de compilarlo
+    static constexpr uint32_t HOT_THRESHOLD = 16;
+
+    size_t compiledBlocks() const { return compiled_blocks; }
+    size_t codeBytes()      const { return arena_used; }
+
+private:
+    // Llamado desde el código generado. Devuelve los ciclos del op o
+    // -1 si debe volver al intérprete antes de ejecutarlo.
+    static int execOp(cpu* self, const DecodedOp* op);
+    static bool needsSync(const cpu& self, const DecodedOp& op);
+
+    // --- Arena de código (mmap RW <-> RX) ---
+    static constexpr size_t ARENA_SIZE = 16 * 1024 * 1024;
+    uint8_t* arena = nullptr;
+    size_t   arena_used = 0;
+    size_t   compiled_blocks = 0;
+
+    FILE* perf_map = nullptr;
+
+    // --- Emisor ---
+    std::vector<uint8_t> code;
+    void emit8(uint8_t b)   { code.push_back(b); }
+    void emit16(uint16_t v) { emit8(v & 0xFF); emit8(v >> 8); }
+    void emit32(uint32_t v) { for (int i = 0; i < 4; i++) emit8((v >> (8 * i)) & 0xFF); }
+    void emit64(uint64_t v) { for (int i = 0; i < 8; i++) emit8((v >> (8 * i)) & 0xFF); }
+};
@@ -5,17 +5,63 @@
 
 #include "mmu.h"
 #include "../APU/apu.h"  // APU para registros de audio
+#include "../scheduler/scheduler.h"
+#include "trace/timeline.h"
+#include "trace/trace.h"
 #include <iostream>
 #include <iomanip>
 
 // --- Constructor ---
-mmu::mmu(const std::string& romPath) : cart(romPath) 
+mmu::mmu(const std::string& romPath)
+    : cart(romPath)
+#ifdef GB_COVERAGE
+    , coverage(cart.romBankCount())
+#endif
 {
-    VRAM.fill(0);
-    WRAM.fill(0);
+    clearMemory();
+    mapPages();
+    
+    std::cout << "MMU Inicializada. Cartucho conectado: " << romPath << "\n";
+}
+
+mmu::mmu(mmu& parent, Fork)
+    : cart(parent.cart, cartridge::Fork{})
+#ifdef GB_COVERAGE
+    , coverage(cart.romBankCount())
+#endif
+    , VRAM(parent.VRAM)
+    , WRAM(parent.WRAM)
+{
+    clearMemory();
+    mapPages();
+
+    // El padre ya no puede escribir en sitio en las páginas compartidas
+    parent.mapPages();
+}
+
+mmu::mmu(FlatRam)
+#ifdef GB_COVERAGE
+    : coverage(cart.romBankCount())
+#endif
+{
+    clearMemory();
+
+    flat_ram.assign(0x10000, 0);
+    for (int p = 0; p < 256; p++) {
+        read_page[p]  = &flat_ram[p << 8];
+        write_page[p] = &flat_ram[p << 8];
+    }
+}
+
+void mmu::clearMemory()
+{
+    // VRAM y WRAM nacen a 0 (o compartidas con el padre en un fork)
     HRAM.fill(0);
     IO.fill(0);
     OAM.fill(0);
+    WRAM_code.fill(0);
+    HRAM_code.fill(0);
+    WRAM_code_pages.fill(0);
     IE = 0;
     // IF ahora usa IO[0x0F] directamente para evitar desincronización
     IO[0x0F] = 0; // IF - Interrupt Flag
@@ -23,8 +69,6 @@ mmu::mmu(const std::string& romPath) : cart(romPath)
     // IMPORTANTE: Inicializar el joypad correctamente
     // Bits 4-5 deben estar en 1 por defecto (ningún grupo seleccionado)
     IO[0x00] = 0xFF; // 0xFF00 - Joypad
-    
-    std::cout << "MMU Inicializada. Cartucho conectado: " << romPath << "\n";
 }
 
 // --- Helper: Calcular Offset ---
@@ -33,61 +77,237 @@ uint16_t mmu::offSet(uint16_t address, uint16_t base)
     return address - base;
 }
 
+// --- Helper: Tabla de páginas ---
+void mmu::mapPages()
+{
+    read_page.fill(nullptr);
+    write_page.fill(nullptr);
+
+    // VRAM: 0x8000-0x9FFF. Los datos de tiles (0x8000-0x97FF) se escriben
+    // por writeSlow para mantener la caché de tiles; los mapas son directos.
+    for (int index = 0; index < 0x20; index++) mapVramPage(index);
+
+    // WRAM: 0xC000-0xDFFF y su espejo 0xE000-0xFDFF
+    mapRamWrites();
+
+    mapCartPages();
+
+    // 0xFE00 (OAM + zona prohibida) y 0xFF00 (I/O, HRAM, IE) quedan en
+    // nullptr: HRAM la resuelven readBus/writeMemory, el resto va por
+    // readSlow/writeSlow
+}
+
+void mmu::mapCartPages()
+{
+    // Punteros publicados por el MBC; nullptr → readCartridge/writeCartridge
+    BankMap banks = cart.bankMap();
+
+    for (int p = 0x00; p <= 0x3F; p++)
+        read_page[p] = banks.rom0 ? banks.rom0 + (p << 8) : nullptr;
+    for (int p = 0x40; p <= 0x7F; p++)
+        read_page[p] = banks.romx ? banks.romx + ((p - 0x40) << 8) : nullptr;
+
+    // Las escrituras en 0x0000-0x7FFF son registros del MBC: siempre slow.
+    // Las páginas de RAM compartidas (fork) se leen directo pero se
+    // escriben por writeSlow, que las copia.
+    paged_ram& ram = cart.externalRam();
+    for (int p = 0xA0; p <= 0xBF; p++) {
+        size_t index = (static_cast<size_t>(banks.ram) >> 8) + (p - 0xA0);
+        read_page[p]  = banks.ram >= 0 ? ram.page(index)      : nullptr;
+        write_page[p] = banks.ram >= 0 ? ram.ownedPage(index) : nullptr;
+    }
+}
+
+void mmu::mapRamWrites()
+{
+    for (int index = 0; index < 0x20; index++) mapWramPage(index);
+}
+
+// Una página compartida con otra máquina (fork) no tiene puntero de
+// escritura: su primera escritura la copia en writeSlow
+void mmu::mapVramPage(int index)
+{
+    read_page[0x80 + index] = VRAM.page(index);
+    if (index >= 0x18) write_page[0x80 + index] = VRAM.ownedPage(index);
+}
+
+void mmu::mapWramPage(int index)
+{
+    uint8_t* writable = WRAM_code_pages[index] ? nullptr : WRAM.ownedPage(index);
+
+    read_page[0xC0 + index]  = WRAM.page(index);
+    write_page[0xC0 + index] = writable;
+    if (0xE0 + index <= 0xFD) {
+        read_page[0xE0 + index]  = WRAM.page(index);
+        write_page[0xE0 + index] = writable;
+    }
+}
+
+size_t mmu::ownedRamPages() const
+{
+    return VRAM.ownedPages() + WRAM.ownedPages() + cart.externalRam().ownedPages();
+}
+
+// --- Helper: Caché de bloques ---
+// Las páginas de WRAM con código cacheado pierden su puntero de
+// escritura para que writeSlow detecte la automodificación.
+void mmu::markCode(uint16_t address)
+{
+    // En RAM plana todas las páginas son directas y nadie invalida
+    // bloques (los tests reinician la CPU en cada caso)
+    if (!flat_ram.empty()) return;
+
+    if (address >= 0xC000 && address <= 0xFDFF) {
+        uint16_t offset = (address <= 0xDFFF) ? offSet(address, 0xC000) : offSet(address, 0xE000);
+        WRAM_code[offset] = 1;
+
+        int page = offset >> 8;
+        WRAM_code_pages[page] = 1;
+        write_page[0xC0 + page] = nullptr;
+        if (0xE0 + page <= 0xFD) write_page[0xE0 + page] = nullptr;
+    }
+    else if (address >= 0xFF80 && address <= 0xFFFE)
+        HRAM_code[offSet(address, 0xFF80)] = 1;
+}
+
+void mmu::invalidateCode()
+{
+    // La CPU descarta todos sus bloques de RAM al ver el nuevo epoch,
+    // así que todas las marcas dejan de ser válidas a la vez.
+    WRAM_code.fill(0);
+    HRAM_code.fill(0);
+    WRAM_code_pages.fill(0);
+    mapRamWrites();
+    ram_code_epoch++;
+    code_epoch++;
+}
+
+// ============================================================
+// SAVE STATE
+// ============================================================
+void mmu::saveState(state_writer& out, bool with_ram) const
+{
+    if (with_ram) {
+        VRAM.saveState(out);
+        WRAM.saveState(out);
+    }
+    out.put(HRAM);
+    out.put(IO);
+    out.put(OAM);
+    out.put(IE);
+    cart.saveState(out, with_ram);
+}
+
+bool mmu::loadState(state_reader& in, bool with_ram)
+{
+    if (with_ram && !(VRAM.loadState(in) && WRAM.loadState(in))) return false;
+    in.get(HRAM);
+    in.get(IO);
+    in.get(OAM);
+    in.get(IE);
+    if (!cart.loadState(in, with_ram)) return false;
+
+    tiles.rebuild(VRAM);
+
+    // En RAM plana la tabla de páginas no apunta a VRAM, WRAM ni al cartucho
+    if (flat_ram.empty()) {
+        for (int index = 0; index < 0x20; index++) mapVramPage(index);
+        invalidateCode();
+        mapCartPages();
+    }
+    return in.ok();
+}
+
+void mmu::hashRam(state_hasher& out) const
+{
+    VRAM.hash(out);
+    WRAM.hash(out);
+    cart.externalRam().hash(out);
+}
+
+// ============================================================
+// TELEMETRÍA
+// ============================================================
+void mmu::collectStats(gb_perf_stats& stats)
+{
+    for (unsigned r = 0; r < GB_MEM_REGION_COUNT; r++) {
+        stats.mem_reads[r]  = 0;
+        stats.mem_writes[r] = 0;
+    }
+    stats.bank_switches = bank_switches;
+    stats.dma_transfers = dma_transfers;
+    bank_switches = dma_transfers = 0;
+
+#ifdef GB_MEM_HEATMAP
+    for (int page = 0; page < 256; page++) {
+        stats.mem_reads[gb_page_region(page)]  += page_reads[page];
+        stats.mem_writes[gb_page_region(page)] += page_writes[page];
+    }
+
+    // La página 0xFF mezcla I/O con HRAM/IE: readSlow/writeSlow cuentan
+    // la parte de HRAM (la DMA a OAM tampoco pasa por esa página)
+    stats.mem_reads[GB_MEM_IO]    -= hram_reads;
+    stats.mem_writes[GB_MEM_IO]   -= hram_writes;
+    stats.mem_reads[GB_MEM_HRAM]   = hram_reads;
+    stats.mem_writes[GB_MEM_HRAM]  = hram_writes;
+
+    if (tracking) heatmap.endFrame(page_reads, page_writes, hram_reads, hram_writes);
+    else          heatmap.discardFrame();
+
+    page_reads.fill(0);
+    page_writes.fill(0);
+    hram_reads = hram_writes = 0;
+#endif
+}
+
+void mmu::setTracking(bool on)
+{
+#ifdef GB_COVERAGE
+    coverage.setEnabled(on);
+#endif
+#ifdef GB_MEM_HEATMAP
+    tracking = on;
+#endif
+    (void)on;
+}
+
 // --- Helper: DMA Transfer ---
 void mmu::DMA(uint8_t value) 
 {
     uint16_t base = value << 8;
     
-    // DEBUG: Log DMA transfers
-    static int dma_count = 0;
-    dma_count++;
-    if (dma_count <= 10 || dma_count == 100 || dma_count == 500) {
-        std::cout << "[DMA #" << dma_count << "] Transfer from 0x" 
-                  << std::hex << base << std::dec << " to OAM\n";
-        
-        // Sample source data before copy
-        std::cout << "  Source first 8 bytes: ";
-        for (int i = 0; i < 8; i++) {
-            std::cout << std::hex << std::setw(2) << std::setfill('0') 
-                      << (int)readMemory(base + i) << " ";
-        }
-        std::cout << std::dec << "\n";
+    GB_TRACE_EVENT(Mmu, "dma", { trace::hex("source", base) });
+    dma_transfers++;
+
+    // 160 M-cycles copiando a OAM
+    if (trace_timeline) {
+        uint64_t now = trace_timeline->cycleNow();
+        trace_timeline->complete(timeline::Memory, "oam_dma", now, now + 640, "source", base);
     }
     
     for (size_t i = 0; i < OAM.size(); i++) 
     {
         OAM[i] = readMemory(base + static_cast<uint16_t>(i));
     }
-    
-    // After copy, check if any sprites are non-zero
-    if (dma_count <= 10) {
-        int non_zero = 0;
-        for (size_t i = 0; i < OAM.size(); i += 4) {
-            if (OAM[i] != 0 || OAM[i+1] != 0) non_zero++;
-        }
-        std::cout << "  After DMA: " << non_zero << "/40 non-zero sprites in OAM\n";
-    }
 }
 
 // ============================================================
-// READ MEMORY - CORREGIDA CON JOYPAD ARREGLADO
+// READ SLOW - PÁGINAS SIN PUNTERO DIRECTO (CORREGIDA CON JOYPAD)
 // ============================================================
-uint8_t mmu::readMemory(uint16_t address) 
+uint8_t mmu::readSlow(uint16_t address) 
 {   
+#ifdef GB_MEM_HEATMAP
+    if (address >= 0xFF00 && address <= 0xFF7F) heatmap.countIO(address, false);
+#endif
+
     // Interrupciones (Registro IF e IE)
     // IF usa IO[0x0F] directamente - bits 5-7 siempre retornan 1
     if (address == 0xFF0F) {
         uint8_t result = IO[0x0F] | 0xE0;
-        // DEBUG: Log cuando IF tiene VBlank activo
-        static int if_read_vblank_count = 0;
-        if ((IO[0x0F] & 0x01) && if_read_vblank_count < 20) {
-            if_read_vblank_count++;
-            std::cout << "[MMU] IF read while VBlank active! Returning 0x" 
-                      << std::hex << (int)result << std::dec << "\n";
-        }
+        GB_TRACE_ACCESS(Irq, "if_read", { trace::hex("value", result) });
         return result;
     }
-    if (address == 0xFFFF) return IE;
+    if (address == 0xFFFF) { GB_MEM_COUNT(hram_reads); return IE; }
     
     // ROM (Cartucho)
     if (address <= 0x7FFF) {   
@@ -97,7 +317,7 @@ uint8_t mmu::readMemory(uint16_t address)
     else if (address >= 0x8000 && address <= 0x9FFF) {
         // TODO: Verificar si PPU está en modo 3 (Drawing)
         // Durante modo 3, VRAM no es accesible
-        return VRAM[offSet(address, 0x8000)];
+        return VRAM.read(offSet(address, 0x8000));
     }
     // RAM Externa (Cartucho)
     else if (address >= 0xA000 && address <= 0xBFFF) {
@@ -105,11 +325,11 @@ uint8_t mmu::readMemory(uint16_t address)
     }
     // WRAM (Work RAM)
     else if (address >= 0xC000 && address <= 0xDFFF) {
-        return WRAM[offSet(address, 0xC000)];
+        return WRAM.read(offSet(address, 0xC000));
     }
     // ECHO RAM (Espejo de WRAM)
     else if (address >= 0xE000 && address <= 0xFDFF) {
-        return WRAM[offSet(address, 0xE000)];
+        return WRAM.read(offSet(address, 0xE000));
     }
     // OAM (Object Attribute Memory)
     else if (address >= 0xFE00 && address <= 0xFE9F) {
@@ -124,35 +344,11 @@ uint8_t mmu::readMemory(uint16_t address)
     
     // --- I/O Registers (0xFF00 - 0xFF7F) ---
     else if (address >= 0xFF00 && address <= 0xFF7F) {
+        if (sched) sched->beforeIO(address, false);
         
-        // ============================================================
-        // HARD HOOK: LY (0xFF44) - DEBUG CRÍTICO
-        // ============================================================
         if (address == 0xFF44) {
-            uint8_t val = IO[0x44];
-            
-            // DEBUG: Log para confirmar qué ve la CPU
-            static int ly_read_count = 0;
-            static uint8_t last_ly = 0xFF;
-            ly_read_count++;
-            
-            // Log cuando LY cambia o primeras lecturas
-            if (val != last_ly || ly_read_count <= 10) {
-                if (ly_read_count <= 50 || val == 144) {
-                    std::cout << "[MMU DEBUG] Read LY (FF44) returned: " << std::dec << (int)val
-                              << " (read #" << ly_read_count << ")\n";
-                }
-                last_ly = val;
-            }
-            
-            // Log especial cuando LY llega a 144
-            static bool logged_144 = false;
-            if (val == 144 && !logged_144) {
-                std::cout << "[MMU DEBUG] *** LY=144 VISIBLE TO CPU! ***\n";
-                logged_144 = true;
-            }
-            
-            return val;
+            GB_TRACE_ACCESS(Ppu, "ly_read", { trace::dec("ly", IO[0x44]) });
+            return IO[0x44];
         }
         
         // ============================================================
@@ -189,41 +385,7 @@ uint8_t mmu::readMemory(uint16_t address)
             }
             
             result |= button_state;
-            
-            // DEBUG: Log cuando hay botones presionados (especially START)
-            static int joypad_read_count = 0;
-            static int start_detected_count = 0;
-            joypad_read_count++;
-            
-            // Log if START is pressed and buttons are being read
-            if (button_start && select_buttons) {
-                start_detected_count++;
-                if (start_detected_count <= 20) {
-                    std::cout << "[JOYPAD START!] Read #" << start_detected_count
-                              << " P1=0x" << std::hex << (int)result
-                              << " btn_state=0x" << (int)button_state
-                              << " (START should clear bit 3)" << std::dec << "\n";
-                }
-            }
-            
-            // Also log if START is pressed but wrong button group selected
-            if (button_start && !select_buttons && joypad_read_count <= 200) {
-                std::cout << "[JOYPAD MISS] START pressed but dpad selected, result=0x" 
-                          << std::hex << (int)result << std::dec << "\n";
-            }
-            
-            if (button_state != 0x0F && joypad_read_count <= 50) {
-                std::cout << "[JOYPAD] Read P1=0x" << std::hex << (int)result
-                          << " buttons=" << (int)button_state
-                          << " sel_dpad=" << select_dpad
-                          << " sel_btn=" << select_buttons
-                          << std::dec << "\n";
-            }
-            
-            // Log periódico para ver si el juego lee joypad
-            if (joypad_read_count == 1000) {
-                std::cout << "[JOYPAD] 1000 reads so far. Game IS polling joypad.\n";
-            }
+            GB_TRACE_ACCESS(Joypad, "read", { trace::hex("p1", result) });
             
             return result;
         }
@@ -245,15 +407,7 @@ uint8_t mmu::readMemory(uint16_t address)
     
     // HRAM (High RAM)
     else if (address >= 0xFF80 && address <= 0xFFFE) {
-        // DEBUG: Track reads from 0xFF85 (heavily polled in Tetris)
-        if (address == 0xFF85) {
-            static int ff85_read_count = 0;
-            ff85_read_count++;
-            if (ff85_read_count <= 10 || ff85_read_count == 1000 || ff85_read_count == 10000) {
-                std::cout << "[HRAM 0xFF85] Read #" << ff85_read_count 
-                          << " value=0x" << std::hex << (int)HRAM[0x05] << std::dec << "\n";
-            }
-        }
+        GB_MEM_COUNT(hram_reads);
         return HRAM[offSet(address, 0xFF80)];
     }
     
@@ -262,10 +416,14 @@ uint8_t mmu::readMemory(uint16_t address)
 }
 
 // ============================================================
-// WRITE MEMORY - CORREGIDA
+// WRITE SLOW - PÁGINAS SIN PUNTERO DIRECTO (CORREGIDA)
 // ============================================================
-void mmu::writeMemory(uint16_t address, uint8_t value) 
+void mmu::writeSlow(uint16_t address, uint8_t value) 
 {
+#ifdef GB_MEM_HEATMAP
+    if (address >= 0xFF00 && address <= 0xFF7F) heatmap.countIO(address, true);
+#endif
+
     // Interrupciones y DMA (Interceptar antes)
     if (address == 0xFF46) { DMA(value); return; }
     // IF usa IO[0x0F] directamente - SEMÁNTICA ESPECIAL
@@ -274,20 +432,12 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
     // - Software LIMPIA bits escribiendo 1s (acknowledge)
     // Pero muchos juegos simplemente sobrescriben, así que usamos escritura directa
     if (address == 0xFF0F) { 
-        // DEBUG: Rastrear escrituras a IF
-        static int if_write_count = 0;
-        if_write_count++;
-        if (if_write_count <= 20) {
-            std::cout << "[MMU IF WRITE #" << if_write_count 
-                      << "] value=0x" << std::hex << (int)value
-                      << " IO[0x0F] was 0x" << (int)IO[0x0F]
-                      << std::dec << "\n";
-        }
+        GB_TRACE_ACCESS(Irq, "if_write", { trace::hex("value", value), trace::hex("prev", IO[0x0F]) });
         // Solo bits 0-4 son válidos
         IO[0x0F] = value & 0x1F; 
         return; 
     }
-    if (address == 0xFFFF) { IE = value & 0x1F; return; } // Solo bits 0-4
+    if (address == 0xFFFF) { GB_MEM_COUNT(hram_writes); IE = value & 0x1F; return; } // Solo bits 0-4
 
     // Zona Prohibida (Ignorar)
     if (address >= 0xFEA0 && address <= 0xFEFF) {
@@ -296,42 +446,47 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
 
     // ROM (Banking en el cartucho)
     if (address <= 0x7FFF) {
+        BankMap before = cart.bankMap();
         cart.writeCartridge(address, value);
+        BankMap after = cart.bankMap();
+        // Cambio de banco: otra ROM en 0x4000 u otro banco de RAM
+        // (habilitar/deshabilitar la RAM no cuenta)
+        if (after.romx != before.romx ||
+            (after.ram >= 0 && before.ram >= 0 && after.ram != before.ram)) {
+            bank_switches++;
+            if (trace_timeline)
+                trace_timeline->instant(timeline::Memory, "bank_switch", "rom_bank", cart.currentRomBank());
+        }
+        mapCartPages();
+        code_epoch++; // Posible cambio de banco: la CPU revalida su bloque actual
         return;
     }
     // VRAM
     else if (address >= 0x8000 && address <= 0x9FFF) {
         // TODO: Verificar si PPU está en modo 3 (Drawing)
         // Durante modo 3, ignorar escrituras
-        VRAM[offSet(address, 0x8000)] = value;
+        uint16_t offset = offSet(address, 0x8000);
+        int      index  = offset >> 8;
+        uint8_t* page   = VRAM.own(index);
+        page[offset & 0xFF] = value;
+        if (offset < 0x1800) tiles.update(offset, page);
+        // Copia de una página compartida (o mapa de tiles que vuelve a ser propio)
+        if (read_page[0x80 + index] != page || index >= 0x18) mapVramPage(index);
         return;
     }
     // RAM Externa
     else if (address >= 0xA000 && address <= 0xBFFF) {
         cart.writeCartridge(address, value);
+        // Página compartida que acaba de copiarse: republicar los punteros
+        if (cart.bankMap().ram >= 0) mapCartPages();
         return;
     }
-    // WRAM
-    else if (address >= 0xC000 && address <= 0xDFFF) {
-        // DEBUG: Track writes to sprite buffer area (0xC000-0xC09F)
-        static int sprite_buffer_writes = 0;
-        if (address >= 0xC000 && address <= 0xC09F && value != 0) {
-            sprite_buffer_writes++;
-            if (sprite_buffer_writes <= 20) {
-                std::cout << "[WRAM SPRITE BUFFER] Write #" << sprite_buffer_writes
-                          << " to 0x" << std::hex << address 
-                          << " = 0x" << (int)value << std::dec << "\n";
-            }
-            if (sprite_buffer_writes == 100) {
-                std::cout << "[WRAM SPRITE BUFFER] 100 writes to sprite buffer area!\n";
-            }
-        }
-        WRAM[offSet(address, 0xC000)] = value;
-        return;
-    }
-    // ECHO RAM (Escribir en WRAM correspondiente)
-    else if (address >= 0xE000 && address <= 0xFDFF) {
-        WRAM[offSet(address, 0xE000)] = value;
+    // WRAM y ECHO RAM (Escribir en WRAM correspondiente)
+    else if (address >= 0xC000 && address <= 0xFDFF) {
+        uint16_t offset = (address <= 0xDFFF) ? offSet(address, 0xC000) : offSet(address, 0xE000);
+        if (WRAM_code[offset]) invalidateCode();
+        WRAM.own(offset >> 8)[offset & 0xFF] = value;
+        mapWramPage(offset >> 8);
         return;
     }
     // OAM
@@ -343,20 +498,13 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
     }
     // I/O Registers
     else if (address >= 0xFF00 && address <= 0xFF7F) {
+        if (sched) sched->beforeIO(address, true);
+
         // ============================================================
         // JOYPAD (0xFF00) - ESCRITURA CORRECTA
         // ============================================================
         if (address == 0xFF00) {
-            // DEBUG: Track P1 writes
-            static int p1_write_count = 0;
-            p1_write_count++;
-            if (p1_write_count <= 20) {
-                std::cout << "[JOYPAD WRITE #" << p1_write_count << "] value=0x" 
-                          << std::hex << (int)value 
-                          << " (select_dpad=" << !(value & 0x10)
-                          << " select_btn=" << !(value & 0x20)
-                          << ")" << std::dec << "\n";
-            }
+            GB_TRACE_ACCESS(Joypad, "select", { trace::hex("value", value) });
             
             // Solo bits 4 y 5 son escribibles
             // Mantener bits 0-3 (estado de botones) y bits 6-7 (siempre 1)
@@ -367,12 +515,7 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
         // Escritura especial para DIV (0xFF04)
         if (address == 0xFF04) {
             // Escribir CUALQUIER valor a DIV lo resetea a 0
-            static int div_reset_count = 0;
-            div_reset_count++;
-            if (div_reset_count <= 20) {
-                std::cout << "[MMU] DIV (0xFF04) reset to 0! (write #" << div_reset_count 
-                          << ", was 0x" << std::hex << (int)IO[0x04] << ")\n" << std::dec;
-            }
+            GB_TRACE_ACCESS(Timer, "div_reset", { trace::hex("prev", IO[0x04]) });
             IO[0x04] = 0;
             return;
         }
@@ -393,38 +536,8 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
     }
     // HRAM
     else if (address >= 0xFF80 && address <= 0xFFFE) {
-        // DEBUG: Track writes to 0xFF85 (VBLANK_DONE)
-        if (address == 0xFF85) {
-            static int ff85_write_count = 0;
-            ff85_write_count++;
-            if (ff85_write_count <= 20) {
-                std::cout << "[HRAM 0xFF85] Write #" << ff85_write_count 
-                          << " value=0x" << std::hex << (int)value << std::dec << "\n";
-            }
-        }
-        
-        // DEBUG: Track writes to 0xFF99 (GAME_STATUS) - CRITICAL for state machine
-        if (address == 0xFF99) {
-            static int game_status_write_count = 0;
-            game_status_write_count++;
-            
-            const char* state_name = "UNKNOWN";
-            switch (value) {
-                case 36: state_name = "MENU_COPYRIGHT_INIT"; break;
-                case 37: state_name = "MENU_COPYRIGHT_1"; break;
-                case 53: state_name = "MENU_COPYRIGHT_2"; break;
-                case 6:  state_name = "MENU_TITLE_INIT"; break;
-                case 7:  state_name = "MENU_TITLE"; break;
-                case 8:  state_name = "MENU_GAME_TYPE"; break;
-                case 20: state_name = "PLAYING"; break;
-            }
-            
-            std::cout << "[GAME_STATUS WRITE #" << game_status_write_count 
-                      << "] value=" << std::dec << (int)value 
-                      << " (" << state_name << ")" 
-                      << " addr=0x" << std::hex << address << std::dec << "\n";
-        }
-        
+        GB_MEM_COUNT(hram_writes);
+        if (HRAM_code[offSet(address, 0xFF80)]) invalidateCode();
         HRAM[offSet(address, 0xFF80)] = value;
         return;
     }
@@ -438,12 +551,7 @@ void mmu::writeMemory(uint16_t address, uint8_t value)
 // Button IDs: 0=Right, 1=Left, 2=Up, 3=Down, 4=A, 5=B, 6=Select, 7=Start
 // ============================================================
 void mmu::setButton(int button_id, bool pressed) {
-    const char* button_names[] = {"RIGHT", "LEFT", "UP", "DOWN", "A", "B", "SELECT", "START"};
-    
-    if (button_id >= 0 && button_id <= 7) {
-        std::cout << "[JOYPAD_BACKEND] setButton(" << button_names[button_id] 
-                  << ", " << (pressed ? "PRESSED" : "RELEASED") << ")\n";
-    }
+    GB_TRACE_EVENT(Joypad, "button", { trace::dec("id", button_id), trace::dec("pressed", pressed) });
     
     switch(button_id) {
         case 0: button_right = pressed; break;
@@ -10,12 +10,31 @@
 #include <vector>
 
 #include "cartridge/cartridge.h"
+#include "paged_ram.h"
+#include "ppu/tile_cache.h"
+#include "perf/perf_stats.h"
+#ifdef GB_COVERAGE
+#include "coverage/rom_coverage.h"
+#endif
+#ifdef GB_MEM_HEATMAP
+#include "perf/mem_heatmap.h"
+#endif
+
+// Accesos del bus por página: solo con GB_MEM_HEATMAP, para que la build
+// normal no pague un incremento en cada lectura y escritura
+#ifdef GB_MEM_HEATMAP
+#define GB_MEM_COUNT(counter) (counter)++
+#else
+#define GB_MEM_COUNT(counter) ((void)0)
+#endif
 
 class ppu; // Forward declaration
 class timer; // Forward declaration
 class cpu; // Forward declaration
 class emcc_main; // Forward declaration
 class APU; // Forward declaration - Audio Processing Unit
+class scheduler; // Forward declaration
+class timeline; // Forward declaration
 
 class mmu
 {
@@ -23,13 +42,72 @@ class mmu
     friend class timer;
     friend class cpu;
     friend class emcc_main;
+    friend class scheduler;
     
 public:
     // Constructor explícito que recibe la ruta
     explicit mmu(const std::string& romPath);
 
-    uint8_t readMemory(uint16_t address);
-    void writeMemory(uint16_t address, uint8_t value);
+    // ============================================================
+    // MODO RAM PLANA (tests de la CPU)
+    // ============================================================
+    // 64 KB lineales sin cartucho ni registros de I/O: toda la tabla de
+    // páginas apunta a flatRam(), así que readSlow/writeSlow no se usan.
+    // Lo usan los tests de un solo paso (tests/cpu_conformance.cpp).
+    struct FlatRam {};
+    explicit mmu(FlatRam);
+
+    uint8_t* flatRam() { return flat_ram.empty() ? nullptr : flat_ram.data(); }
+
+    // ============================================================
+    // FORK (gameboy::fork)
+    // ============================================================
+    // Comparte con 'parent' la ROM y las páginas de VRAM, WRAM y RAM
+    // externa; cada lado copia una página la primera vez que escribe en
+    // ella. El resto (I/O, OAM, HRAM, registros del MBC) llega con el
+    // save state del padre. Retira también los punteros de escritura
+    // del padre a las páginas que ahora comparte.
+    struct Fork {};
+    mmu(mmu& parent, Fork);
+
+    // Páginas de 256 bytes de RAM (VRAM + WRAM + externa) que son
+    // propias de esta máquina y no compartidas con otra
+    size_t ownedRamPages() const;
+
+    // La tabla de páginas apunta a los arrays de esta instancia
+    mmu(const mmu&) = delete;
+    mmu& operator=(const mmu&) = delete;
+
+    // ============================================================
+    // TABLA DE PÁGINAS (256 páginas de 256 bytes)
+    // ============================================================
+    // Las regiones planas (ROM, RAM externa, VRAM, WRAM, echo) se
+    // resuelven con un solo acceso indexado. Las páginas con nullptr
+    // (I/O, registros del MBC, RTC o RAM externa deshabilitada, OAM y
+    // zona prohibida, código cacheado) pasan por readSlow/writeSlow
+    // con toda su lógica especial. La página 0xFF mezcla I/O y HRAM:
+    // HRAM (0xFF80-0xFFFE) se resuelve aquí mismo salvo que tenga
+    // código cacheado, e I/O e IE siguen por el camino lento.
+    uint8_t readMemory(uint16_t address)
+    {
+#ifdef GB_COVERAGE
+        if (address < 0x8000) coverage.mark(rom_coverage::Data, address, currentRomBank());
+#endif
+        return readBus(address);
+    }
+
+    void writeMemory(uint16_t address, uint8_t value)
+    {
+        GB_MEM_COUNT(page_writes[address >> 8]);
+        uint8_t* page = write_page[address >> 8];
+        if (page) { page[address & 0xFF] = value; return; }
+        if (address >= 0xFF80 && address != 0xFFFF && !HRAM_code[address - 0xFF80]) {
+            GB_MEM_COUNT(hram_writes);
+            HRAM[address - 0xFF80] = value;
+            return;
+        }
+        writeSlow(address, value);
+    }
     
     // ============================================================
     // NUEVA: Función para establecer estado de botones
@@ -41,22 +119,117 @@ public:
     // ============================================================
     void setAPU(APU* apu_ptr);
 
+    // Scheduler: sincroniza PPU/timer/APU antes de tocar sus registros
+    void setScheduler(scheduler* sched_ptr) { sched = sched_ptr; }
+
+    // Timeline opcional: DMA y cambios de banco (nullptr = apagado)
+    void setTimeline(timeline* tl) { trace_timeline = tl; }
+
+    bool cartridgeLoaded() const { return cart.isLoaded(); }
+
+    // ============================================================
+    // SAVE STATE
+    // ============================================================
+    // RAM interna, I/O, OAM, IE y el cartucho (RAM externa + MBC). Los
+    // botones no se guardan: son entrada del host. loadState reconstruye
+    // la caché de tiles y la tabla de páginas, e invalida el código
+    // cacheado de RAM. Sin 'with_ram' se omiten VRAM, WRAM y la RAM
+    // externa (STATE_NO_RAM).
+    void saveState(state_writer& out, bool with_ram) const;
+    bool loadState(state_reader& in, bool with_ram);
+
+    // VRAM, WRAM y RAM externa al hash del estado (gameboy::stateHash),
+    // sin pasar por un buffer
+    void hashRam(state_hasher& out) const;
+
+    void stampState(state_header& header) const       { cart.stampState(header); }
+    bool matchesState(const state_header& header) const { return cart.matchesState(header); }
+
+    // ============================================================
+    // SOPORTE PARA LA CACHÉ DE BLOQUES DE LA CPU
+    // ============================================================
+    // codeEpoch cambia con cualquier escritura a los registros del MBC
+    // (posible cambio de banco) o a un byte de RAM marcado como código.
+    // ramCodeEpoch solo cambia en el segundo caso (código automodificable).
+    uint16_t currentRomBank() const { return cart.currentRomBank(); }
+
+    uint32_t codeEpoch()      const { return code_epoch; }
+    uint32_t ramCodeEpoch()   const { return ram_code_epoch; }
+    void     markCode(uint16_t address);
+
+    // Lectura para decodificar bloques: no es un acceso de la CPU, así
+    // que no cuenta en la telemetría ni en la cobertura
+    uint8_t peek(uint16_t address)
+    {
+        const uint8_t* page = read_page[address >> 8];
+        if (page) return page[address & 0xFF];
+        return readSlow(address);
+    }
+
+#ifdef GB_COVERAGE
+    // ============================================================
+    // COBERTURA DE ROM (solo con GB_COVERAGE)
+    // ============================================================
+    // Lectura de la CPU como opcode u operando: cuenta como código y
+    // no como dato. Con la caché de bloques la CPU marca con romCoverage().
+    uint8_t readCode(uint16_t address, rom_coverage::Kind kind)
+    {
+        if (address < 0x8000) coverage.mark(kind, address, currentRomBank());
+        return readBus(address);
+    }
+
+    rom_coverage&       romCoverage()       { return coverage; }
+    const rom_coverage& romCoverage() const { return coverage; }
+#endif
+
+    // ============================================================
+    // TELEMETRÍA (gb_perf_stats)
+    // ============================================================
+    // Suma los contadores por región desde la última llamada y los
+    // pone a cero (gameboy lo llama al final de cada frame). Sin
+    // GB_MEM_HEATMAP los accesos por región quedan a cero.
+    void collectStats(gb_perf_stats& stats);
+
+    // false = los accesos no marcan cobertura de ROM y collectStats no
+    // suma el frame al mapa de calor (frames ocultos del run-ahead,
+    // que luego se deshacen)
+    void setTracking(bool on);
+
+#ifdef GB_MEM_HEATMAP
+    // Detalle por página y registro de I/O (solo con GB_MEM_HEATMAP);
+    // collectStats cierra también su frame
+    mem_heatmap&       memHeatmap()       { return heatmap; }
+    const mem_heatmap& memHeatmap() const { return heatmap; }
+#endif
+
 private:
     // Instancia del cartucho
     cartridge cart;
+
+#ifdef GB_COVERAGE
+    // Se construye después del cartucho (necesita el número de bancos)
+    rom_coverage coverage;
+#endif
     
     // Puntero a la APU (Audio)
     APU* apu = nullptr;
 
-    // Regiones de memoria interna
-    std::array<uint8_t, 0x2000> VRAM; // 8KB Video RAM
-    std::array<uint8_t, 0x2000> WRAM; // 8KB Work RAM
+    // Puntero al scheduler (nullptr = sin sincronización perezosa)
+    scheduler* sched = nullptr;
+
+    timeline* trace_timeline = nullptr;
+
+    // Regiones de memoria interna (VRAM y WRAM en páginas copy-on-write)
+    paged_ram VRAM{ 0x2000 };         // 8KB Video RAM
+    paged_ram WRAM{ 0x2000 };         // 8KB Work RAM
     std::array<uint8_t, 0x007F> HRAM; // 127 bytes High RAM
     std::array<uint8_t, 0x0080> IO;   // 128 bytes I/O
     std::array<uint8_t, 0x00A0> OAM;  // Object Attribute Memory
 
+    // Tiles de 0x8000-0x97FF ya decodificados (los lee la PPU)
+    tile_cache tiles;
+
     uint8_t IE; // Interrupt Enable (0xFFFF)
-    uint8_t IF; // Interrupt Flag (0xFF0F)
     
     // ============================================================
     // NUEVAS: Variables para el estado de los botones
@@ -70,9 +243,58 @@ private:
     bool button_select = false;
     bool button_start = false;
     
+    // Bytes de WRAM/HRAM que forman parte de un bloque cacheado por la CPU
+    std::array<uint8_t, 0x2000> WRAM_code;
+    std::array<uint8_t, 0x007F> HRAM_code;
+    std::array<uint8_t, 0x20>   WRAM_code_pages;   // Páginas de WRAM con alguna marca
+    uint32_t code_epoch = 0;
+    uint32_t ram_code_epoch = 0;
+
+    uint32_t bank_switches = 0;
+    uint32_t dma_transfers = 0;
+
+#ifdef GB_MEM_HEATMAP
+    // Accesos del bus por página (y la parte HRAM/IE de la página 0xFF)
+    std::array<uint32_t, 256> page_reads{};
+    std::array<uint32_t, 256> page_writes{};
+    uint32_t hram_reads    = 0;
+    uint32_t hram_writes   = 0;
+
+    mem_heatmap heatmap;
+    bool        tracking = true;
+#endif
+
+    std::array<const uint8_t*, 256> read_page;
+    std::array<uint8_t*, 256>       write_page;
+
+    std::vector<uint8_t> flat_ram;   // Solo en modo RAM plana
+
+    // Lectura del bus sin marcar cobertura (readMemory y readCode)
+    uint8_t readBus(uint16_t address)
+    {
+        GB_MEM_COUNT(page_reads[address >> 8]);
+        const uint8_t* page = read_page[address >> 8];
+        if (page) return page[address & 0xFF];
+        if (address >= 0xFF80 && address != 0xFFFF) {
+            GB_MEM_COUNT(hram_reads);
+            return HRAM[address - 0xFF80];
+        }
+        return readSlow(address);
+    }
+
+    uint8_t readSlow(uint16_t address);
+    void    writeSlow(uint16_t address, uint8_t value);
+    void    mapPages();      // Tabla completa (constructor)
+    void    mapCartPages();  // ROM y RAM externa, tras escribir en el MBC
+    void    mapRamWrites();  // WRAM/echo escribibles (sin marcas de código)
+    void    mapVramPage(int index);  // Tras copiar una página compartida
+    void    mapWramPage(int index);
+
     // Funciones auxiliares privadas
+    void clearMemory();   // Estado de encendido de la RAM interna y los registros
     uint16_t offSet(uint16_t address, uint16_t base);
     void DMA(uint8_t value);
+    void invalidateCode();
 };
 
 // ============================================================
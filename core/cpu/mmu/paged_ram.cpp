@@ -0,0 +1,101 @@
+#include "paged_ram.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+// --- Constructores ---
+paged_ram::paged_ram(size_t size_bytes)
+    : pages((size_bytes + PAGE_SIZE - 1) / PAGE_SIZE)
+    , bytes(size_bytes)
+{
+    for (block*& b : pages) {
+        b = new block;
+        std::memset(b->data, 0, PAGE_SIZE);
+    }
+}
+
+paged_ram::paged_ram(const paged_ram& other)
+    : pages(other.pages)
+    , bytes(other.bytes)
+{
+    for (block* b : pages) b->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+paged_ram::paged_ram(paged_ram&& other) noexcept
+{
+    pages.swap(other.pages);
+    std::swap(bytes, other.bytes);
+}
+
+paged_ram& paged_ram::operator=(paged_ram&& other) noexcept
+{
+    pages.swap(other.pages);
+    std::swap(bytes, other.bytes);
+    return *this;
+}
+
+paged_ram::~paged_ram()
+{
+    for (block* b : pages) release(b);
+}
+
+void paged_ram::release(block* b)
+{
+    if (b->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete b;
+}
+
+// ============================================================
+// COPY-ON-WRITE
+// ============================================================
+uint8_t* paged_ram::copyPage(size_t index)
+{
+    block* shared = pages[index];
+    block* copy = new block;
+    std::memcpy(copy->data, shared->data, PAGE_SIZE);
+    pages[index] = copy;
+    release(shared);
+    return copy->data;
+}
+
+void paged_ram::fill(uint8_t value)
+{
+    for (size_t i = 0; i < pages.size(); i++) std::memset(own(i), value, PAGE_SIZE);
+}
+
+size_t paged_ram::ownedPages() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < pages.size(); i++) count += !isShared(i);
+    return count;
+}
+
+// ============================================================
+// SAVE STATE
+// ============================================================
+// La última página puede estar a medias (RAM externa de 2 KB)
+void paged_ram::saveState(state_writer& out) const
+{
+    for (size_t i = 0; i < pages.size(); i++)
+        out.bytes(pages[i]->data, std::min(PAGE_SIZE, bytes - i * PAGE_SIZE));
+}
+
+void paged_ram::hash(state_hasher& out) const
+{
+    for (size_t i = 0; i < pages.size(); i++)
+        out.update(pages[i]->data, std::min(PAGE_SIZE, bytes - i * PAGE_SIZE));
+}
+
+bool paged_ram::loadState(state_reader& in)
+{
+    for (size_t i = 0; i < pages.size(); i++) {
+        // Una página compartida se reemplaza entera: no hace falta copiarla
+        if (isShared(i)) {
+            release(pages[i]);
+            pages[i] = new block;
+            std::memset(pages[i]->data, 0, PAGE_SIZE);
+        }
+        if (!in.bytes(pages[i]->data, std::min(PAGE_SIZE, bytes - i * PAGE_SIZE))) return false;
+    }
+    return true;
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "state/state_hash.h"
+#include "state/state_io.h"
+
+// ============================================================
+// PAGED_RAM - RAM en páginas de 256 bytes con copy-on-write
+// ============================================================
+// Almacén de VRAM, WRAM y RAM externa. Cada página lleva un contador
+// de referencias atómico: copiar un paged_ram (gameboy::fork) comparte
+// todas las páginas, y la primera escritura en una página compartida
+// la duplica solo para quien escribe. Las páginas coinciden con las de
+// la tabla de páginas del MMU, así que una página compartida no tiene
+// puntero de escritura y su primer write pasa por writeSlow.
+//
+// Las máquinas que comparten páginas pueden correr en hilos distintos:
+// nadie escribe en una página con más de una referencia, y own()
+// suelta la vieja con acq_rel después de copiarla.
+// ============================================================
+
+class paged_ram
+{
+public:
+    static constexpr size_t PAGE_SIZE = 0x100;
+
+    paged_ram() = default;
+    explicit paged_ram(size_t bytes);            // Páginas propias a 0
+
+    paged_ram(const paged_ram& other);           // Comparte todas las páginas
+    paged_ram& operator=(const paged_ram&) = delete;
+    paged_ram(paged_ram&& other) noexcept;
+    paged_ram& operator=(paged_ram&& other) noexcept;
+    ~paged_ram();
+
+    size_t size()      const { return bytes; }
+    bool   empty()     const { return bytes == 0; }
+    size_t pageCount() const { return pages.size(); }
+
+    // Lectura (válida hasta el próximo own de esa página)
+    const uint8_t* page(size_t index) const { return pages[index]->data; }
+    uint8_t read(size_t offset) const { return pages[offset >> 8]->data[offset & 0xFF]; }
+
+    // Página escribible si ya es propia; nullptr si está compartida
+    uint8_t* ownedPage(size_t index)
+    {
+        return isShared(index) ? nullptr : pages[index]->data;
+    }
+
+    // Hace propia la página (copiándola si hace falta) y la devuelve.
+    // El puntero puede cambiar: quien lo tenga publicado debe remapear.
+    uint8_t* own(size_t index)
+    {
+        return isShared(index) ? copyPage(index) : pages[index]->data;
+    }
+
+    void write(size_t offset, uint8_t value) { own(offset >> 8)[offset & 0xFF] = value; }
+
+    void fill(uint8_t value);
+
+    // Páginas con una sola referencia (memoria propia de esta máquina)
+    size_t ownedPages() const;
+
+    // Save state: los bytes tal cual, página tras página
+    void saveState(state_writer& out) const;
+    bool loadState(state_reader& in);
+
+    // Los mismos bytes que saveState, directo al hash
+    void hash(state_hasher& out) const;
+
+private:
+    struct block {
+        std::atomic<uint32_t> refs{ 1 };
+        uint8_t data[PAGE_SIZE];
+    };
+
+    std::vector<block*> pages;
+    size_t bytes = 0;
+
+    bool isShared(size_t index) const
+    {
+        return pages[index]->refs.load(std::memory_order_acquire) != 1;
+    }
+
+    uint8_t*    copyPage(size_t index);
+    static void release(block* b);
+};
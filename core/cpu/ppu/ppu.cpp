@@ -3,6 +3,7 @@
 // ============================================================
 
 #include "ppu.h"
+#include "trace/trace.h"
 #include <algorithm>
 #include <iostream>
 #include <iomanip>
@@ -46,8 +47,48 @@ void ppu::debug_mode_change(uint8_t, uint8_t)    {}
 // ============================================================
 void ppu::step(int cpu_cycles)
 {
-    for (int i = 0; i < cpu_cycles; i++)
+    // LCD apagado: step_one_dot() solo resetea el estado, una vez basta
+    if (!(memory.IO[0x40] & 0x80)) {
+        if (cpu_cycles > 0) step_one_dot();
+        return;
+    }
+
+    while (cpu_cycles > 0)
+    {
+        // Dots "quietos" antes del próximo evento: solo avanzan los contadores
+        int quiet = std::min(cycles_until_event() - 1, cpu_cycles);
+        if (quiet > 0) {
+            dots_counter  += quiet;
+            scanline_dots += quiet;
+            cpu_cycles    -= quiet;
+            continue;
+        }
+
         step_one_dot();
+        cpu_cycles--;
+    }
+}
+
+// ============================================================
+// CYCLES UNTIL EVENT
+// ============================================================
+// step_one_dot() solo hace algo cuando el dot que procesa cae en una
+// frontera de la línea: dot 1 (entrada a modo 2 o VBlank), 81 (modo 3),
+// 253 (HBlank) y 456 (fin de línea, LY/LYC).
+int ppu::cycles_until_event() const
+{
+    if (!(memory.IO[0x40] & 0x80)) return 456; // LCD apagado: sin eventos
+
+    static const int visible[] = { 1, 81, 253, 456 };
+    static const int vblank[]  = { 1, 456 };
+
+    const int* bounds = (current_line < 144) ? visible : vblank;
+    int count         = (current_line < 144) ? 4 : 2;
+
+    for (int i = 0; i < count; i++) {
+        if (bounds[i] > scanline_dots) return bounds[i] - scanline_dots;
+    }
+    return 1;
 }
 
 // ============================================================
@@ -120,12 +161,8 @@ void ppu::step_one_dot()
                 vblank_irq_fired = true;
                 frame_complete   = true;
 
-                static int vblank_count = 0;
-                vblank_count++;
-                if (vblank_count <= 10 || vblank_count % 60 == 0)
-                    std::cout << "[PPU] VBlank #" << vblank_count
-                              << " fired! IF=0x" << std::hex << (int)memory.IO[0x0F]
-                              << " LY=" << std::dec << (int)current_line << "\n";
+                GB_TRACE_EVENT(Ppu, "vblank", { trace::hex("if", memory.IO[0x0F]),
+                                                trace::dec("ly", current_line) });
             }
             update_stat_interrupt();
         }
@@ -203,6 +240,15 @@ void ppu::draw_scanline()
     uint8_t lcdc = memory.IO[0x40];
     uint8_t ly   = current_line;
 
+    // Sin render (frames ocultos del run-ahead) solo avanza el estado
+    // que draw_window deja para las líneas siguientes
+    if (!render_enabled) {
+        if ((lcdc & 0x81) == 0x81 && window_on_line()) window_line_counter++;
+        return;
+    }
+
+    scanlines_drawn++;
+
     if (!(lcdc & 0x80)) {
         for (int x = 0; x < 160; x++) {
             gfx[ly * 160 + x] = palette[0];
@@ -229,6 +275,17 @@ void ppu::draw_scanline()
         draw_sprites();
 }
 
+// ============================================================
+// TILE INDEX (BG / WINDOW)
+// ============================================================
+// Convierte un tile ID del mapa al índice de la caché (0-383).
+// LCDC bit 4 = 0: direccionamiento con signo desde 0x9000 (tiles 256-383
+// y 128-255); bit 4 = 1: sin signo desde 0x8000 (tiles 0-255).
+static inline int bg_tile_index(uint8_t tile_id, bool signed_tile_addr)
+{
+    return signed_tile_addr ? 256 + (int8_t)tile_id : tile_id;
+}
+
 // ============================================================
 // DRAW BACKGROUND
 // ============================================================
@@ -246,67 +303,57 @@ void ppu::draw_background()
 
     uint8_t  y_pos    = scy + ly;
     uint16_t tile_row = (y_pos / 8) * 32;
+    int      tile_y   = y_pos % 8;
 
-    for (int x = 0; x < 160; x++)
-    {
-        uint8_t  x_pos    = scx + (uint8_t)x;
-        uint16_t tile_col = x_pos / 8;
-        uint16_t map_addr = tile_map_base + tile_row + tile_col;
+    // Paleta resuelta una vez por línea
+    uint32_t colors[4];
+    for (int c = 0; c < 4; c++) colors[c] = palette[(bgp >> (c * 2)) & 0x03];
 
-        // Leer tile ID de VRAM
-        uint8_t tile_id = memory.VRAM[map_addr - 0x8000];
+    uint32_t* line = &gfx[ly * 160];
+    const uint8_t* row = nullptr;
 
-        // Calcular dirección de datos del tile
-        uint16_t tile_data_base;
-        if (signed_tile_addr)
-            tile_data_base = (uint16_t)(0x9000 + (int8_t)tile_id * 16);
-        else
-            tile_data_base = 0x8000 + (uint16_t)tile_id * 16;
-
-        // Línea dentro del tile (0-7), 2 bytes por línea
-        uint8_t tile_line = (y_pos % 8) * 2;
+    for (int x = 0; x < 160; x++)
+    {
+        uint8_t x_pos = scx + (uint8_t)x;
 
-        // Bounds check VRAM (8KB = 0x2000 bytes)
-        uint32_t vram_offset = (uint32_t)(tile_data_base - 0x8000) + tile_line;
-        if (vram_offset + 1 >= memory.VRAM.size()) {
-            gfx[ly * 160 + x] = palette[0];
-            bg_priority[x]    = 0;
-            continue;
+        // Nueva fila de tile al cruzar un borde de 8 píxeles
+        if (x == 0 || (x_pos & 7) == 0)
+        {
+            uint16_t map_addr = tile_map_base + tile_row + x_pos / 8;
+            uint8_t  tile_id  = memory.VRAM.read(map_addr - 0x8000);
+            row = memory.tiles.row(bg_tile_index(tile_id, signed_tile_addr), tile_y);
         }
 
-        uint8_t lo = memory.VRAM[vram_offset];
-        uint8_t hi = memory.VRAM[vram_offset + 1];
-
-        int color_bit = 7 - (x_pos % 8);
-        int color_num = (((hi >> color_bit) & 1) << 1) | ((lo >> color_bit) & 1);
-        int color     = (bgp >> (color_num * 2)) & 0x03;
-
-        gfx[ly * 160 + x] = palette[color];
-        bg_priority[x]     = color_num;
+        uint8_t color_num = row[x_pos & 7];
+        line[x]        = colors[color_num];
+        bg_priority[x] = color_num;
     }
 }
 
 // ============================================================
-// DRAW WINDOW  ← IMPLEMENTACIÓN NUEVA
+// DRAW WINDOW
 // ============================================================
-void ppu::draw_window()
+bool ppu::window_on_line() const
 {
-    uint8_t lcdc = memory.IO[0x40];
-
     // Bit 5 de LCDC: Window habilitada
-    if (!(lcdc & 0x20)) return;
-
-    uint8_t wy  = memory.IO[0x4A]; // Window Y position
-    uint8_t wx  = memory.IO[0x4B]; // Window X position - 7
-    uint8_t ly  = current_line;
-    uint8_t bgp = memory.IO[0x47];
+    if (!(memory.IO[0x40] & 0x20)) return false;
 
     // La Window solo se dibuja si LY >= WY
-    if (ly < wy) return;
+    if (current_line < memory.IO[0x4A]) return false;
 
     // WX < 7 es comportamiento especial / fuera de pantalla
     // WX=7 significa que la Window empieza en X=0
-    if (wx > 166) return;  // Completamente fuera de pantalla
+    return memory.IO[0x4B] <= 166;  // > 166: completamente fuera de pantalla
+}
+
+void ppu::draw_window()
+{
+    if (!window_on_line()) return;
+
+    uint8_t lcdc = memory.IO[0x40];
+    uint8_t wx  = memory.IO[0x4B]; // Window X position - 7
+    uint8_t ly  = current_line;
+    uint8_t bgp = memory.IO[0x47];
 
     // Mapa de tiles de la Window: bit 6 de LCDC → 0x9C00 : 0x9800
     uint16_t tile_map_base    = (lcdc & 0x40) ? 0x9C00 : 0x9800;
@@ -321,44 +368,29 @@ void ppu::draw_window()
     int screen_x_start = (int)wx - 7;
     if (screen_x_start < 0) screen_x_start = 0;
 
-    bool window_drawn_this_line = false;
-
-    for (int screen_x = screen_x_start; screen_x < 160; screen_x++)
-    {
-        // Posición dentro de la Window
-        int win_x = screen_x - screen_x_start;
-
-        uint16_t tile_col  = win_x / 8;
-        uint16_t map_addr  = tile_map_base + tile_row + tile_col;
+    uint32_t colors[4];
+    for (int c = 0; c < 4; c++) colors[c] = palette[(bgp >> (c * 2)) & 0x03];
 
-        uint8_t tile_id = memory.VRAM[map_addr - 0x8000];
+    uint32_t* line = &gfx[ly * 160];
 
-        // Dirección de datos del tile (mismo método que BG)
-        uint16_t tile_data_base;
-        if (signed_tile_addr)
-            tile_data_base = (uint16_t)(0x9000 + (int8_t)tile_id * 16);
-        else
-            tile_data_base = 0x8000 + (uint16_t)tile_id * 16;
-
-        uint32_t vram_offset = (uint32_t)(tile_data_base - 0x8000) + tile_y * 2;
-        if (vram_offset + 1 >= memory.VRAM.size()) continue;
-
-        uint8_t lo = memory.VRAM[vram_offset];
-        uint8_t hi = memory.VRAM[vram_offset + 1];
-
-        int color_bit = 7 - (win_x % 8);
-        int color_num = (((hi >> color_bit) & 1) << 1) | ((lo >> color_bit) & 1);
-        int color     = (bgp >> (color_num * 2)) & 0x03;
-
-        gfx[ly * 160 + screen_x] = palette[color];
-        bg_priority[screen_x]    = color_num;  // Para prioridad de sprites sobre Window
+    // La Window empieza siempre alineada a tile: se copian filas enteras
+    for (int screen_x = screen_x_start, tile_col = 0; screen_x < 160; screen_x += 8, tile_col++)
+    {
+        uint8_t tile_id = memory.VRAM.read(tile_map_base + tile_row + tile_col - 0x8000);
+        const uint8_t* row = memory.tiles.row(bg_tile_index(tile_id, signed_tile_addr), tile_y);
 
-        window_drawn_this_line = true;
+        int count = std::min(8, 160 - screen_x);
+        for (int px = 0; px < count; px++)
+        {
+            uint8_t color_num = row[px];
+            line[screen_x + px]        = colors[color_num];
+            bg_priority[screen_x + px] = color_num;  // Para prioridad de sprites sobre Window
+        }
     }
 
-    // Incrementar contador interno de la Window solo si se dibujó algo
-    if (window_drawn_this_line)
-        window_line_counter++;
+    // Incrementar contador interno de la Window (siempre se dibujó algo:
+    // screen_x_start <= 159 porque WX <= 166)
+    window_line_counter++;
 }
 
 // ============================================================
@@ -397,6 +429,8 @@ void ppu::draw_sprites()
             if (line_sprites[j].x < line_sprites[i].x)
                 std::swap(line_sprites[i], line_sprites[j]);
 
+    uint32_t* line = &gfx[ly * 160];
+
     // Renderizar en orden inverso (mayor prioridad encima)
     for (int s = sprites_on_line - 1; s >= 0; s--)
     {
@@ -421,12 +455,9 @@ void ppu::draw_sprites()
             tile_y -= 8;
         }
 
-        // Sprites siempre usan 0x8000 (unsigned)
-        uint32_t tile_addr = (uint32_t)actual_tile * 16 + (uint32_t)tile_y * 2;
-        if (tile_addr + 1 >= memory.VRAM.size()) continue;
-
-        uint8_t lo = memory.VRAM[tile_addr];
-        uint8_t hi = memory.VRAM[tile_addr + 1];
+        // Sprites siempre usan 0x8000 (unsigned); la caché ya tiene la fila volteada
+        const uint8_t* row = x_flip ? memory.tiles.row_flipped(actual_tile, tile_y)
+                                    : memory.tiles.row(actual_tile, tile_y);
 
         uint8_t pal_data = use_obp1 ? obp1 : obp0;
 
@@ -435,8 +466,7 @@ void ppu::draw_sprites()
             int screen_x = x_pos + px;
             if (screen_x < 0 || screen_x >= 160) continue;
 
-            int color_bit = x_flip ? px : (7 - px);
-            int color_num = (((hi >> color_bit) & 1) << 1) | ((lo >> color_bit) & 1);
+            int color_num = row[px];
 
             if (color_num == 0) continue;  // Transparente
 
@@ -444,7 +474,7 @@ void ppu::draw_sprites()
             if (priority && bg_priority[screen_x] != 0) continue;
 
             int color = (pal_data >> (color_num * 2)) & 0x03;
-            gfx[ly * 160 + screen_x] = palette[color];
+            line[screen_x] = palette[color];
         }
     }
 }
@@ -462,4 +492,33 @@ bool ppu::can_access_oam() const
 {
     if (!(memory.readMemory(0xFF40) & 0x80)) return true;
     return (current_mode == 0 || current_mode == 1);
-}
\ No newline at end of file
+}
+// ============================================================
+// SAVE STATE
+// ============================================================
+void ppu::saveState(state_writer& out, bool with_framebuffer) const
+{
+    out.put(dots_counter);
+    out.put(scanline_dots);
+    out.put(current_mode);
+    out.put(current_line);
+    out.put(window_line_counter);
+    out.put(frame_complete);
+    out.put(prev_stat_line);
+    out.put(vblank_irq_fired);
+    if (with_framebuffer) out.bytes(gfx.data(), gfx.size() * sizeof(uint32_t));
+}
+
+bool ppu::loadState(state_reader& in, bool with_framebuffer)
+{
+    in.get(dots_counter);
+    in.get(scanline_dots);
+    in.get(current_mode);
+    in.get(current_line);
+    in.get(window_line_counter);
+    in.get(frame_complete);
+    in.get(prev_stat_line);
+    in.get(vblank_irq_fired);
+    if (with_framebuffer) in.bytes(gfx.data(), gfx.size() * sizeof(uint32_t));
+    return in.ok();
+}
@@ -9,6 +9,10 @@ public:
     explicit ppu(mmu& mmu_ref);
 
     void step(int cpu_cycles);
+
+    // Dots hasta el próximo cambio de modo o de línea (>= 1). Entre
+    // eventos la PPU no cambia STAT/LY ni pide interrupciones.
+    int  cycles_until_event() const;
     void enable_debug(bool enable);
 
     // Estado visible para el emulador principal
@@ -22,6 +26,18 @@ public:
     int  current_mode;
     int  current_line;
 
+    // Save state: timing, STAT y la Window. El framebuffer es opcional
+    // (STATE_FRAMEBUFFER): sin él, el siguiente frame lo redibuja entero.
+    void saveState(state_writer& out, bool with_framebuffer) const;
+    bool loadState(state_reader& in, bool with_framebuffer);
+
+    // false = no dibujar en gfx (frames ocultos del run-ahead). El
+    // timing, STAT, LY y las interrupciones no cambian.
+    bool render_enabled = true;
+
+    // Líneas dibujadas desde la última lectura (gb_perf_stats)
+    uint32_t scanlines_drawn = 0;
+
 private:
     mmu& memory;
 
@@ -54,6 +70,7 @@ private:
     void draw_scanline();
     void draw_background();
     void draw_window();       // ← NUEVO
+    bool window_on_line() const;   // La Window cubre parte de la línea actual
     void draw_sprites();
     void debug_scanline_report(const char* event = nullptr);
     void debug_mode_change(uint8_t old_mode, uint8_t new_mode);
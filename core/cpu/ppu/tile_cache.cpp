@@ -0,0 +1,34 @@
+#include "tile_cache.h"
+#include "mmu/paged_ram.h"
+
+tile_cache::tile_cache()
+{
+    // VRAM arranca en 0 → todos los píxeles son color 0
+    pixels.fill(0);
+    flipped.fill(0);
+}
+
+void tile_cache::update(uint16_t offset, const uint8_t* page)
+{
+    // 16 bytes por tile, 2 bytes (lo, hi) por fila: nunca cruzan de página
+    uint16_t row_base = offset & ~1;
+    uint8_t  lo = page[row_base & 0xFF];
+    uint8_t  hi = page[(row_base & 0xFF) + 1];
+
+    uint8_t* dst  = &pixels[(row_base / 2) * 8];
+    uint8_t* dstf = &flipped[(row_base / 2) * 8];
+
+    for (int px = 0; px < 8; px++)
+    {
+        int bit   = 7 - px;
+        uint8_t c = (((hi >> bit) & 1) << 1) | ((lo >> bit) & 1);
+        dst[px]      = c;
+        dstf[7 - px] = c;
+    }
+}
+
+void tile_cache::rebuild(const paged_ram& vram)
+{
+    for (uint16_t offset = 0; offset < TILE_COUNT * 16; offset += 2)
+        update(offset, vram.page(offset >> 8));
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+class paged_ram; // Forward declaration
+
+// ============================================================
+// TILE_CACHE - Tiles de VRAM decodificados (índices de color 0-3)
+// ============================================================
+// Los 384 tiles de 0x8000-0x97FF (DMG) guardados ya decodificados:
+// 8 filas x 8 píxeles, un byte por píxel con el color_num 2bpp, más
+// una copia con cada fila volteada en horizontal para los sprites.
+//
+// El MMU la mantiene al día: cada escritura en los datos de tiles
+// redecodifica solo la fila afectada. La PPU lee filas completas y
+// solo aplica la paleta.
+// ============================================================
+
+class tile_cache
+{
+public:
+    static constexpr int TILE_COUNT = 384;
+
+    tile_cache();
+
+    // Redecodifica la fila que contiene el byte 'offset' (0x0000-0x17FF).
+    // 'page' es la página de 256 bytes de VRAM que contiene ese byte.
+    void update(uint16_t offset, const uint8_t* page);
+
+    // Redecodifica todo (p. ej. tras restaurar VRAM de golpe)
+    void rebuild(const paged_ram& vram);
+
+    // Fila 'row' (0-7) del tile 'tile' (0-383): 8 índices de color
+    const uint8_t* row(int tile, int row) const         { return &pixels[(tile * 8 + row) * 8]; }
+    const uint8_t* row_flipped(int tile, int row) const { return &flipped[(tile * 8 + row) * 8]; }
+
+private:
+    std::array<uint8_t, TILE_COUNT * 64> pixels;
+    std::array<uint8_t, TILE_COUNT * 64> flipped;
+};
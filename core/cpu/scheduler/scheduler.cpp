@@ -0,0 +1,220 @@
+#include "scheduler.h"
+
+#include <chrono>
+
+#include "mmu.h"
+#include "ppu/ppu.h"
+#include "timer/timer.h"
+#include "APU/apu.h"
+#include "state/state_io.h"
+
+// --- Constructor ---
+scheduler::scheduler(mmu& mmu_ref, ppu& ppu_ref, timer& timer_ref, APU& apu_ref)
+    : memory(mmu_ref)
+    , video(ppu_ref)
+    , clock(timer_ref)
+    , apu(apu_ref)
+{
+    when.fill(NEVER);
+
+    schedulePpu();
+    scheduleTimer();
+    schedule(Event::ApuFrameSequencer, FRAME_SEQUENCER_CYCLES);
+}
+
+// ============================================================
+// COLA DE EVENTOS
+// ============================================================
+void scheduler::schedule(Event e, uint64_t time)
+{
+    when[static_cast<size_t>(e)] = time;
+    updateNext();
+}
+
+void scheduler::cancel(Event e)
+{
+    when[static_cast<size_t>(e)] = NEVER;
+    updateNext();
+}
+
+void scheduler::updateNext()
+{
+    next_time = NEVER;
+    for (uint64_t t : when) {
+        if (t < next_time) next_time = t;
+    }
+}
+
+void scheduler::runDueEvents()
+{
+    while (next_time <= current)
+    {
+        // Evento más antiguo primero (a igualdad, el de menor índice)
+        size_t due = 0;
+        for (size_t i = 1; i < when.size(); i++) {
+            if (when[i] < when[due]) due = i;
+        }
+
+        when[due] = NEVER;
+        onEvent(static_cast<Event>(due));
+        updateNext();
+    }
+}
+
+void scheduler::onEvent(Event e)
+{
+    switch (e)
+    {
+        case Event::PpuMode:
+            syncPpu();
+            schedulePpu();
+            break;
+
+        case Event::TimerOverflow:
+            syncTimer();
+            scheduleTimer();
+            break;
+
+        case Event::ApuFrameSequencer:
+            syncApu();
+            when[static_cast<size_t>(Event::ApuFrameSequencer)] = current + FRAME_SEQUENCER_CYCLES;
+            break;
+
+        case Event::SerialShift:
+            // Sin cable conectado: se reciben 1s y la transferencia termina
+            memory.IO[0x01] = 0xFF;
+            memory.IO[0x02] &= 0x7F;
+            memory.IO[0x0F] |= 0x08;   // IF bit 3 (Serial)
+            break;
+
+        default:
+            break;
+    }
+}
+
+// El evento de la PPU se mide desde el punto hasta el que ya avanzó
+void scheduler::schedulePpu()
+{
+    when[static_cast<size_t>(Event::PpuMode)] = ppu_synced + video.cycles_until_event();
+    updateNext();
+}
+
+void scheduler::scheduleTimer()
+{
+    int cycles = clock.cycles_until_event();
+    when[static_cast<size_t>(Event::TimerOverflow)] =
+        (cycles == 0x7FFFFFFF) ? NEVER : timer_synced + cycles;
+    updateNext();
+}
+
+// ============================================================
+// SINCRONIZACIÓN PEREZOSA
+// ============================================================
+// El contador se actualiza ANTES de avanzar el componente por si su
+// step() vuelve a leer un registro a través del MMU.
+
+// Ejecuta 'run' sumando su tiempo de host a 'total' si timing está activo
+template <typename Run>
+static inline void timed(bool timing, uint64_t& total, Run run)
+{
+    if (!timing) { run(); return; }
+
+    auto start = std::chrono::steady_clock::now();
+    run();
+    total += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                 std::chrono::steady_clock::now() - start).count();
+}
+
+void scheduler::syncPpu()
+{
+    uint64_t cycles = current - ppu_synced;
+    ppu_synced = current;
+    if (cycles) timed(timing, host_ns_ppu, [&] { video.step(static_cast<int>(cycles)); });
+}
+
+void scheduler::syncTimer()
+{
+    uint64_t cycles = current - timer_synced;
+    timer_synced = current;
+    if (cycles) timed(timing, host_ns_timer, [&] { clock.step(static_cast<int>(cycles)); });
+}
+
+void scheduler::syncApu()
+{
+    uint64_t cycles = current - apu_synced;
+    apu_synced = current;
+    if (cycles && audio_enabled)
+        timed(timing, host_ns_apu, [&] { apu.tick(static_cast<int>(cycles)); });
+}
+
+void scheduler::syncAll()
+{
+    syncPpu();
+    syncTimer();
+    syncApu();
+}
+
+void scheduler::beforeIO(uint16_t address, bool write)
+{
+    if (address >= 0xFF04 && address <= 0xFF07) {          // DIV, TIMA, TMA, TAC
+        syncTimer();
+        if (write) dirty |= DIRTY_TIMER;
+    }
+    else if (address >= 0xFF10 && address <= 0xFF3F) {     // APU
+        syncApu();
+    }
+    else if (address >= 0xFF40 && address <= 0xFF4B) {     // LCDC, STAT, LY...
+        syncPpu();
+        if (write) dirty |= DIRTY_PPU;
+    }
+    else if (address == 0xFF02 && write) {                 // SC
+        dirty |= DIRTY_SERIAL;
+        serial_write_time = current;
+    }
+}
+
+void scheduler::refreshDirty()
+{
+    if (dirty & DIRTY_PPU)   schedulePpu();
+    if (dirty & DIRTY_TIMER) scheduleTimer();
+
+    if (dirty & DIRTY_SERIAL) {
+        // Bit 7 = transferencia en curso, bit 0 = reloj interno
+        if ((memory.IO[0x02] & 0x81) == 0x81) {
+            if (when[static_cast<size_t>(Event::SerialShift)] == NEVER)
+                schedule(Event::SerialShift, serial_write_time + SERIAL_TRANSFER_CYCLES);
+        } else {
+            cancel(Event::SerialShift);
+        }
+    }
+
+    dirty = 0;
+}
+
+// ============================================================
+// SAVE STATE
+// ============================================================
+void scheduler::saveState(state_writer& out) const
+{
+    out.put(current);
+    out.put(when);
+    out.put(next_time);
+    out.put(ppu_synced);
+    out.put(timer_synced);
+    out.put(apu_synced);
+    out.put(dirty);
+    out.put(serial_write_time);
+}
+
+bool scheduler::loadState(state_reader& in)
+{
+    in.get(current);
+    in.get(when);
+    in.get(next_time);
+    in.get(ppu_synced);
+    in.get(timer_synced);
+    in.get(apu_synced);
+    in.get(dirty);
+    in.get(serial_write_time);
+    return in.ok();
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================
+// SCHEDULER - Reloj maestro y cola de eventos del hardware
+// ============================================================
+// En lugar de avanzar PPU, timer y APU después de cada instrucción,
+// el scheduler lleva un contador monotónico de T-cycles y una cola
+// pequeña con el próximo evento de cada componente:
+//
+//   PpuMode           cambio de modo / línea de la PPU (STAT, LY, VBlank)
+//   TimerOverflow     overflow de TIMA (IRQ de timer)
+//   ApuFrameSequencer paso del frame sequencer (512 Hz)
+//   SerialShift       fin de una transferencia serie (IRQ de serial)
+//
+// Los componentes se sincronizan de forma perezosa: cuando vence su
+// evento o cuando la CPU toca uno de sus registros (el MMU llama a
+// beforeIO()). Entre medias nadie avanza, así que la CPU solo paga
+// el coste de la PPU/timer/APU cuando realmente se observa su estado.
+//
+// Las instrucciones leen/escriben los registros con los componentes
+// sincronizados al inicio de la instrucción, igual que el bucle
+// anterior (step de la CPU y después step de cada componente).
+// ============================================================
+
+class mmu;
+class ppu;
+class timer;
+class APU;
+class state_writer;
+class state_reader;
+
+class scheduler
+{
+public:
+    enum class Event : uint8_t {
+        PpuMode,
+        TimerOverflow,
+        ApuFrameSequencer,
+        SerialShift,
+        Count
+    };
+
+    static constexpr uint64_t NEVER = UINT64_MAX;
+
+    scheduler(mmu& mmu_ref, ppu& ppu_ref, timer& timer_ref, APU& apu_ref);
+
+    // --- Reloj maestro ---
+    uint64_t now() const { return current; }
+    void     advance(int cycles) { current += static_cast<uint64_t>(cycles); }
+
+    // --- Cola de eventos (un slot por tipo de evento) ---
+    void     schedule(Event e, uint64_t when);
+    void     cancel(Event e);
+    uint64_t nextEvent() const { return next_time; }
+
+    // Procesa todos los eventos vencidos (when <= now) y los reprograma
+    void runDueEvents();
+
+    // Reprograma los eventos afectados por escrituras de la CPU en I/O
+    // durante la última instrucción (TAC/TIMA, LCDC, SC...)
+    void refresh() { if (dirty) refreshDirty(); }
+
+    // --- Sincronización perezosa ---
+    void syncPpu();
+    void syncTimer();
+    void syncApu();
+    void syncAll();
+
+    // Llamado por el MMU antes de cada acceso a 0xFF00-0xFF7F
+    void beforeIO(uint16_t address, bool write);
+
+    // Save state: reloj, cola de eventos y hasta dónde está
+    // sincronizado cada componente (audio_enabled y timing son del host)
+    void saveState(state_writer& out) const;
+    bool loadState(state_reader& in);
+
+    // Si es false, la APU no se avanza (equivale a "mute")
+    bool audio_enabled = true;
+
+    // Tiempo de host en cada componente (gb_perf_stats). Solo se mide
+    // con timing = true: son dos lecturas del reloj por sincronización.
+    bool     timing        = false;
+    uint64_t host_ns_ppu   = 0;
+    uint64_t host_ns_timer = 0;
+    uint64_t host_ns_apu   = 0;
+
+    // Duración de una transferencia serie con reloj interno (8 bits a 8192 Hz)
+    static constexpr int SERIAL_TRANSFER_CYCLES = 8 * 512;
+
+    // Periodo del frame sequencer de la APU (4194304 / 512 Hz)
+    static constexpr int FRAME_SEQUENCER_CYCLES = 8192;
+
+private:
+    mmu&   memory;
+    ppu&   video;
+    timer& clock;
+    APU&   apu;
+
+    uint64_t current = 0;
+
+    std::array<uint64_t, static_cast<size_t>(Event::Count)> when;
+    uint64_t next_time = NEVER;
+    void     updateNext();
+
+    // Hasta dónde está sincronizado cada componente
+    uint64_t ppu_synced   = 0;
+    uint64_t timer_synced = 0;
+    uint64_t apu_synced   = 0;
+
+    // Eventos a recalcular tras una escritura en I/O
+    enum DirtyBits : uint8_t {
+        DIRTY_PPU    = 1 << 0,
+        DIRTY_TIMER  = 1 << 1,
+        DIRTY_SERIAL = 1 << 2,
+    };
+    uint8_t  dirty = 0;
+    uint64_t serial_write_time = 0;
+    void     refreshDirty();
+
+    void schedulePpu();
+    void scheduleTimer();
+    void onEvent(Event e);
+};
@@ -17,6 +17,16 @@ void timer::reset() {
     }
 }
 
+void timer::saveState(state_writer& out) const {
+    out.put(div_counter);
+    out.put(tima_counter);
+}
+
+bool timer::loadState(state_reader& in) {
+    in.get(div_counter);
+    return in.get(tima_counter);
+}
+
 // ============================================================
 // ENABLE DEBUG - ACTIVAR/DESACTIVAR DEBUGGER
 // ============================================================
@@ -110,10 +120,8 @@ void timer::step(int t_cycles) {
     // ============================================================
     div_counter += t_cycles;
     
-    while (div_counter >= 256) {
-        div_counter -= 256;
-        memory.IO[0x04]++;  // DIV siempre incrementa
-    }
+    memory.IO[0x04] += div_counter / 256;  // DIV siempre incrementa
+    div_counter %= 256;
     
     // ============================================================
     // PARTE 2: TIMA - SOLO SI TAC BIT 2 ESTÁ ACTIVO
@@ -125,27 +133,50 @@ void timer::step(int t_cycles) {
     }
     
     // Frecuencia de TIMA según TAC bits 0-1
-    int threshold;
-    switch (tac & 0x03) {
-        case 0: threshold = 1024; break;
-        case 1: threshold = 16;   break;
-        case 2: threshold = 64;   break;
-        case 3: threshold = 256;  break;
-        default: threshold = 1024; break;
-    }
+    int threshold = tima_period(tac);
     
     tima_counter += t_cycles;
+    int ticks = tima_counter / threshold;
+    tima_counter %= threshold;
     
-    while (tima_counter >= threshold) {
-        tima_counter -= threshold;
-        
-        uint8_t tima = memory.IO[0x05];
+    // Avanzar TIMA de golpe; solo se itera por cada overflow
+    while (ticks > 0) {
+        int room = 0x100 - memory.IO[0x05];
         
-        if (tima == 0xFF) {
-            memory.IO[0x05] = memory.IO[0x06];  // TIMA = TMA
-            memory.IO[0x0F] |= 0x04;            // Timer IRQ
-        } else {
-            memory.IO[0x05] = tima + 1;
+        if (ticks < room) {
+            memory.IO[0x05] += ticks;
+            break;
         }
+        
+        ticks -= room;
+        memory.IO[0x05] = memory.IO[0x06];  // TIMA = TMA
+        memory.IO[0x0F] |= 0x04;            // Timer IRQ
+    }
+}
+
+// ============================================================
+// CYCLES UNTIL EVENT - PRÓXIMO OVERFLOW DE TIMA
+// ============================================================
+int timer::cycles_until_event() const {
+    uint8_t tac = memory.IO[0x07];
+    if (!(tac & 0x04)) return 0x7FFFFFFF;  // Timer deshabilitado
+    
+    int threshold = tima_period(tac);
+    int ticks = 0x100 - memory.IO[0x05];   // Incrementos hasta pasar de 0xFF
+    int cycles = ticks * threshold - tima_counter;
+
+    // Tras pasar TAC a una frecuencia más rápida, tima_counter puede
+    // quedar por encima del nuevo periodo: el overflow ya toca y lo
+    // aplica el próximo step(), nunca en el pasado del scheduler
+    return cycles > 0 ? cycles : 1;
+}
+
+// Frecuencia de TIMA según TAC bits 0-1 (T-cycles por incremento)
+int timer::tima_period(uint8_t tac) {
+    switch (tac & 0x03) {
+        case 0:  return 1024;
+        case 1:  return 16;
+        case 2:  return 64;
+        default: return 256;
     }
 }
\ No newline at end of file
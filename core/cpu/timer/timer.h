@@ -9,6 +9,13 @@ public:
     timer(mmu& mmu_ref);
     void step(int cycles);
     void reset();
+
+    // T-cycles hasta el próximo overflow de TIMA (IRQ de timer)
+    int cycles_until_event() const;
+
+    // Save state: divisor interno y acumulador de TIMA
+    void saveState(state_writer& out) const;
+    bool loadState(state_reader& in);
     
     // ============================================================
     // FUNCIONES DE DEBUGGING
@@ -21,6 +28,8 @@ private:
     mmu& memory;
     int div_counter;
     int tima_counter;
+
+    static int tima_period(uint8_t tac);
     
     // ============================================================
     // VARIABLES DE DEBUGGING
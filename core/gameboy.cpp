@@ -0,0 +1,326 @@
+#include "gameboy.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include "profiler/profiler.h"
+
+// --- Constructor ---
+gameboy::gameboy(const std::string& romPath)
+    : memory(romPath)
+    , apu()
+    , video(memory)
+    , clock(memory)
+    , processor(memory)
+    , sched(memory, video, clock, apu)
+    , log(std::cout)
+{
+    memory.setAPU(&apu);
+    memory.setScheduler(&sched);
+    log.setClock(&sched);
+}
+
+gameboy::gameboy(gameboy& parent, Fork)
+    : memory(parent.memory, mmu::Fork{})
+    , apu()
+    , video(memory)
+    , clock(memory)
+    , processor(memory)
+    , sched(memory, video, clock, apu)
+    , log(std::cout)
+{
+    memory.setAPU(&apu);
+    memory.setScheduler(&sched);
+    log.setClock(&sched);
+
+    audio_enabled = parent.audio_enabled;
+    perf_timing   = parent.perf_timing;
+    apu.setSampleRate(parent.apu.getHostSampleRate());
+    processor.setEngine(parent.processor.getEngine());
+}
+
+gameboy::~gameboy()
+{
+    trace::unbind(&log);
+}
+
+void gameboy::setTimeline(timeline* tl)
+{
+    trace_timeline = tl;
+    halt_since = scheduler::NEVER;
+    if (tl) tl->setClock(&sched);
+
+    processor.setTimeline(tl);
+    memory.setTimeline(tl);
+    apu.setTimeline(tl);
+}
+
+// ============================================================
+// SAVE STATE
+// ============================================================
+void gameboy::saveState(std::vector<uint8_t>& out, uint32_t flags) const
+{
+    out.clear();
+    state_writer writer(out);
+
+    state_header header{};
+    header.magic   = STATE_MAGIC;
+    header.version = STATE_VERSION;
+    header.flags   = flags;
+    memory.stampState(header);
+    writer.put(header);
+
+    writer.put(total_cycles);
+    writer.put(total_frames);
+    writer.put(halted_cycles);
+    writer.put(total_instructions);
+
+    processor.saveState(writer);
+    memory.saveState(writer, !(flags & STATE_NO_RAM));
+    video.saveState(writer, flags & STATE_FRAMEBUFFER);
+    clock.saveState(writer);
+    apu.saveState(writer);
+    sched.saveState(writer);
+
+    // El tamaño total solo se conoce al final
+    uint32_t size = static_cast<uint32_t>(out.size());
+    std::memcpy(out.data() + offsetof(state_header, size), &size, sizeof(size));
+}
+
+bool gameboy::loadState(const uint8_t* data, size_t size)
+{
+    state_reader reader(data, size);
+
+    state_header header;
+    if (!reader.get(header) || header.magic != STATE_MAGIC) {
+        std::cerr << "[State] ERROR: no es un save state\n";
+        return false;
+    }
+    if (header.version != STATE_VERSION) {
+        std::cerr << "[State] ERROR: versión " << header.version
+                  << " (se esperaba " << STATE_VERSION << ")\n";
+        return false;
+    }
+    if (header.size != size) {
+        std::cerr << "[State] ERROR: tamaño " << size << " (cabecera: " << header.size << ")\n";
+        return false;
+    }
+    if (!memory.matchesState(header)) {
+        std::cerr << "[State] ERROR: el save state es de otra ROM\n";
+        return false;
+    }
+
+    reader.get(total_cycles);
+    reader.get(total_frames);
+    reader.get(halted_cycles);
+    reader.get(total_instructions);
+
+    bool ok = processor.loadState(reader)
+           && memory.loadState(reader, !(header.flags & STATE_NO_RAM))
+           && video.loadState(reader, header.flags & STATE_FRAMEBUFFER)
+           && clock.loadState(reader)
+           && apu.loadState(reader)
+           && sched.loadState(reader)
+           && reader.remaining() == 0;
+    if (!ok) {
+        std::cerr << "[State] ERROR: save state truncado o corrupto\n";
+        return false;
+    }
+
+    halt_since = scheduler::NEVER;
+    return true;
+}
+
+// ============================================================
+// STATE HASH
+// ============================================================
+// La RAM va página a página; las partes pequeñas se serializan como en
+// saveState (sin RAM ni framebuffer) a un buffer reutilizado y van al
+// final, porque su tamaño no es múltiplo de 32 bytes. Todo va campo a
+// campo (state_writer rechaza tipos con relleno), así que la basura de
+// la memoria donde se construyó la máquina no llega al hash.
+uint64_t gameboy::stateHash() const
+{
+    state_hasher hasher;
+    memory.hashRam(hasher);
+
+    hash_scratch.clear();
+    state_writer writer(hash_scratch);
+
+    writer.put(total_cycles);
+    processor.saveState(writer);
+    memory.saveState(writer, false);
+    video.saveState(writer, false);
+    clock.saveState(writer);
+    apu.saveSoundState(writer);
+    sched.saveState(writer);
+
+    hasher.update(hash_scratch.data(), hash_scratch.size());
+    return hasher.digest();
+}
+
+// ============================================================
+// FORK
+// ============================================================
+std::unique_ptr<gameboy> gameboy::fork()
+{
+    std::unique_ptr<gameboy> child(new gameboy(*this, Fork{}));
+
+    // La RAM ya es la del padre (compartida): el state solo lleva el resto
+    std::vector<uint8_t> state;
+    saveState(state, STATE_NO_RAM);
+    if (!child->loadState(state.data(), state.size())) return nullptr;
+    return child;
+}
+
+// ============================================================
+// RUN FRAME
+// ============================================================
+int gameboy::run_frame()
+{
+    const uint64_t frame_start = sched.now();
+    const uint64_t frame_end   = frame_start + T_CYCLES_PER_FRAME;
+
+    sched.audio_enabled = audio_enabled;
+    trace::bind(&log);
+
+    const uint64_t instructions_start = total_instructions;
+    const uint64_t halted_start       = halted_cycles;
+
+    sched.timing = perf_timing;
+    sched.host_ns_ppu = sched.host_ns_timer = sched.host_ns_apu = 0;
+    auto host_start = perf_timing ? std::chrono::steady_clock::now()
+                                  : std::chrono::steady_clock::time_point{};
+
+    while (sched.now() < frame_end) {
+        int cpu_t_cycles;
+
+        if (processor.sleeping()) {
+            // HALT/STOP: saltar directo al próximo evento del scheduler
+            // (modo/LY de la PPU, overflow de TIMA, serial...) o al final
+            // del frame (joypad solo cambia entre frames). Redondeado a
+            // M-cycles, igual que los pasos de 4 ciclos de step().
+            uint64_t target = std::min(sched.nextEvent(), frame_end);
+            uint64_t skip   = target - sched.now();
+            cpu_t_cycles = std::max<int>(4, static_cast<int>((skip + 3) & ~3ULL));
+            halted_cycles += cpu_t_cycles;
+            if (trace_timeline && halt_since == scheduler::NEVER) halt_since = sched.now();
+            if (profiler* prof = processor.getProfiler()) prof->onIdle(cpu_t_cycles);
+        } else {
+            if (halt_since != scheduler::NEVER) {
+                trace_timeline->complete(timeline::Cpu, "halt", halt_since, sched.now());
+                halt_since = scheduler::NEVER;
+            }
+
+#ifdef GB_ENABLE_JIT
+            uint64_t budget = std::min(sched.nextEvent(), frame_end) - sched.now();
+            processor.setCycleBudget(static_cast<int32_t>(std::min<uint64_t>(budget, INT32_MAX)));
+#endif
+            cpu_t_cycles = processor.step();
+            total_instructions += processor.stepInstructions();
+            if (cpu_t_cycles < 4) cpu_t_cycles = 4;
+            sched.refresh();
+        }
+
+        sched.advance(cpu_t_cycles);
+        if (sched.now() >= sched.nextEvent()) {
+            sched.runDueEvents();
+        }
+    }
+
+    // Dejar el framebuffer y el buffer de audio al día para el frontend
+    sched.syncAll();
+    log.endFrame();
+
+    int t_cycles_this_frame = static_cast<int>(sched.now() - frame_start);
+    total_cycles += t_cycles_this_frame;
+    total_frames++;
+
+    if (trace_timeline) {
+        trace_timeline->complete(timeline::Frames, "frame", frame_start, sched.now(),
+                                 "frame", static_cast<uint32_t>(total_frames));
+    }
+
+    // Telemetría del frame
+    perf.version       = GB_PERF_STATS_VERSION;
+    perf.frame         = static_cast<uint32_t>(total_frames);
+    perf.cycles        = static_cast<uint32_t>(t_cycles_this_frame);
+    perf.instructions  = static_cast<uint32_t>(total_instructions - instructions_start);
+    perf.halted_cycles = static_cast<uint32_t>(halted_cycles - halted_start);
+
+    memory.collectStats(perf);
+
+    perf.scanlines       = video.scanlines_drawn;
+    perf.apu_samples     = apu.samplesProduced;
+    perf.audio_buffered  = static_cast<uint32_t>(apu.getSamplesAvailable());
+    perf.audio_underruns = apu.underruns;
+    video.scanlines_drawn = 0;
+    apu.samplesProduced   = 0;
+    apu.underruns         = 0;
+
+    if (perf_timing) {
+        uint64_t frame_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                std::chrono::steady_clock::now() - host_start).count();
+        uint64_t components = sched.host_ns_ppu + sched.host_ns_timer + sched.host_ns_apu;
+        perf.host_ns_frame = static_cast<uint32_t>(frame_ns);
+        perf.host_ns_cpu   = static_cast<uint32_t>(frame_ns > components ? frame_ns - components : 0);
+        perf.host_ns_ppu   = static_cast<uint32_t>(sched.host_ns_ppu);
+        perf.host_ns_timer = static_cast<uint32_t>(sched.host_ns_timer);
+        perf.host_ns_apu   = static_cast<uint32_t>(sched.host_ns_apu);
+    } else {
+        perf.host_ns_frame = perf.host_ns_cpu = perf.host_ns_ppu = 0;
+        perf.host_ns_timer = perf.host_ns_apu = 0;
+    }
+
+    return t_cycles_this_frame;
+}
+
+// ============================================================
+// RUN-AHEAD
+// ============================================================
+int gameboy::run_ahead_frame(int frames)
+{
+    if (frames <= 0) return run_frame();
+
+    // 1. Frame real: avanza la partida y produce el audio que se oye
+    video.render_enabled = false;
+    int t_cycles = run_frame();
+    gb_perf_stats real_perf = perf;
+
+    // 2. Frames ocultos desde aquí (sin framebuffer en el state: gfx debe
+    // sobrevivir a la restauración). Se deshacen, así que no llegan a la
+    // línea de tiempo, los profilers, la cobertura, el mapa de calor ni
+    // el log de trazas.
+    saveState(ahead_state, 0);
+
+    timeline*       tl      = trace_timeline;
+    profiler*       prof    = processor.getProfiler();
+    opcode_profile* opcodes = processor.getOpcodeProfile();
+    setTimeline(nullptr);
+    processor.setProfiler(nullptr);
+    processor.setOpcodeProfile(nullptr);
+    memory.setTracking(false);
+    log.setMuted(true);
+    apu.outputEnabled = false;
+    for (int i = 1; i <= frames; i++) {
+        video.render_enabled = (i == frames);
+        run_frame();
+    }
+    apu.outputEnabled    = true;
+    video.render_enabled = true;
+    log.setMuted(false);
+    memory.setTracking(true);
+    processor.setOpcodeProfile(opcodes);
+    processor.setProfiler(prof);
+    setTimeline(tl);
+
+    // 3. Volver al frame real
+    if (!loadState(ahead_state.data(), ahead_state.size())) {
+        std::cerr << "[RunAhead] ERROR: no se pudo restaurar el frame real\n";
+        return t_cycles;
+    }
+    perf = real_perf;
+    return t_cycles;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cpu/mmu/mmu.h"
+#include "cpu/cpu.h"
+#include "cpu/ppu/ppu.h"
+#include "cpu/timer/timer.h"
+#include "cpu/APU/apu.h"
+#include "cpu/scheduler/scheduler.h"
+#include "trace/logger.h"
+#include "trace/timeline.h"
+#include "perf/perf_stats.h"
+#include "state/state_hash.h"
+#include "state/state_io.h"
+
+// ============================================================
+// GAMEBOY - Máquina completa (MMU + CPU + PPU + Timer + APU)
+// ============================================================
+// Agrupa los componentes del core y el bucle de un frame para que
+// el frontend web (emc_main.cpp) y el runner nativo (headless_main.cpp)
+// ejecuten exactamente el mismo código. PPU, timer y APU los avanza
+// el scheduler (por eventos y al tocar sus registros), no cada
+// instrucción.
+// ============================================================
+
+// T-cycles de un frame completo del LCD (154 líneas * 456 dots)
+constexpr int T_CYCLES_PER_FRAME = 70224;
+
+class gameboy
+{
+public:
+    explicit gameboy(const std::string& romPath);
+    ~gameboy();
+
+    gameboy(const gameboy&) = delete;
+    gameboy& operator=(const gameboy&) = delete;
+
+    // Emula un frame (70224 T-cycles). Devuelve los T-cycles ejecutados.
+    int run_frame();
+
+    // Run-ahead: emula el frame real sin dibujar (con audio), guarda el
+    // estado, emula 'frames' frames más con la entrada actual sin audio
+    // (solo el último dibuja) y vuelve al frame real. gfx queda con la
+    // imagen de 'frames' frames en el futuro, así que la respuesta a la
+    // entrada se ve antes. Con frames <= 0 equivale a run_frame.
+    // Los frames ocultos no cuentan para la línea de tiempo, los
+    // profilers, la cobertura, el mapa de calor ni el log de trazas.
+    int run_ahead_frame(int frames);
+
+    bool is_loaded() const { return memory.cartridgeLoaded(); }
+
+    // Save state binario (ver core/state/state_io.h) entre frames.
+    // saveState reemplaza el contenido de 'out' (conserva su capacidad,
+    // así que reutilizar el mismo vector no vuelve a reservar memoria).
+    // loadState devuelve false sin tocar nada si la cabecera no
+    // corresponde a esta ROM o a esta versión; si falla a mitad de
+    // la carga, la máquina queda en un estado indefinido.
+    void saveState(std::vector<uint8_t>& out, uint32_t flags = STATE_FRAMEBUFFER) const;
+    bool loadState(const uint8_t* data, size_t size);
+
+    // Hash XXH64 del estado emulado (ver core/state/state_hash.h) para
+    // deduplicar estados y comprobar repeticiones frame a frame. Cubre
+    // lo mismo que el save state salvo el framebuffer, la síntesis de
+    // audio de la APU y los contadores del host (frames, instrucciones,
+    // HALT): solo total_cycles, que es el reloj del scheduler. Dos
+    // máquinas con el mismo hash siguen igual con la misma entrada.
+    uint64_t stateHash() const;
+
+    // Fork copy-on-write (búsqueda en árbol sobre estados de juego).
+    // El hijo comparte la ROM y las páginas de 256 bytes de VRAM, WRAM y
+    // RAM externa con el padre; quien escriba primero en una página se
+    // queda una copia. El resto del estado (CPU, registros, PPU, timer,
+    // APU, scheduler) se copia con un save state sin RAM. No se copian
+    // el framebuffer, la línea de tiempo, los botones ni el audio ya
+    // generado. Llamar entre frames desde el hilo que corre al padre;
+    // después padre e hijos pueden correr cada uno en su hilo.
+    std::unique_ptr<gameboy> fork();
+
+    // Conecta (o desconecta con nullptr) una línea de tiempo Chrome
+    // trace a la CPU, el MMU y la APU. Los frames y los periodos de
+    // HALT los registra run_frame.
+    void setTimeline(timeline* tl);
+
+    // Si es false, la APU no se avanza (equivale a "mute" en el frontend)
+    bool audio_enabled = true;
+
+    // Contadores acumulados desde la carga de la ROM
+    // (total_cycles coincide con el reloj maestro del scheduler)
+    uint64_t total_cycles = 0;
+    uint64_t total_frames = 0;
+    uint64_t halted_cycles = 0;   // T-cycles saltados con la CPU en HALT/STOP
+    uint64_t total_instructions = 0;  // Instrucciones retiradas (fuera de HALT/STOP)
+
+    // Telemetría del último frame (ver core/perf/perf_stats.h). Con
+    // perf_timing también se mide el tiempo de host por componente.
+    gb_perf_stats perf{};
+    bool          perf_timing = false;
+
+    // El orden de declaración importa: el MMU se construye primero
+    // porque el resto de componentes guarda una referencia a él.
+    mmu   memory;
+    APU   apu;
+    ppu   video;
+    timer clock;
+    cpu   processor;
+    scheduler sched;
+
+    // Trazas GB_TRACE_* de esta máquina (ring buffer + hilo escritor)
+    logger log;
+
+private:
+    struct Fork {};
+    gameboy(gameboy& parent, Fork);
+
+    timeline* trace_timeline = nullptr;
+    uint64_t  halt_since = scheduler::NEVER;   // Inicio del HALT en curso (timeline)
+
+    std::vector<uint8_t> ahead_state;   // Estado del frame real (run-ahead)
+
+    mutable std::vector<uint8_t> hash_scratch;   // Registros y contadores (stateHash)
+};
@@ -0,0 +1,126 @@
+#include "mem_heatmap.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+void mem_heatmap::clear()
+{
+    std::memset(&current, 0, sizeof(current));
+    std::memset(&last, 0, sizeof(last));
+    std::memset(&cumulative, 0, sizeof(cumulative));
+}
+
+void mem_heatmap::endFrame(const std::array<uint32_t, 256>& page_reads,
+                           const std::array<uint32_t, 256>& page_writes,
+                           uint32_t hram_reads, uint32_t hram_writes)
+{
+    current.frames = 1;
+    for (int page = 0; page < 256; page++) {
+        current.page_reads[page]  = page_reads[page];
+        current.page_writes[page] = page_writes[page];
+    }
+    current.hram_reads  = hram_reads;
+    current.hram_writes = hram_writes;
+
+    last = current;
+
+    // gb_mem_heatmap es todo uint64: se acumula campo a campo
+    const uint64_t* src = reinterpret_cast<const uint64_t*>(&current);
+    uint64_t*       dst = reinterpret_cast<uint64_t*>(&cumulative);
+    for (size_t i = 0; i < sizeof(gb_mem_heatmap) / sizeof(uint64_t); i++)
+        dst[i] += src[i];
+
+    std::memset(&current, 0, sizeof(current));
+}
+
+void mem_heatmap::discardFrame()
+{
+    std::memset(&current, 0, sizeof(current));
+}
+
+void mem_heatmap::regionTotals(const gb_mem_heatmap& map,
+                               uint64_t reads[GB_MEM_REGION_COUNT],
+                               uint64_t writes[GB_MEM_REGION_COUNT])
+{
+    for (unsigned r = 0; r < GB_MEM_REGION_COUNT; r++) reads[r] = writes[r] = 0;
+    for (int page = 0; page < 256; page++) {
+        reads[gb_page_region(page)]  += map.page_reads[page];
+        writes[gb_page_region(page)] += map.page_writes[page];
+    }
+
+    // Igual que mmu::collectStats: la página 0xFF mezcla I/O con HRAM/IE
+    reads[GB_MEM_IO]    -= map.hram_reads;
+    writes[GB_MEM_IO]   -= map.hram_writes;
+    reads[GB_MEM_HRAM]   = map.hram_reads;
+    writes[GB_MEM_HRAM]  = map.hram_writes;
+}
+
+// ============================================================
+// EXPORTACIÓN
+// ============================================================
+// Nombres de los registros de I/O del DMG (nullptr = sin registro)
+static const char* ioName(int index)
+{
+    static const char* const names[0x80] = {
+        "P1", "SB", "SC", nullptr, "DIV", "TIMA", "TMA", "TAC",                     // FF00
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, "IF",        // FF08
+        "NR10", "NR11", "NR12", "NR13", "NR14", nullptr, "NR21", "NR22",            // FF10
+        "NR23", "NR24", "NR30", "NR31", "NR32", "NR33", "NR34", nullptr,            // FF18
+        "NR41", "NR42", "NR43", "NR44", "NR50", "NR51", "NR52", nullptr,            // FF20
+        nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,     // FF28
+        "WAVE0", "WAVE1", "WAVE2", "WAVE3", "WAVE4", "WAVE5", "WAVE6", "WAVE7",     // FF30
+        "WAVE8", "WAVE9", "WAVEA", "WAVEB", "WAVEC", "WAVED", "WAVEE", "WAVEF",     // FF38
+        "LCDC", "STAT", "SCY", "SCX", "LY", "LYC", "DMA", "BGP",                    // FF40
+        "OBP0", "OBP1", "WY", "WX",                                                 // FF48
+    };
+    return names[index];
+}
+
+//   {"frames":600,
+//    "regions":{"rom0":{"reads":1234,"writes":0},...},
+//    "pages":{"reads":[...256],"writes":[...256]},
+//    "io":[{"addr":"FF44","name":"LY","reads":5000,"writes":0},...]}
+bool mem_heatmap::write(const gb_mem_heatmap& map, const std::string& path)
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Heatmap] ERROR: no se pudo escribir " << path << "\n";
+        return false;
+    }
+
+    static const char* const region_names[GB_MEM_REGION_COUNT] = {
+        "rom0", "romx", "vram", "sram", "wram", "oam", "io", "hram"
+    };
+    uint64_t reads[GB_MEM_REGION_COUNT], writes[GB_MEM_REGION_COUNT];
+    regionTotals(map, reads, writes);
+
+    out << "{\"frames\":" << map.frames << ",\n\"regions\":{";
+    for (unsigned r = 0; r < GB_MEM_REGION_COUNT; r++) {
+        out << (r ? "," : "") << "\"" << region_names[r] << "\":{\"reads\":" << reads[r]
+            << ",\"writes\":" << writes[r] << "}";
+    }
+
+    out << "},\n\"pages\":{\"reads\":[";
+    for (int page = 0; page < 256; page++) out << (page ? "," : "") << map.page_reads[page];
+    out << "],\n\"writes\":[";
+    for (int page = 0; page < 256; page++) out << (page ? "," : "") << map.page_writes[page];
+    out << "]},\n\"io\":[";
+
+    // Solo los registros que se tocaron
+    bool first = true;
+    char addr[8];
+    for (int index = 0; index < 0x80; index++) {
+        if (!map.io_reads[index] && !map.io_writes[index]) continue;
+        std::snprintf(addr, sizeof(addr), "FF%02X", index);
+        const char* name = ioName(index);
+
+        out << (first ? "\n" : ",\n") << "  {\"addr\":\"" << addr << "\",\"name\":\""
+            << (name ? name : "?") << "\",\"reads\":" << map.io_reads[index]
+            << ",\"writes\":" << map.io_writes[index] << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "perf_stats.h"
+
+// ============================================================
+// MEM_HEATMAP - Accesos del bus por página y por registro de I/O
+// ============================================================
+// Amplía la telemetría de gb_perf_stats (que solo da totales por
+// región) con el detalle que hace falta para decidir qué regiones y
+// registros merecen un camino rápido propio:
+//
+//   - lecturas/escrituras por página de 256 bytes (las mismas que
+//     cuenta el MMU para gb_perf_stats, acumuladas aquí)
+//   - lecturas/escrituras por registro de I/O (0xFF00-0xFF7F)
+//
+// Solo existe con la opción CMake GB_MEM_HEATMAP=ON (define
+// GB_MEM_HEATMAP): sin ella el MMU no cuenta ni páginas ni registros.
+//
+// Hay dos vistas: el último frame terminado y el acumulado desde la
+// carga (o el último clear()). Los contadores son uint64 para que el
+// acumulado no desborde en sesiones largas.
+// ============================================================
+
+// POD para el frontend: JS lo lee con BigUint64Array desde el puntero
+// que devuelve get_mem_heatmap()
+struct gb_mem_heatmap {
+    uint64_t frames;              // Frames sumados (1 en la vista por frame)
+    uint64_t page_reads[256];
+    uint64_t page_writes[256];
+    uint64_t io_reads[0x80];      // Índice = dirección - 0xFF00
+    uint64_t io_writes[0x80];
+    uint64_t hram_reads;          // Parte HRAM/IE de la página 0xFF
+    uint64_t hram_writes;
+};
+
+class mem_heatmap
+{
+public:
+    mem_heatmap() { clear(); }
+
+    // El MMU lo llama en cada acceso a 0xFF00-0xFF7F (readSlow/writeSlow)
+    void countIO(uint16_t address, bool write)
+    {
+        (write ? current.io_writes : current.io_reads)[address & 0x7F]++;
+    }
+
+    // Cierra el frame con los contadores por página del MMU
+    void endFrame(const std::array<uint32_t, 256>& page_reads,
+                  const std::array<uint32_t, 256>& page_writes,
+                  uint32_t hram_reads, uint32_t hram_writes);
+
+    // Descarta el frame en curso sin sumarlo a ninguna vista
+    void discardFrame();
+
+    void clear();
+
+    const gb_mem_heatmap& lastFrame() const { return last; }
+    const gb_mem_heatmap& total()     const { return cumulative; }
+
+    // Suma por región (gb_mem_region) de una de las dos vistas
+    static void regionTotals(const gb_mem_heatmap& map,
+                             uint64_t reads[GB_MEM_REGION_COUNT],
+                             uint64_t writes[GB_MEM_REGION_COUNT]);
+
+    // JSON con regiones, páginas y registros de I/O usados
+    static bool write(const gb_mem_heatmap& map, const std::string& path);
+
+private:
+    gb_mem_heatmap current;       // Frame en curso (solo I/O; las páginas llegan en endFrame)
+    gb_mem_heatmap last;
+    gb_mem_heatmap cumulative;
+};
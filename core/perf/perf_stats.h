@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================
+// PERF_STATS - Telemetría por frame para el frontend
+// ============================================================
+// gameboy::run_frame rellena este struct al final de cada frame con
+// lo ocurrido durante ese frame (no son totales acumulados). Es POD
+// y todos los campos son uint32_t para que JS lo lea directamente con
+// HEAPU32 a partir del puntero que devuelve get_perf_stats().
+//
+// Los accesos a memoria son los del bus de la CPU (incluida la DMA):
+// lecturas de la PPU a VRAM/OAM no pasan por el MMU y no cuentan.
+// Solo se cuentan con GB_MEM_HEATMAP; sin ella mem_reads y mem_writes
+// quedan a cero y el bus no paga ningún contador.
+//
+// Los tiempos de host solo se miden con gameboy::perf_timing = true
+// (cuestan dos lecturas del reloj por sincronización). host_ns_cpu
+// es el tiempo del frame menos PPU, timer y APU, así que incluye el
+// propio scheduler.
+// ============================================================
+
+// Regiones del mapa de memoria
+enum gb_mem_region : uint32_t {
+    GB_MEM_ROM0 = 0,   // 0x0000-0x3FFF
+    GB_MEM_ROMX,       // 0x4000-0x7FFF
+    GB_MEM_VRAM,       // 0x8000-0x9FFF
+    GB_MEM_SRAM,       // 0xA000-0xBFFF (RAM externa / RTC)
+    GB_MEM_WRAM,       // 0xC000-0xFDFF (incluye el espejo)
+    GB_MEM_OAM,        // 0xFE00-0xFEFF (incluye la zona prohibida)
+    GB_MEM_IO,         // 0xFF00-0xFF7F
+    GB_MEM_HRAM,       // 0xFF80-0xFFFF (incluye IE)
+    GB_MEM_REGION_COUNT
+};
+
+// Región de una página de 256 bytes. La 0xFF es I/O y HRAM/IE a la
+// vez: quien cuenta por página reparte esa parte aparte.
+inline gb_mem_region gb_page_region(int page)
+{
+    if (page < 0x40) return GB_MEM_ROM0;
+    if (page < 0x80) return GB_MEM_ROMX;
+    if (page < 0xA0) return GB_MEM_VRAM;
+    if (page < 0xC0) return GB_MEM_SRAM;
+    if (page < 0xFE) return GB_MEM_WRAM;
+    if (page < 0xFF) return GB_MEM_OAM;
+    return GB_MEM_IO;
+}
+
+// Cambia si se añaden o reordenan campos
+constexpr uint32_t GB_PERF_STATS_VERSION = 1;
+
+struct gb_perf_stats {
+    uint32_t version;
+    uint32_t frame;                // Número de frame (desde la carga)
+
+    // --- CPU ---
+    uint32_t cycles;               // T-cycles emulados
+    uint32_t instructions;         // Instrucciones retiradas (también dentro de bloques del JIT)
+    uint32_t halted_cycles;        // T-cycles en HALT/STOP
+
+    // --- Memoria ---
+    uint32_t mem_reads[GB_MEM_REGION_COUNT];
+    uint32_t mem_writes[GB_MEM_REGION_COUNT];
+    uint32_t bank_switches;        // Cambios del banco de ROM o RAM mapeado
+    uint32_t dma_transfers;        // DMA a OAM (0xFF46)
+
+    // --- PPU ---
+    uint32_t scanlines;            // Líneas dibujadas en el framebuffer
+
+    // --- APU ---
+    uint32_t apu_samples;          // Muestras de host generadas
+    uint32_t audio_buffered;       // Muestras en el ring buffer al final del frame
+    uint32_t audio_underruns;      // Lecturas de fillOutputBuffer con menos muestras de las pedidas
+
+    // --- Tiempo de host (ns, 0 sin perf_timing) ---
+    uint32_t host_ns_frame;
+    uint32_t host_ns_cpu;
+    uint32_t host_ns_ppu;
+    uint32_t host_ns_timer;
+    uint32_t host_ns_apu;
+};
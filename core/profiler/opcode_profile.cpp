@@ -0,0 +1,207 @@
+#include "opcode_profile.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define GB_OPCODE_PROFILE_TSC 1
+#else
+#define GB_OPCODE_PROFILE_TSC 0
+#endif
+
+// --- Constructor ---
+opcode_profile::opcode_profile(uint32_t host_period)
+    : period(host_period)
+    , countdown(host_period)
+{
+    reset();
+}
+
+void opcode_profile::reset()
+{
+    std::memset(&stats, 0, sizeof(stats));
+    stats.host_period  = period;
+    stats.host_unit_ns = GB_OPCODE_PROFILE_TSC ? 0 : 1;
+    countdown = period;
+}
+
+uint64_t opcode_profile::hostTicks()
+{
+#if GB_OPCODE_PROFILE_TSC
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// ============================================================
+// MNEMÓNICOS
+// ============================================================
+static const char* const BASE_NAMES[256] = {
+    // 0x00
+    "NOP", "LD BC,d16", "LD (BC),A", "INC BC", "INC B", "DEC B", "LD B,d8", "RLCA",
+    "LD (a16),SP", "ADD HL,BC", "LD A,(BC)", "DEC BC", "INC C", "DEC C", "LD C,d8", "RRCA",
+    // 0x10
+    "STOP", "LD DE,d16", "LD (DE),A", "INC DE", "INC D", "DEC D", "LD D,d8", "RLA",
+    "JR r8", "ADD HL,DE", "LD A,(DE)", "DEC DE", "INC E", "DEC E", "LD E,d8", "RRA",
+    // 0x20
+    "JR NZ,r8", "LD HL,d16", "LD (HL+),A", "INC HL", "INC H", "DEC H", "LD H,d8", "DAA",
+    "JR Z,r8", "ADD HL,HL", "LD A,(HL+)", "DEC HL", "INC L", "DEC L", "LD L,d8", "CPL",
+    // 0x30
+    "JR NC,r8", "LD SP,d16", "LD (HL-),A", "INC SP", "INC (HL)", "DEC (HL)", "LD (HL),d8", "SCF",
+    "JR C,r8", "ADD HL,SP", "LD A,(HL-)", "DEC SP", "INC A", "DEC A", "LD A,d8", "CCF",
+    // 0x40-0x7F y 0x80-0xBF se generan en mnemonic()
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr,
+    // 0xC0
+    "RET NZ", "POP BC", "JP NZ,a16", "JP a16", "CALL NZ,a16", "PUSH BC", "ADD A,d8", "RST 00H",
+    "RET Z", "RET", "JP Z,a16", "PREFIX CB", "CALL Z,a16", "CALL a16", "ADC A,d8", "RST 08H",
+    // 0xD0
+    "RET NC", "POP DE", "JP NC,a16", nullptr, "CALL NC,a16", "PUSH DE", "SUB d8", "RST 10H",
+    "RET C", "RETI", "JP C,a16", nullptr, "CALL C,a16", nullptr, "SBC A,d8", "RST 18H",
+    // 0xE0
+    "LDH (a8),A", "POP HL", "LD (C),A", nullptr, nullptr, "PUSH HL", "AND d8", "RST 20H",
+    "ADD SP,r8", "JP (HL)", "LD (a16),A", nullptr, nullptr, nullptr, "XOR d8", "RST 28H",
+    // 0xF0
+    "LDH A,(a8)", "POP AF", "LD A,(C)", "DI", nullptr, "PUSH AF", "OR d8", "RST 30H",
+    "LD HL,SP+r8", "LD SP,HL", "LD A,(a16)", "EI", nullptr, nullptr, "CP d8", "RST 38H",
+};
+
+std::string opcode_profile::mnemonic(int slot)
+{
+    static const char* const regs[8] = { "B", "C", "D", "E", "H", "L", "(HL)", "A" };
+    char text[24];
+
+    if (slot >= 0x100) {
+        // Prefijo CB: grupo (rotaciones, BIT, RES, SET), bit y registro
+        static const char* const rotations[8] = { "RLC", "RRC", "RL", "RR", "SLA", "SRA", "SWAP", "SRL" };
+        static const char* const groups[4]    = { nullptr, "BIT", "RES", "SET" };
+        int op  = slot & 0xFF;
+        int reg = op & 7, bit = (op >> 3) & 7, group = op >> 6;
+        if (group == 0) std::snprintf(text, sizeof(text), "%s %s", rotations[bit], regs[reg]);
+        else            std::snprintf(text, sizeof(text), "%s %d,%s", groups[group], bit, regs[reg]);
+        return text;
+    }
+
+    if (BASE_NAMES[slot]) return BASE_NAMES[slot];
+
+    if (slot == 0x76) return "HALT";
+    if (slot >= 0x40 && slot < 0x80) {
+        std::snprintf(text, sizeof(text), "LD %s,%s", regs[(slot >> 3) & 7], regs[slot & 7]);
+        return text;
+    }
+    if (slot >= 0x80 && slot < 0xC0) {
+        static const char* const alu[8] = { "ADD A,", "ADC A,", "SUB ", "SBC A,", "AND ", "XOR ", "OR ", "CP " };
+        std::snprintf(text, sizeof(text), "%s%s", alu[(slot >> 3) & 7], regs[slot & 7]);
+        return text;
+    }
+
+    std::snprintf(text, sizeof(text), "ILLEGAL %02X", slot);
+    return text;
+}
+
+// ============================================================
+// EXPORTACIÓN
+// ============================================================
+static std::string slotCode(int slot)
+{
+    char code[8];
+    if (slot >= 0x100) std::snprintf(code, sizeof(code), "CB %02X", slot & 0xFF);
+    else               std::snprintf(code, sizeof(code), "%02X", slot);
+    return code;
+}
+
+// Opcodes ejecutados, de más a menos ciclos
+static std::vector<int> usedSlots(const gb_opcode_profile& stats)
+{
+    std::vector<int> slots;
+    for (int slot = 0; slot < GB_OPCODE_SLOTS; slot++)
+        if (stats.count[slot]) slots.push_back(slot);
+    std::sort(slots.begin(), slots.end(), [&](int a, int b) {
+        return stats.cycles[a] > stats.cycles[b];
+    });
+    return slots;
+}
+
+//   {"host_period":64,"host_unit":"tsc","total_cycles":...,"opcodes":[
+//     {"opcode":"CB 7C","mnemonic":"BIT 7,H","count":10,"cycles":80,
+//      "host_samples":1,"host_ticks":35},
+//   ...]}
+bool opcode_profile::write(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[OpcodeProfile] ERROR: no se pudo escribir " << path << "\n";
+        return false;
+    }
+
+    uint64_t total_count = 0, total_cycles = 0;
+    for (int slot = 0; slot < GB_OPCODE_SLOTS; slot++) {
+        total_count  += stats.count[slot];
+        total_cycles += stats.cycles[slot];
+    }
+
+    out << "{\"host_period\":" << stats.host_period
+        << ",\"host_unit\":\"" << (stats.host_unit_ns ? "ns" : "tsc") << "\""
+        << ",\"total_count\":" << total_count << ",\"total_cycles\":" << total_cycles
+        << ",\"opcodes\":[";
+
+    bool first = true;
+    for (int slot : usedSlots(stats)) {
+        out << (first ? "\n" : ",\n") << "  {\"opcode\":\"" << slotCode(slot)
+            << "\",\"mnemonic\":\"" << mnemonic(slot) << "\",\"count\":" << stats.count[slot]
+            << ",\"cycles\":" << stats.cycles[slot];
+        if (stats.host_period) {
+            out << ",\"host_samples\":" << stats.host_samples[slot]
+                << ",\"host_ticks\":" << stats.host_ticks[slot];
+        }
+        out << "}";
+        first = false;
+    }
+    out << "\n]}\n";
+    return static_cast<bool>(out);
+}
+
+void opcode_profile::writeTop(std::ostream& out, int count) const
+{
+    uint64_t total_cycles = 0;
+    for (int slot = 0; slot < GB_OPCODE_SLOTS; slot++) total_cycles += stats.cycles[slot];
+
+    std::vector<int> slots = usedSlots(stats);
+    char line[160];
+    for (int i = 0; i < count && i < static_cast<int>(slots.size()); i++) {
+        int    slot = slots[i];
+        double pct  = total_cycles ? 100.0 * stats.cycles[slot] / total_cycles : 0.0;
+        int len = std::snprintf(line, sizeof(line), "%6.2f%% %12llu cycles %10llu exec  %-5s %-14s",
+                                pct, static_cast<unsigned long long>(stats.cycles[slot]),
+                                static_cast<unsigned long long>(stats.count[slot]),
+                                slotCode(slot).c_str(), mnemonic(slot).c_str());
+        if (stats.host_samples[slot]) {
+            std::snprintf(line + len, sizeof(line) - len, " %8.1f %s/op",
+                          static_cast<double>(stats.host_ticks[slot]) / stats.host_samples[slot],
+                          stats.host_unit_ns ? "ns" : "tsc");
+        }
+        out << line << "\n";
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+// ============================================================
+// OPCODE_PROFILE - Coste por opcode (base y prefijo CB)
+// ============================================================
+// Cuenta, por cada uno de los 256 opcodes base y los 256 con prefijo
+// CB, cuántas veces se ejecutó y cuántos T-cycles emulados consumió.
+// Sirve para decidir qué handlers especializar o fusionar.
+//
+// Opcionalmente mide el coste en el host: una de cada host_period
+// instrucciones se cronometra (TSC en x86, ns de steady_clock en el
+// resto). El promedio por muestra de cada opcode es el coste de su
+// handler con el dispatch incluido.
+//
+// Cada instancia es independiente; la CPU la usa mientras está
+// conectada con cpu::setOpcodeProfile (el JIT se desactiva igual
+// que con el profiler: sus bloques no pasan por step instrucción a
+// instrucción).
+// ============================================================
+
+// Índice de un opcode: 0x000-0x0FF base, 0x100-0x1FF prefijo CB
+constexpr int GB_OPCODE_SLOTS = 0x200;
+
+// POD para el frontend: JS lo lee con BigUint64Array desde el puntero
+// que devuelve get_opcode_profile()
+struct gb_opcode_profile {
+    uint64_t host_period;                     // 0 = sin muestreo de host
+    uint64_t host_unit_ns;                    // 1 = host_ticks en ns; 0 = ticks del TSC
+    uint64_t count[GB_OPCODE_SLOTS];
+    uint64_t cycles[GB_OPCODE_SLOTS];         // T-cycles emulados
+    uint64_t host_samples[GB_OPCODE_SLOTS];
+    uint64_t host_ticks[GB_OPCODE_SLOTS];     // Suma de las muestras
+};
+
+class opcode_profile
+{
+public:
+    // host_period = 0 desactiva el muestreo de tiempo de host
+    explicit opcode_profile(uint32_t host_period = 0);
+
+    void reset();
+
+    // --- Eventos de la CPU (cpu::step) ---
+    // true si la instrucción que va a ejecutarse se cronometra
+    bool sampleHost()
+    {
+        if (!period) return false;
+        if (--countdown) return false;
+        countdown = period;
+        return true;
+    }
+
+    static uint64_t hostTicks();
+
+    void record(int slot, int cycles)
+    {
+        stats.count[slot]++;
+        stats.cycles[slot] += static_cast<uint64_t>(cycles);
+    }
+
+    void recordHost(int slot, uint64_t ticks)
+    {
+        stats.host_samples[slot]++;
+        stats.host_ticks[slot] += ticks;
+    }
+
+    // --- Consulta y exportación ---
+    const gb_opcode_profile& data() const { return stats; }
+
+    static std::string mnemonic(int slot);   // "LD A,(HL)", "BIT 7,H"...
+
+    bool write(const std::string& path) const;          // JSON con los opcodes usados
+    void writeTop(std::ostream& out, int count) const;  // Tabla por ciclos
+
+private:
+    gb_opcode_profile stats;
+    uint32_t period;
+    uint32_t countdown;
+};
@@ -0,0 +1,439 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "mmu/mmu.h"
+
+// --- Constructor ---
+profiler::profiler(const mmu& mmu_ref)
+    : memory(mmu_ref)
+{
+    reset();
+}
+
+void profiler::reset()
+{
+    nodes.assign(1, Node{ 0, 0 });
+    children.clear();
+    stack.clear();
+    current = 0;
+    counters.clear();
+    total_cycles = 0;
+}
+
+// ============================================================
+// SÍMBOLOS (.sym de RGBDS / no$gmb)
+// ============================================================
+//   ; comentario
+//   00:0150 Main
+//   01:4a2f UpdateSprites.loop
+bool profiler::loadSymbols(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[Profiler] ERROR: no se pudo abrir " << path << "\n";
+        return false;
+    }
+
+    std::string line;
+    size_t loaded = 0;
+    while (std::getline(file, line)) {
+        size_t comment = line.find(';');
+        if (comment != std::string::npos) line.resize(comment);
+
+        char* end = nullptr;
+        unsigned long bank = std::strtoul(line.c_str(), &end, 16);
+        if (!end || *end != ':') continue;
+        unsigned long addr = std::strtoul(end + 1, &end, 16);
+        if (addr > 0xFFFF) continue;
+
+        // El nombre es la siguiente palabra (sin espacios ni ';')
+        size_t start = line.find_first_not_of(" \t", end - line.c_str());
+        if (start == std::string::npos) continue;
+        size_t stop = line.find_first_of(" \t\r", start);
+        std::string name = line.substr(start, stop - start);
+
+        // Fuera de la ROM conmutada el banco no distingue nada
+        uint32_t loc = (addr >= 0x4000 && addr < 0x8000)
+                     ? static_cast<uint32_t>(bank << 16 | addr)
+                     : static_cast<uint32_t>(addr);
+        symbols[loc] = name;
+        loaded++;
+    }
+
+    std::cout << "[Profiler] " << loaded << " símbolos cargados de " << path << "\n";
+    return true;
+}
+
+// ============================================================
+// EVENTOS DE LA CPU
+// ============================================================
+uint32_t profiler::locate(uint16_t pc) const
+{
+    if (pc >= 0x4000 && pc < 0x8000)
+        return static_cast<uint32_t>(memory.currentRomBank()) << 16 | pc;
+    return pc;
+}
+
+void profiler::onInstruction(uint16_t pc, uint8_t opcode, int cycles,
+                             uint16_t sp_before, uint16_t pc_after, uint16_t sp_after)
+{
+    // Los ciclos de la instrucción son del frame que la ejecuta
+    // (los de un CALL cuentan para quien llama)
+    Counter& counter = counters[static_cast<uint64_t>(current) << 32 | locate(pc)];
+    counter.instructions++;
+    counter.cycles += cycles;
+    total_cycles += cycles;
+
+    switch (opcode) {
+        // CALL, CALL cc y RST: solo si realmente apilaron el retorno
+        case 0xCD: case 0xC4: case 0xCC: case 0xD4: case 0xDC:
+        case 0xC7: case 0xCF: case 0xD7: case 0xDF:
+        case 0xE7: case 0xEF: case 0xF7: case 0xFF:
+            if (sp_after == static_cast<uint16_t>(sp_before - 2))
+                enter(locate(pc_after), sp_after);
+            break;
+
+        // RET, RETI y RET cc tomado
+        case 0xC9: case 0xD9: case 0xC0: case 0xC8: case 0xD0: case 0xD8:
+            if (sp_after == static_cast<uint16_t>(sp_before + 2))
+                leave(sp_after);
+            break;
+
+        default:
+            break;
+    }
+}
+
+void profiler::onInterrupt(uint16_t vector, uint16_t sp_after, int cycles)
+{
+    enter(IRQ_FRAME | vector, sp_after);
+
+    Counter& counter = counters[static_cast<uint64_t>(current) << 32 | vector];
+    counter.cycles += cycles;
+    total_cycles += cycles;
+}
+
+void profiler::onIdle(int cycles)
+{
+    counters[static_cast<uint64_t>(current) << 32 | IDLE_LOC].cycles += cycles;
+    total_cycles += cycles;
+}
+
+void profiler::enter(uint32_t frame, uint16_t sp)
+{
+    // Un frame cuyo hueco de retorno se reutiliza ya no existe (SP
+    // recargado, retorno descartado con POP/ADD SP...)
+    while (!stack.empty() && stack.back().sp <= sp) stack.pop_back();
+    current = stack.empty() ? 0 : stack.back().node;
+    if (stack.size() >= MAX_DEPTH) return;
+
+    uint64_t key = static_cast<uint64_t>(current) << 32 | frame;
+    auto it = children.find(key);
+    uint32_t node;
+    if (it != children.end()) {
+        node = it->second;
+    } else {
+        node = static_cast<uint32_t>(nodes.size());
+        nodes.push_back(Node{ current, frame });
+        children.emplace(key, node);
+    }
+
+    stack.push_back(Frame{ node, sp });
+    current = node;
+}
+
+// Cierra los frames cuya dirección de retorno ya está por encima de SP
+void profiler::leave(uint16_t sp)
+{
+    while (!stack.empty() && stack.back().sp < sp) stack.pop_back();
+    current = stack.empty() ? 0 : stack.back().node;
+}
+
+// ============================================================
+// NOMBRES
+// ============================================================
+static const char* irqName(uint16_t vector)
+{
+    switch (vector) {
+        case 0x40: return "irq_vblank";
+        case 0x48: return "irq_stat";
+        case 0x50: return "irq_timer";
+        case 0x58: return "irq_serial";
+        case 0x60: return "irq_joypad";
+        default:   return "irq";
+    }
+}
+
+// Frame: etiqueta exacta del destino, o banco:dirección
+std::string profiler::frameName(uint32_t frame) const
+{
+    uint32_t loc = frame & ~IRQ_FRAME;
+    auto it = symbols.find(loc);
+    if (it != symbols.end()) return it->second;
+    if (frame & IRQ_FRAME) return irqName(static_cast<uint16_t>(loc));
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "%02X:%04X", loc >> 16, loc & 0xFFFF);
+    return name;
+}
+
+// Ubicación: etiqueta anterior más cercana del mismo banco (+offset)
+std::string profiler::locationName(uint32_t loc) const
+{
+    char name[16];
+    std::snprintf(name, sizeof(name), "%02X:%04X", loc >> 16, loc & 0xFFFF);
+
+    auto it = symbols.upper_bound(loc);
+    if (it == symbols.begin()) return name;
+    --it;
+
+    // No cruzar de banco ni de región (ROM / RAM)
+    if ((it->first >> 16) != (loc >> 16) ||
+        ((it->first & 0xFFFF) < 0x8000) != ((loc & 0xFFFF) < 0x8000)) return name;
+
+    uint32_t offset = loc - it->first;
+    if (offset == 0) return std::string(name) + " " + it->second;
+
+    char suffix[16];
+    std::snprintf(suffix, sizeof(suffix), "+0x%X", offset);
+    return std::string(name) + " " + it->second + suffix;
+}
+
+std::vector<uint32_t> profiler::path(uint32_t node) const
+{
+    std::vector<uint32_t> chain;
+    for (; node != 0; node = nodes[node].parent) chain.push_back(node);
+    std::reverse(chain.begin(), chain.end());
+    return chain;
+}
+
+// ============================================================
+// EXPORTACIÓN: PILAS COLAPSADAS
+// ============================================================
+//   root;Main;UpdateSprites 123456
+//   root;Main;[halt] 98765
+bool profiler::writeFolded(const std::string& path_out) const
+{
+    std::ofstream out(path_out);
+    if (!out.is_open()) {
+        std::cerr << "[Profiler] ERROR: no se pudo escribir " << path_out << "\n";
+        return false;
+    }
+
+    // Ciclos por nodo (y en HALT por nodo), sin importar el PC
+    std::vector<uint64_t> busy(nodes.size(), 0), idle(nodes.size(), 0);
+    for (const auto& entry : counters) {
+        uint32_t node = static_cast<uint32_t>(entry.first >> 32);
+        uint32_t loc  = static_cast<uint32_t>(entry.first);
+        (loc == IDLE_LOC ? idle : busy)[node] += entry.second.cycles;
+    }
+
+    for (uint32_t node = 0; node < nodes.size(); node++) {
+        if (!busy[node] && !idle[node]) continue;
+
+        std::string stack_name = "root";
+        for (uint32_t n : path(node)) stack_name += ";" + frameName(nodes[n].frame);
+
+        if (busy[node]) out << stack_name << " " << busy[node] << "\n";
+        if (idle[node]) out << stack_name << ";[halt] " << idle[node] << "\n";
+    }
+    return static_cast<bool>(out);
+}
+
+// ============================================================
+// EXPORTACIÓN: PPROF
+// ============================================================
+// profile.proto sin comprimir (pprof acepta el protobuf tal cual).
+// Cada muestra es (nodo, ubicación): la hoja es el PC real con la
+// función del frame activo y el resto de la pila son las entradas de
+// los frames. Valores: instrucciones y T-cycles.
+namespace {
+
+class proto_writer
+{
+public:
+    void varint(uint64_t value)
+    {
+        while (value >= 0x80) {
+            bytes.push_back(static_cast<char>(value | 0x80));
+            value >>= 7;
+        }
+        bytes.push_back(static_cast<char>(value));
+    }
+
+    void field(int number, uint64_t value)           // wire type 0
+    {
+        varint(static_cast<uint64_t>(number) << 3);
+        varint(value);
+    }
+
+    void field(int number, const std::string& data)  // wire type 2
+    {
+        varint(static_cast<uint64_t>(number) << 3 | 2);
+        varint(data.size());
+        bytes += data;
+    }
+
+    void packed(int number, const std::vector<uint64_t>& values)
+    {
+        proto_writer inner;
+        for (uint64_t v : values) inner.varint(v);
+        field(number, inner.bytes);
+    }
+
+    std::string bytes;
+};
+
+} // namespace
+
+bool profiler::writePprof(const std::string& path_out) const
+{
+    std::vector<std::string>                  strings{ "" };
+    std::unordered_map<std::string, uint64_t> string_ids{ { "", 0 } };
+    auto str = [&](const std::string& s) {
+        auto it = string_ids.find(s);
+        if (it != string_ids.end()) return it->second;
+        strings.push_back(s);
+        return string_ids[s] = strings.size() - 1;
+    };
+
+    std::unordered_map<std::string, uint64_t> function_ids;
+    proto_writer functions;
+    auto function = [&](const std::string& name) {
+        auto it = function_ids.find(name);
+        if (it != function_ids.end()) return it->second;
+        uint64_t id = function_ids.size() + 1;
+        function_ids[name] = id;
+
+        proto_writer fn;
+        fn.field(1, id);
+        fn.field(2, str(name));
+        fn.field(3, str(name));
+        functions.field(5, fn.bytes);
+        return id;
+    };
+
+    // Ubicaciones únicas por (dirección, función)
+    std::map<std::pair<uint64_t, uint64_t>, uint64_t> location_ids;
+    proto_writer locations;
+    auto location = [&](uint64_t address, const std::string& fn_name) {
+        uint64_t fn = function(fn_name);
+        auto key = std::make_pair(address, fn);
+        auto it = location_ids.find(key);
+        if (it != location_ids.end()) return it->second;
+        uint64_t id = location_ids.size() + 1;
+        location_ids[key] = id;
+
+        proto_writer line;
+        line.field(1, fn);
+
+        proto_writer loc;
+        loc.field(1, id);
+        loc.field(2, uint64_t{ 1 });
+        loc.field(3, address);
+        loc.field(4, line.bytes);
+        locations.field(4, loc.bytes);
+        return id;
+    };
+
+    proto_writer profile;
+
+    // sample_type: instrucciones y ciclos
+    for (const char* type : { "instructions", "cycles" }) {
+        proto_writer value_type;
+        value_type.field(1, str(type));
+        value_type.field(2, str("count"));
+        profile.field(1, value_type.bytes);
+    }
+
+    for (const auto& entry : counters) {
+        uint32_t node = static_cast<uint32_t>(entry.first >> 32);
+        uint32_t loc  = static_cast<uint32_t>(entry.first);
+        std::vector<uint32_t> chain = path(node);
+
+        // Hoja primero, raíz al final
+        std::vector<uint64_t> stack_ids;
+        std::string top = chain.empty() ? "root" : frameName(nodes[chain.back()].frame);
+        if (loc == IDLE_LOC) {
+            stack_ids.push_back(location(0, "[halt]"));
+            if (!chain.empty())
+                stack_ids.push_back(location(nodes[chain.back()].frame & ~IRQ_FRAME, top));
+        } else {
+            stack_ids.push_back(location(loc, top));
+        }
+        for (size_t i = chain.size(); i-- > 1; )
+            stack_ids.push_back(location(nodes[chain[i - 1]].frame & ~IRQ_FRAME,
+                                         frameName(nodes[chain[i - 1]].frame)));
+        if (!chain.empty() || loc == IDLE_LOC) stack_ids.push_back(location(0, "root"));
+
+        proto_writer sample;
+        sample.packed(1, stack_ids);
+        sample.packed(2, { entry.second.instructions, entry.second.cycles });
+        profile.field(2, sample.bytes);
+    }
+
+    // Un único mapping para todo el espacio banco:dirección
+    proto_writer mapping;
+    mapping.field(1, uint64_t{ 1 });
+    mapping.field(2, uint64_t{ 0 });
+    mapping.field(3, uint64_t{ 0xFFFFFFFF });
+    mapping.field(5, str("rom"));
+    mapping.field(7, uint64_t{ 1 });   // has_functions
+    profile.field(3, mapping.bytes);
+
+    profile.bytes += locations.bytes;
+    profile.bytes += functions.bytes;
+
+    // period_type/period antes de cerrar la tabla de strings
+    proto_writer period_type;
+    period_type.field(1, str("cycles"));
+    period_type.field(2, str("count"));
+
+    for (const std::string& s : strings) profile.field(6, s);
+    profile.field(11, period_type.bytes);
+    profile.field(12, uint64_t{ 1 });
+
+    std::ofstream out(path_out, std::ios::binary);
+    if (!out.is_open()) {
+        std::cerr << "[Profiler] ERROR: no se pudo escribir " << path_out << "\n";
+        return false;
+    }
+    out.write(profile.bytes.data(), static_cast<std::streamsize>(profile.bytes.size()));
+    return static_cast<bool>(out);
+}
+
+// ============================================================
+// EXPORTACIÓN: TABLA DE UBICACIONES
+// ============================================================
+void profiler::writeTop(std::ostream& out, int count) const
+{
+    // Sumar por ubicación (todas las pilas)
+    std::unordered_map<uint32_t, Counter> flat;
+    for (const auto& entry : counters) {
+        Counter& c = flat[static_cast<uint32_t>(entry.first)];
+        c.instructions += entry.second.instructions;
+        c.cycles       += entry.second.cycles;
+    }
+
+    std::vector<std::pair<uint32_t, Counter>> sorted(flat.begin(), flat.end());
+    std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) {
+        return a.second.cycles > b.second.cycles;
+    });
+
+    char line[160];
+    for (int i = 0; i < count && i < static_cast<int>(sorted.size()); i++) {
+        uint32_t loc = sorted[i].first;
+        double   pct = total_cycles ? 100.0 * sorted[i].second.cycles / total_cycles : 0.0;
+        std::string name = (loc == IDLE_LOC) ? "[halt]" : locationName(loc);
+        std::snprintf(line, sizeof(line), "%6.2f%% %12llu cycles %10llu instr  %s\n", pct,
+                      static_cast<unsigned long long>(sorted[i].second.cycles),
+                      static_cast<unsigned long long>(sorted[i].second.instructions),
+                      name.c_str());
+        out << line;
+    }
+}
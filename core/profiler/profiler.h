@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class mmu;
+
+// ============================================================
+// PROFILER - Ciclos del juego por (banco de ROM, PC) y pila de llamadas
+// ============================================================
+// Profiler exacto: la CPU le avisa de cada instrucción ejecutada y
+// de cada interrupción servida (cpu::setProfiler). Los T-cycles se
+// acumulan por:
+//
+//   - ubicación: banco de ROM + PC (0x4000-0x7FFF usa el banco
+//     mapeado en ese momento; el resto cuenta como banco 0)
+//   - pila: una pila sombra que sigue CALL/RST/interrupciones y las
+//     vuelve a cerrar con RET/RETI. Los frames se cierran por SP, así
+//     que los trucos de pila (pop de la dirección de retorno, recargar
+//     SP) no la desincronizan para siempre.
+//
+// Los ciclos en HALT/STOP se cuentan como "[halt]" sobre la pila actual.
+//
+// Con un .sym de RGBDS o no$gmb ("BB:AAAA Etiqueta") las direcciones
+// se traducen a etiquetas. Exporta:
+//   writeFolded  pilas colapsadas (flamegraph.pl, speedscope, inferno)
+//   writePprof   perfil protobuf de pprof (go tool pprof)
+//   writeTop     tabla de las ubicaciones más calientes
+// ============================================================
+
+class profiler
+{
+public:
+    explicit profiler(const mmu& mmu_ref);
+
+    // Carga etiquetas de un .sym. Devuelve false si no se pudo abrir.
+    bool loadSymbols(const std::string& path);
+
+    // Borra lo acumulado (mantiene los símbolos)
+    void reset();
+
+    // --- Eventos de la CPU ---
+    void onInstruction(uint16_t pc, uint8_t opcode, int cycles,
+                       uint16_t sp_before, uint16_t pc_after, uint16_t sp_after);
+    void onInterrupt(uint16_t vector, uint16_t sp_after, int cycles);
+    void onIdle(int cycles);
+
+    // --- Exportación ---
+    bool writeFolded(const std::string& path) const;
+    bool writePprof(const std::string& path) const;
+    void writeTop(std::ostream& out, int count) const;
+
+    uint64_t totalCycles() const { return total_cycles; }
+
+private:
+    const mmu& memory;
+
+    // Ubicación = banco << 16 | dirección. Los frames de interrupción
+    // llevan además IRQ_FRAME para distinguirlos de un CALL al vector.
+    static constexpr uint32_t IRQ_FRAME = 0x80000000u;
+    static constexpr uint32_t IDLE_LOC  = 0xFFFFFFFFu;
+    static constexpr size_t   MAX_DEPTH = 256;
+
+    uint32_t locate(uint16_t pc) const;
+
+    // Árbol de pilas: cada nodo es (padre, frame). El nodo 0 es la raíz.
+    struct Node {
+        uint32_t parent;
+        uint32_t frame;
+    };
+    std::vector<Node>                      nodes;
+    std::unordered_map<uint64_t, uint32_t> children;   // padre << 32 | frame
+
+    // Pila sombra: nodo activo y SP justo después de apilar el retorno
+    struct Frame {
+        uint32_t node;
+        uint16_t sp;
+    };
+    std::vector<Frame> stack;
+    uint32_t current = 0;
+
+    void enter(uint32_t frame, uint16_t sp);
+    void leave(uint16_t sp);
+
+    struct Counter {
+        uint64_t instructions = 0;
+        uint64_t cycles       = 0;
+    };
+    std::unordered_map<uint64_t, Counter> counters;    // nodo << 32 | ubicación
+    uint64_t total_cycles = 0;
+
+    // Símbolos del .sym, ordenados por ubicación
+    std::map<uint32_t, std::string> symbols;
+
+    std::string frameName(uint32_t frame) const;
+    std::string locationName(uint32_t loc) const;
+    std::vector<uint32_t> path(uint32_t node) const;   // Raíz primero
+};
@@ -0,0 +1,184 @@
+#include "rewind_buffer.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "gameboy.h"
+
+// --- Constructor ---
+rewind_buffer::rewind_buffer(size_t budget_bytes, uint32_t interval)
+    : ring(budget_bytes)
+    , every(interval ? interval : 1)
+{
+}
+
+void rewind_buffer::clear()
+{
+    entries.clear();
+    used = 0;
+    frames_since = 0;
+    current.clear();
+}
+
+// ============================================================
+// CAPTURA
+// ============================================================
+void rewind_buffer::onFrame(const gameboy& gb)
+{
+    if (++frames_since < every) return;
+    frames_since = 0;
+
+    gb.saveState(next);
+
+    // El delta necesita dos states del mismo tamaño (misma ROM y flags)
+    if (!current.empty() && current.size() == next.size()) {
+        encode(current.data(), next.data(), next.size(), delta);
+        push(delta);
+    } else if (!current.empty()) {
+        entries.clear();
+        used = 0;
+    }
+    current.swap(next);
+}
+
+// Copia el delta a continuación del más nuevo, descartando los más
+// viejos que pisa. Si no cabe hasta el final, vuelve al principio del
+// anillo; las entradas que quedaban en la cola se descartan con él.
+void rewind_buffer::push(const std::vector<uint8_t>& encoded)
+{
+    size_t size = encoded.size();
+    if (size > ring.size()) {
+        // No cabe ni con el anillo vacío: el historial se corta aquí
+        entries.clear();
+        used = 0;
+        return;
+    }
+
+    size_t pos = entries.empty() ? 0 : entries.back().offset + entries.back().size;
+    if (pos + size > ring.size()) {
+        while (!entries.empty() && entries.front().offset >= pos) {
+            used -= entries.front().size;
+            entries.pop_front();
+        }
+        pos = 0;
+    }
+
+    while (!entries.empty()) {
+        const Entry& oldest = entries.front();
+        bool overlaps = oldest.offset < pos + size && pos < oldest.offset + oldest.size;
+        if (!overlaps) break;
+        used -= oldest.size;
+        entries.pop_front();
+    }
+
+    std::memcpy(ring.data() + pos, encoded.data(), size);
+    entries.push_back(Entry{ pos, size });
+    used += size;
+}
+
+// ============================================================
+// REBOBINAR
+// ============================================================
+bool rewind_buffer::stepBack(gameboy& gb)
+{
+    if (current.empty()) return false;
+
+    // La máquina avanzó desde la última captura: volver a ella primero
+    if (frames_since > 0) {
+        frames_since = 0;
+        return gb.loadState(current.data(), current.size());
+    }
+
+    if (entries.empty()) return false;
+
+    Entry newest = entries.back();
+    entries.pop_back();
+    used -= newest.size;
+
+    if (!apply(ring.data() + newest.offset, newest.size, current.data(), current.size())) {
+        std::cerr << "[Rewind] ERROR: delta corrupto, historial descartado\n";
+        clear();
+        return false;
+    }
+    return gb.loadState(current.data(), current.size());
+}
+
+// ============================================================
+// DELTAS (XOR + tramos)
+// ============================================================
+static void putVarint(std::vector<uint8_t>& out, size_t value)
+{
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static bool getVarint(const uint8_t*& in, const uint8_t* end, size_t& value)
+{
+    value = 0;
+    for (int shift = 0; in < end && shift < 64; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+static uint64_t load64(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Un tramo distinto termina con 8 bytes iguales seguidos: así un byte
+// igual suelto no parte el tramo en dos cabeceras.
+void rewind_buffer::encode(const uint8_t* older, const uint8_t* newer, size_t size,
+                           std::vector<uint8_t>& out)
+{
+    out.clear();
+
+    size_t i = 0;
+    while (i < size) {
+        size_t start = i;
+        while (i + 8 <= size && load64(older + i) == load64(newer + i)) i += 8;
+        while (i < size && older[i] == newer[i]) i++;
+        if (i == size) break;   // Los ceros del final no se escriben
+
+        size_t lit_start = i;
+        size_t lit_end   = i;
+        int    same      = 0;
+        for (size_t j = i; j < size; j++) {
+            if (older[j] != newer[j]) { same = 0; lit_end = j + 1; }
+            else if (++same == 8) break;
+        }
+
+        putVarint(out, lit_start - start);
+        putVarint(out, lit_end - lit_start);
+        for (size_t j = lit_start; j < lit_end; j++)
+            out.push_back(older[j] ^ newer[j]);
+        i = lit_end;
+    }
+}
+
+bool rewind_buffer::apply(const uint8_t* encoded, size_t encoded_size, uint8_t* state, size_t size)
+{
+    const uint8_t* in  = encoded;
+    const uint8_t* end = encoded + encoded_size;
+
+    size_t pos = 0;
+    while (in < end) {
+        size_t skip, count;
+        if (!getVarint(in, end, skip) || !getVarint(in, end, count)) return false;
+        if (skip > size - pos || count > size - pos - skip) return false;
+        if (count > static_cast<size_t>(end - in)) return false;
+
+        pos += skip;
+        for (size_t k = 0; k < count; k++) state[pos + k] ^= in[k];
+        pos += count;
+        in  += count;
+    }
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+class gameboy;
+
+// ============================================================
+// REWIND_BUFFER - Historial de save states para rebobinar
+// ============================================================
+// Cada 'interval' frames captura un save state (con framebuffer, para
+// que el frame rebobinado se vea al instante). Solo el más reciente se
+// guarda completo; cada captura anterior queda como el XOR contra la
+// siguiente, comprimido por tramos:
+//
+//   varint ceros   bytes iguales que se saltan
+//   varint n       bytes distintos
+//   n bytes        XOR de esos bytes
+//
+// Entre dos capturas casi todo el state (WRAM, VRAM, cartucho) es
+// igual, así que un delta ocupa de cientos de bytes a pocos KB.
+//
+// Los deltas viven en un anillo de bytes de tamaño fijo: al llenarse
+// se descartan los más viejos. stepBack() aplica un solo delta sobre
+// el state completo y lo carga (un pase lineal + gameboy::loadState),
+// así que cabe de sobra en un refresco de pantalla.
+// ============================================================
+
+class rewind_buffer
+{
+public:
+    // 'budget_bytes' es el tamaño del anillo de deltas (el state
+    // completo y el buffer de trabajo van aparte)
+    explicit rewind_buffer(size_t budget_bytes = 16 << 20, uint32_t interval = 2);
+
+    // Llamar después de cada run_frame: captura cada 'interval' frames
+    void onFrame(const gameboy& gb);
+
+    // Vuelve a la captura anterior (o a la última, si la máquina ya
+    // avanzó desde ella). false si no queda historial.
+    bool stepBack(gameboy& gb);
+
+    void clear();
+
+    uint32_t interval()  const { return every; }
+    size_t   snapshots() const { return entries.size() + (current.empty() ? 0 : 1); }
+    size_t   bytesUsed() const { return used; }
+    size_t   budget()    const { return ring.size(); }
+
+    // Frames emulados que cubre el historial
+    uint64_t framesHeld() const { return entries.size() * static_cast<uint64_t>(every); }
+
+    // Formato de un delta (también lo usan los tests): encode escribe en
+    // 'out' el XOR de older y newer por tramos; apply lo aplica sobre
+    // 'state' (newer -> older). apply devuelve false si está corrupto.
+    static void encode(const uint8_t* older, const uint8_t* newer, size_t size,
+                       std::vector<uint8_t>& out);
+    static bool apply(const uint8_t* encoded, size_t encoded_size, uint8_t* state, size_t size);
+
+private:
+    struct Entry {
+        size_t offset;   // Inicio en el anillo
+        size_t size;
+    };
+
+    std::vector<uint8_t> ring;
+    std::deque<Entry>    entries;   // Del más viejo al más nuevo
+    size_t               used = 0;
+
+    uint32_t every;
+    uint32_t frames_since = 0;      // Frames emulados desde la última captura
+
+    std::vector<uint8_t> current;   // Última captura, completa
+    std::vector<uint8_t> next;      // Buffer de trabajo de onFrame
+    std::vector<uint8_t> delta;
+
+    void push(const std::vector<uint8_t>& encoded);
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "state_io.h"
+
+// ============================================================
+// STATE_HASH - Hash de 64 bits del estado de la máquina
+// ============================================================
+// XXH64 (el algoritmo de xxHash, mismo resultado que XXH64() con la
+// misma semilla) en modo streaming: el estado no es contiguo (RAM en
+// páginas, un bloque por componente), así que se va alimentando por
+// trozos sin copiarlo a un buffer.
+//
+// Cuatro acumuladores independientes por bloque de 32 bytes: la CPU
+// los avanza en paralelo y un state completo (~17 KB sin framebuffer)
+// se hashea en un par de microsegundos. Lo usa gameboy::stateHash
+// para deduplicar estados en búsquedas y detectar desincronizaciones.
+//
+// Los trozos múltiplos de 32 bytes van directos; uno que deja bytes
+// pendientes obliga a copiar por el buffer en todos los siguientes,
+// así que conviene dejar los trozos de tamaño irregular para el final.
+// ============================================================
+
+class state_hasher
+{
+public:
+    explicit state_hasher(uint64_t seed_value = 0) : seed(seed_value)
+    {
+        acc[0] = seed + P1 + P2;
+        acc[1] = seed + P2;
+        acc[2] = seed;
+        acc[3] = seed - P1;
+    }
+
+    void update(const void* data, size_t size)
+    {
+        const uint8_t* in  = static_cast<const uint8_t*>(data);
+        const uint8_t* end = in + size;
+        total += size;
+
+        // Completar el bloque pendiente de la llamada anterior
+        if (buffered) {
+            size_t take = STRIPE - buffered;
+            if (take > size) take = size;
+            std::memcpy(buffer + buffered, in, take);
+            buffered += take;
+            in       += take;
+            if (buffered < STRIPE) return;
+            stripe(buffer);
+            buffered = 0;
+        }
+
+        for (; end - in >= static_cast<ptrdiff_t>(STRIPE); in += STRIPE) stripe(in);
+
+        buffered = static_cast<size_t>(end - in);
+        if (buffered) std::memcpy(buffer, in, buffered);
+    }
+
+    template <typename T>
+    void put(const T& value)
+    {
+        static_assert(state_field_v<T>, "solo tipos sin relleno: serializa los campos uno a uno");
+        update(&value, sizeof(T));
+    }
+
+    uint64_t digest() const
+    {
+        uint64_t h;
+        if (total >= STRIPE) {
+            h = rotl(acc[0], 1) + rotl(acc[1], 7) + rotl(acc[2], 12) + rotl(acc[3], 18);
+            for (uint64_t lane : acc) h = (h ^ round(0, lane)) * P1 + P4;
+        } else {
+            h = seed + P5;
+        }
+        h += total;
+
+        // Cola (< 32 bytes): 8, 4 y 1 bytes
+        const uint8_t* p   = buffer;
+        const uint8_t* end = buffer + buffered;
+        for (; end - p >= 8; p += 8) h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+        if (end - p >= 4) {
+            h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+            p += 4;
+        }
+        for (; p < end; p++) h = rotl(h ^ (*p * P5), 11) * P1;
+
+        // Avalancha final
+        h ^= h >> 33;
+        h *= P2;
+        h ^= h >> 29;
+        h *= P3;
+        h ^= h >> 32;
+        return h;
+    }
+
+private:
+    static constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+    static constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+    static constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+    static constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+    static constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+    static constexpr size_t   STRIPE = 32;
+
+    uint64_t acc[4];
+    uint64_t seed;
+    uint64_t total    = 0;
+    uint8_t  buffer[STRIPE];
+    size_t   buffered = 0;
+
+    static uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+    static uint64_t round(uint64_t lane, uint64_t input)
+    {
+        return rotl(lane + input * P2, 31) * P1;
+    }
+
+    static uint64_t read64(const uint8_t* p) { uint64_t v; std::memcpy(&v, p, 8); return v; }
+    static uint64_t read32(const uint8_t* p) { uint32_t v; std::memcpy(&v, p, 4); return v; }
+
+    void stripe(const uint8_t* p)
+    {
+        acc[0] = round(acc[0], read64(p));
+        acc[1] = round(acc[1], read64(p + 8));
+        acc[2] = round(acc[2], read64(p + 16));
+        acc[3] = round(acc[3], read64(p + 24));
+    }
+};
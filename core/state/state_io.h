@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+// ============================================================
+// STATE_IO - Serialización binaria de los save states
+// ============================================================
+// Cada componente vuelca su estado con saveState(state_writer&) y lo
+// recupera con loadState(state_reader&), siempre en el mismo orden.
+// Los campos se copian tal cual están en memoria (memcpy): solo tipos
+// de ancho fijo sin punteros, así que el formato es el mismo en x86-64
+// y wasm32, ambos little-endian.
+//
+// Formato (versión STATE_VERSION):
+//   state_header   magic "GBSS", versión, flags, tamaño total y la
+//                  identidad de la ROM (título + checksum global)
+//   secciones      gameboy, cpu, mmu, cartucho, ppu, timer, apu,
+//                  scheduler (ver gameboy::saveState)
+//
+// Cambia STATE_VERSION si cambia cualquier sección: loadState rechaza
+// otras versiones en lugar de interpretar mal los bytes.
+// ============================================================
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Los save states se copian con memcpy y son little-endian"
+#endif
+
+constexpr uint32_t STATE_MAGIC   = 0x53534247;   // "GBSS"
+constexpr uint32_t STATE_VERSION = 2;
+
+// Secciones opcionales
+enum state_flags : uint32_t {
+    STATE_FRAMEBUFFER = 1u << 0,   // Incluye ppu::gfx (lo que se ve en pantalla)
+    STATE_NO_RAM      = 1u << 1,   // Sin VRAM, WRAM ni RAM externa (gameboy::fork
+                                   // ya las comparte página a página)
+};
+
+struct state_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t size;          // Bytes del state completo, cabecera incluida
+    uint8_t  title[16];     // 0x0134-0x0143 de la ROM
+    uint16_t checksum;      // Checksum global 0x014E-0x014F
+    uint16_t reserved;
+};
+static_assert(sizeof(state_header) == 36, "state_header no debe tener relleno");
+
+// Tipos que put/get copian con memcpy: sin bytes de relleno, que son
+// basura distinta en cada ejecución y romperían stateHash. Los float no
+// tienen representación única (+0/-0, NaN) pero tampoco relleno.
+template <typename T>
+constexpr bool state_field_v =
+    std::has_unique_object_representations_v<T> ||
+    std::is_floating_point_v<std::remove_all_extents_t<T>>;
+
+class state_writer
+{
+public:
+    explicit state_writer(std::vector<uint8_t>& out) : buffer(out) {}
+
+    void bytes(const void* data, size_t size)
+    {
+        size_t at = buffer.size();
+        buffer.resize(at + size);
+        std::memcpy(buffer.data() + at, data, size);
+    }
+
+    template <typename T>
+    void put(const T& value)
+    {
+        static_assert(state_field_v<T>, "solo tipos sin relleno: serializa los campos uno a uno");
+        bytes(&value, sizeof(T));
+    }
+
+    size_t size() const { return buffer.size(); }
+
+private:
+    std::vector<uint8_t>& buffer;
+};
+
+class state_reader
+{
+public:
+    state_reader(const uint8_t* data, size_t size) : cursor(data), left(size) {}
+
+    // false (y el lector queda en error) si no quedan bytes suficientes
+    bool bytes(void* out, size_t size)
+    {
+        if (failed || size > left) { failed = true; return false; }
+        std::memcpy(out, cursor, size);
+        cursor += size;
+        left   -= size;
+        return true;
+    }
+
+    template <typename T>
+    bool get(T& value)
+    {
+        static_assert(state_field_v<T>, "solo tipos sin relleno: serializa los campos uno a uno");
+        return bytes(&value, sizeof(T));
+    }
+
+    bool   ok()        const { return !failed; }
+    size_t remaining() const { return left; }
+
+private:
+    const uint8_t* cursor;
+    size_t         left;
+    bool           failed = false;
+};
@@ -0,0 +1,159 @@
+#include "logger.h"
+
+#include <chrono>
+#include <cstdio>
+#include <ostream>
+#include <string>
+
+#include "scheduler/scheduler.h"
+
+static const char* const CATEGORY_NAMES[] = {
+    "cpu", "irq", "mmu", "ppu", "timer", "joypad"
+};
+
+// --- Constructor ---
+logger::logger(std::ostream& out_ref)
+    : out(out_ref)
+{
+}
+
+void logger::start()
+{
+    ring.reset(new Record[CAPACITY]);
+#ifndef __EMSCRIPTEN__
+    running.store(true, std::memory_order_relaxed);
+    worker = std::thread(&logger::run, this);
+#endif
+}
+
+logger::~logger()
+{
+#ifndef __EMSCRIPTEN__
+    if (worker.joinable()) {
+        running.store(false, std::memory_order_release);
+        worker.join();
+    }
+#endif
+    // Lo que quedara pendiente se escribe antes de destruir la máquina
+    if (ring) drain();
+}
+
+// ============================================================
+// PRODUCTOR
+// ============================================================
+bool logger::push(trace::Category category, const char* event,
+                  std::initializer_list<trace::Field> fields)
+{
+    if (muted) return false;
+    if (!ring) start();
+
+    const size_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) >= CAPACITY) {
+        drops.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    Record& record = ring[h & (CAPACITY - 1)];
+    fill(record, category, event, fields);
+    record.cycle = clock ? clock->now() : 0;
+
+    // Publicar el registro al consumidor
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+// ============================================================
+// CONSUMIDOR
+// ============================================================
+size_t logger::drain()
+{
+    size_t       t = tail.load(std::memory_order_relaxed);
+    const size_t h = head.load(std::memory_order_acquire);
+    if (t == h && drops.load(std::memory_order_relaxed) == reported_drops) return 0;
+
+    // Todo el lote se formatea en un solo string y se escribe de una vez
+    std::string text;
+    char line[256];
+    size_t written = 0;
+
+    for (; t != h; t++) {
+        int len = format(ring[t & (CAPACITY - 1)], true, line, sizeof(line));
+        text.append(line, len);
+        text.push_back('\n');
+        written++;
+    }
+    // El slot queda libre en cuanto se copió al texto
+    tail.store(t, std::memory_order_release);
+
+    uint64_t lost = drops.load(std::memory_order_relaxed);
+    if (lost != reported_drops) {
+        int len = std::snprintf(line, sizeof(line), "[log] %llu registros descartados (buffer lleno)\n",
+                                static_cast<unsigned long long>(lost - reported_drops));
+        text.append(line, len);
+        reported_drops = lost;
+    }
+
+    out.write(text.data(), static_cast<std::streamsize>(text.size()));
+    out.flush();
+    return written;
+}
+
+void logger::endFrame()
+{
+#ifdef __EMSCRIPTEN__
+    if (ring) drain();
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+void logger::run()
+{
+    while (running.load(std::memory_order_acquire)) {
+        // Sin nada pendiente se duerme un poco en vez de girar
+        if (drain() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+#endif
+
+// ============================================================
+// FORMATO
+// ============================================================
+void logger::fill(Record& record, trace::Category category, const char* event,
+                  std::initializer_list<trace::Field> fields)
+{
+    record.cycle       = 0;
+    record.event       = event;
+    record.category    = static_cast<uint8_t>(category);
+    record.field_count = 0;
+    record.hex_mask    = 0;
+
+    for (const trace::Field& field : fields) {
+        if (record.field_count == MAX_FIELDS) break;
+        record.keys[record.field_count]   = field.key;
+        record.values[record.field_count] = field.value;
+        if (field.hex) record.hex_mask |= 1 << record.field_count;
+        record.field_count++;
+    }
+}
+
+//   @1234567 [irq] serviced bit=0 pc=0x0150 vector=0x0040
+int logger::format(const Record& record, bool with_cycle, char* line, size_t size)
+{
+    int len = with_cycle
+        ? std::snprintf(line, size, "@%llu [%s] %s",
+                        static_cast<unsigned long long>(record.cycle),
+                        CATEGORY_NAMES[record.category], record.event)
+        : std::snprintf(line, size, "[%s] %s",
+                        CATEGORY_NAMES[record.category], record.event);
+
+    for (int i = 0; i < record.field_count; i++) {
+        if (len >= static_cast<int>(size)) break;
+        len += std::snprintf(line + len, size - len,
+                             (record.hex_mask & (1 << i)) ? " %s=0x%04X" : " %s=%u",
+                             record.keys[i], static_cast<unsigned>(record.values[i]));
+    }
+
+    if (len >= static_cast<int>(size)) len = static_cast<int>(size) - 1;
+    return len;
+}
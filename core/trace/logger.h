@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <iosfwd>
+#include <memory>
+
+#ifndef __EMSCRIPTEN__
+#include <thread>
+#endif
+
+#include "trace.h"
+
+class scheduler;
+
+// ============================================================
+// LOGGER - Registro asíncrono de las trazas del core
+// ============================================================
+// Las sondas GB_TRACE_* no escriben en std::cout: copian un registro
+// binario de tamaño fijo (ciclo, categoría, evento y campos) en un
+// ring buffer SPSC propio de cada gameboy. El hilo de emulación es
+// el único productor y nunca espera: si el buffer está lleno el
+// registro se descarta y se cuenta.
+//
+// El consumidor formatea y escribe los registros:
+//   nativo   un hilo en segundo plano vacía el buffer continuamente
+//   wasm     no hay hilos; gameboy::run_frame llama a drain() al
+//            final de cada frame
+//
+// El buffer y el hilo se crean con el primer registro: una máquina
+// cuyas sondas nunca disparan (o un hijo de fork que no llega a correr)
+// no cuesta ni memoria ni un hilo. Con GB_TRACE_LEVEL=0 no hay sondas,
+// así que nunca se crean.
+// ============================================================
+
+class logger
+{
+public:
+    static constexpr int    MAX_FIELDS = 6;
+    static constexpr size_t CAPACITY   = 16384;  // Potencia de 2
+
+    // Registro tal cual se guarda en el ring buffer. Los textos son
+    // literales de las sondas, así que basta con guardar el puntero.
+    struct Record {
+        uint64_t    cycle;
+        const char* event;
+        const char* keys[MAX_FIELDS];
+        uint32_t    values[MAX_FIELDS];
+        uint8_t     category;
+        uint8_t     field_count;
+        uint8_t     hex_mask;     // Bit i = campo i en hexadecimal
+    };
+
+    explicit logger(std::ostream& out);
+    ~logger();
+
+    logger(const logger&) = delete;
+    logger& operator=(const logger&) = delete;
+
+    // Reloj del que se toma el ciclo de cada registro
+    void setClock(const scheduler* clock_ref) { clock = clock_ref; }
+
+    // --- Productor (hilo de emulación) ---
+    // Devuelve false si el buffer estaba lleno y el registro se perdió
+    bool push(trace::Category category, const char* event,
+              std::initializer_list<trace::Field> fields);
+
+    // --- Consumidor ---
+    // Formatea y escribe todo lo pendiente. Devuelve los registros escritos.
+    size_t drain();
+
+    // En wasm vacía el buffer; en nativo ya lo hace el hilo
+    void endFrame();
+
+    // true = push descarta los registros sin contarlos como perdidos
+    // (frames ocultos del run-ahead)
+    void setMuted(bool on) { muted = on; }
+
+    uint64_t dropped() const { return drops.load(std::memory_order_relaxed); }
+
+    // Copia una sonda en un registro (con cycle = 0)
+    static void fill(Record& record, trace::Category category, const char* event,
+                     std::initializer_list<trace::Field> fields);
+
+    // Formatea un registro en 'line' (sin salto de línea). Devuelve la longitud.
+    static int format(const Record& record, bool with_cycle, char* line, size_t size);
+
+private:
+    std::unique_ptr<Record[]> ring;   // nullptr hasta el primer registro
+
+    // Cada índice en su propia línea de caché: head solo lo escribe el
+    // productor y tail solo el consumidor
+    alignas(64) std::atomic<size_t>   head{0};
+    alignas(64) std::atomic<size_t>   tail{0};
+    alignas(64) std::atomic<uint64_t> drops{0};
+    uint64_t reported_drops = 0;      // Solo lo toca el consumidor
+
+    std::ostream&    out;
+    const scheduler* clock = nullptr;
+    bool             muted = false;   // Solo lo toca el productor
+
+    // Reserva el buffer y arranca el consumidor (primer push)
+    void start();
+
+#ifndef __EMSCRIPTEN__
+    std::thread       worker;
+    std::atomic<bool> running{false};
+    void run();
+#endif
+};
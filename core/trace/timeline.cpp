@@ -0,0 +1,132 @@
+#include "timeline.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+
+#include "scheduler/scheduler.h"
+
+// 4194304 T-cycles por segundo → µs
+static constexpr double CYCLES_PER_US = 4.194304;
+
+// Proceso/hilo de cada pista en el visor
+struct TrackInfo {
+    int         pid;
+    int         tid;
+    const char* name;
+};
+
+static const TrackInfo TRACKS[timeline::TrackCount] = {
+    { 1, 1, "frames" },
+    { 1, 2, "cpu" },
+    { 1, 3, "interrupts" },
+    { 1, 4, "memory" },
+    { 2, 1, "main_loop" },
+    { 2, 2, "audio" },
+};
+
+static bool isHostTrack(timeline::Track track) { return TRACKS[track].pid == 2; }
+
+// --- Constructor ---
+timeline::timeline(size_t max_events_limit)
+    : max_events(max_events_limit)
+    , host_start(std::chrono::steady_clock::now())
+{
+    events.reserve(std::min<size_t>(max_events, 1 << 16));
+}
+
+void timeline::add(const Event& event)
+{
+    if (events.size() >= max_events) { drops++; return; }
+    events.push_back(event);
+}
+
+// ============================================================
+// PISTAS EMULADAS
+// ============================================================
+uint64_t timeline::cycleNow() const
+{
+    return clock ? clock->now() : 0;
+}
+
+void timeline::instant(Track track, const char* name, const char* arg_name, uint32_t arg)
+{
+    add(Event{ name, arg_name, cycleNow(), 0, arg, track, 'i' });
+}
+
+void timeline::complete(Track track, const char* name, uint64_t start_cycle, uint64_t end_cycle,
+                        const char* arg_name, uint32_t arg)
+{
+    add(Event{ name, arg_name, start_cycle, end_cycle - start_cycle, arg, track, 'X' });
+}
+
+// ============================================================
+// PISTAS DE HOST
+// ============================================================
+uint64_t timeline::hostNow() const
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now() - host_start).count();
+}
+
+void timeline::hostInstant(Track track, const char* name, const char* arg_name, uint32_t arg)
+{
+    add(Event{ name, arg_name, hostNow(), 0, arg, track, 'i' });
+}
+
+void timeline::hostComplete(Track track, const char* name, uint64_t start_ns, uint64_t end_ns,
+                            const char* arg_name, uint32_t arg)
+{
+    add(Event{ name, arg_name, start_ns, end_ns - start_ns, arg, track, 'X' });
+}
+
+// ============================================================
+// EXPORTACIÓN
+// ============================================================
+//   {"traceEvents":[
+//     {"name":"frame","ph":"X","pid":1,"tid":1,"ts":16742.4,"dur":16742.7,"args":{"frame":2}},
+//     ...
+//   ]}
+bool timeline::write(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Timeline] ERROR: no se pudo escribir " << path << "\n";
+        return false;
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+    // Nombres de procesos e hilos
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Emulated\"}},\n"
+        << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"Host\"}}";
+    for (const TrackInfo& info : TRACKS) {
+        out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << info.pid
+            << ",\"tid\":" << info.tid << ",\"args\":{\"name\":\"" << info.name << "\"}}";
+    }
+
+    char line[256];
+    for (const Event& e : events) {
+        // Emuladas: ciclos → µs de Game Boy; host: ns → µs
+        double scale = isHostTrack(e.track) ? 1000.0 : CYCLES_PER_US;
+        const TrackInfo& info = TRACKS[e.track];
+
+        int len = std::snprintf(line, sizeof(line),
+                                ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f",
+                                e.name, e.phase, info.pid, info.tid, e.ts / scale);
+        if (e.phase == 'X')
+            len += std::snprintf(line + len, sizeof(line) - len, ",\"dur\":%.3f", e.dur / scale);
+        else
+            len += std::snprintf(line + len, sizeof(line) - len, ",\"s\":\"t\"");
+        if (e.arg_name)
+            len += std::snprintf(line + len, sizeof(line) - len, ",\"args\":{\"%s\":%u}",
+                                 e.arg_name, static_cast<unsigned>(e.arg));
+        out.write(line, len);
+        out << "}";
+    }
+
+    out << "\n],\"otherData\":{\"events\":" << events.size()
+        << ",\"dropped\":" << drops << "}}\n";
+    return static_cast<bool>(out);
+}
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class scheduler;
+
+// ============================================================
+// TIMELINE - Línea de tiempo en formato Chrome trace-event (JSON)
+// ============================================================
+// Tracer opcional para investigar latencias: guarda eventos en
+// memoria durante la sesión y write() los vuelca al final como JSON
+// de trace-event, que abren chrome://tracing, Perfetto y speedscope.
+//
+// Dos procesos en el visor:
+//   "Emulated"  eventos con el T-cycle del scheduler (convertido a µs
+//               de Game Boy: 4194304 ciclos = 1 s). Pistas: frames,
+//               cpu (HALT), interrupts, memory (DMA, bancos).
+//   "Host"      tiempo real del host desde start. Pistas: main_loop
+//               (fases del bucle del frontend) y audio (rellenos del
+//               buffer de salida).
+//
+// Se conecta con gameboy::setTimeline(); sin timeline los componentes
+// solo comprueban un puntero nulo en eventos poco frecuentes.
+// ============================================================
+
+class timeline
+{
+public:
+    enum Track : uint8_t {
+        Frames,        // Emulated
+        Cpu,
+        Interrupts,
+        Memory,
+        MainLoop,      // Host
+        Audio,
+        TrackCount
+    };
+
+    // Pasado max_events los eventos se descartan (y se cuentan)
+    explicit timeline(size_t max_events = 1 << 22);
+
+    void setClock(const scheduler* clock_ref) { clock = clock_ref; }
+
+    // --- Pistas emuladas (T-cycles) ---
+    void instant(Track track, const char* name, const char* arg_name = nullptr, uint32_t arg = 0);
+    void complete(Track track, const char* name, uint64_t start_cycle, uint64_t end_cycle,
+                  const char* arg_name = nullptr, uint32_t arg = 0);
+    uint64_t cycleNow() const;
+
+    // --- Pistas de host (ns desde la creación) ---
+    uint64_t hostNow() const;
+    void hostInstant(Track track, const char* name, const char* arg_name = nullptr, uint32_t arg = 0);
+    void hostComplete(Track track, const char* name, uint64_t start_ns, uint64_t end_ns,
+                      const char* arg_name = nullptr, uint32_t arg = 0);
+
+    // Mide una fase del bucle del frontend mientras vive
+    class host_scope
+    {
+    public:
+        host_scope(timeline* owner, Track track, const char* name)
+            : tl(owner), track(track), name(name), start(owner ? owner->hostNow() : 0) {}
+        ~host_scope() { if (tl) tl->hostComplete(track, name, start, tl->hostNow()); }
+
+        host_scope(const host_scope&) = delete;
+        host_scope& operator=(const host_scope&) = delete;
+
+    private:
+        timeline*   tl;
+        Track       track;
+        const char* name;
+        uint64_t    start;
+    };
+
+    // Escribe el JSON. Devuelve false si no se pudo abrir el archivo.
+    bool write(const std::string& path) const;
+
+    size_t   size()    const { return events.size(); }
+    uint64_t dropped() const { return drops; }
+
+private:
+    // Los nombres son literales: basta con guardar el puntero
+    struct Event {
+        const char* name;
+        const char* arg_name;   // nullptr = sin argumento
+        uint64_t    ts;         // Ciclos (pistas emuladas) o ns (host)
+        uint64_t    dur;
+        uint32_t    arg;
+        Track       track;
+        char        phase;      // 'X' completo, 'i' instantáneo
+    };
+
+    std::vector<Event> events;
+    size_t   max_events;
+    uint64_t drops = 0;
+
+    const scheduler* clock = nullptr;
+    std::chrono::steady_clock::time_point host_start;
+
+    void add(const Event& event);
+};
@@ -0,0 +1,33 @@
+#include "trace.h"
+
+#include <iostream>
+
+#include "logger.h"
+
+namespace trace {
+
+// Logger de la máquina que se está emulando en este hilo
+static thread_local logger* current_sink = nullptr;
+
+void bind(logger* sink)   { current_sink = sink; }
+void unbind(logger* sink) { if (current_sink == sink) current_sink = nullptr; }
+
+void emit(Category category, const char* event, std::initializer_list<Field> fields)
+{
+    if (current_sink) {
+        current_sink->push(category, event, fields);
+        return;
+    }
+
+    // Sin gameboy (p. ej. componentes sueltos en gb-bench): escritura
+    // síncrona con el mismo formato, sin ciclo
+    logger::Record record;
+    logger::fill(record, category, event, fields);
+
+    char line[256];
+    int  len = logger::format(record, false, line, sizeof(line) - 1);
+    line[len++] = '\n';
+    std::cout.write(line, len);
+}
+
+} // namespace trace
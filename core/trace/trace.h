@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+
+// ============================================================
+// TRACE - Sondas de depuración con nivel fijado en compilación
+// ============================================================
+// Toda la instrumentación de depuración del core pasa por estas
+// macros. El nivel se elige con la opción CMake GB_TRACE_LEVEL:
+//
+//   0  Sin trazas (default). Las sondas se expanden a ((void)0): no
+//      generan código ni evalúan sus argumentos.
+//   1  Eventos: interrupciones servidas, HALT, VBlank...
+//   2  Eventos + accesos: cada instrucción ejecutada, lecturas de
+//      LY/IF/joypad, escrituras de IF/DIV/joypad, IME...
+//
+// Cada sonda emite un evento estructurado que el logger de la máquina
+// (core/trace/logger.h) escribe de forma asíncrona, una línea por
+// evento con el T-cycle del scheduler:
+//
+//   @1234567 [irq] serviced bit=0 pc=0x0150 vector=0x0040
+//
+// Uso:
+//   GB_TRACE_EVENT(Irq, "serviced", { trace::dec("bit", bit), trace::hex("pc", PC) });
+//   GB_TRACE_ACCESS(Mmu, "if_read", { trace::hex("value", v) });
+// ============================================================
+
+#ifndef GB_TRACE_LEVEL
+#define GB_TRACE_LEVEL 0
+#endif
+
+class logger;
+
+namespace trace {
+
+enum class Category : uint8_t {
+    Cpu,
+    Irq,
+    Mmu,
+    Ppu,
+    Timer,
+    Joypad,
+};
+
+struct Field {
+    const char* key;
+    uint32_t    value;
+    bool        hex;
+};
+
+inline Field dec(const char* key, uint32_t value) { return { key, value, false }; }
+inline Field hex(const char* key, uint32_t value) { return { key, value, true }; }
+
+// Registra un evento (solo se llama desde las macros). Si hay un
+// logger asociado al hilo va a su ring buffer; si no, se escribe
+// directamente en std::cout.
+void emit(Category category, const char* event, std::initializer_list<Field> fields = {});
+
+// Asocia el logger de una máquina al hilo que la emula
+// (gameboy::run_frame lo hace al empezar cada frame)
+void bind(logger* sink);
+void unbind(logger* sink);
+
+} // namespace trace
+
+#if GB_TRACE_LEVEL >= 1
+#define GB_TRACE_EVENT(category, ...)  ::trace::emit(::trace::Category::category, __VA_ARGS__)
+#else
+#define GB_TRACE_EVENT(category, ...)  ((void)0)
+#endif
+
+#if GB_TRACE_LEVEL >= 2
+#define GB_TRACE_ACCESS(category, ...) ::trace::emit(::trace::Category::category, __VA_ARGS__)
+#else
+#define GB_TRACE_ACCESS(category, ...) ((void)0)
+#endif
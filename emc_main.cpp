@@ -7,35 +7,49 @@
 #include <vector>
 #include <emscripten.h>
 
-#include "core/cpu/mmu/mmu.h"
-#include "core/cpu/cpu.h"
-#include "core/cpu/ppu/ppu.h"
-#include "core/cpu/timer/timer.h"
-#include "core/cpu/APU/apu.h"
-
-// Punteros globales
-cpu* global_cpu = nullptr;
-ppu* global_ppu = nullptr;
-mmu* global_mmu = nullptr;
-timer* global_timer = nullptr;
-APU* global_apu = nullptr;
+#include "core/gameboy.h"
+#include "core/profiler/opcode_profile.h"
+#include "core/state/rewind_buffer.h"
+
+// Máquina global (MMU + CPU + PPU + Timer + APU)
+gameboy* global_gb = nullptr;
 
 // Estado del sistema
 bool is_game_loaded = false;
 bool audio_muted = false;
+bool perf_timing = false;
+int  run_ahead_frames = 0;   // 0 = sin run-ahead
+
+// Línea de tiempo de la sesión (nullptr = apagada)
+timeline* session_timeline = nullptr;
+
+// Coste por opcode de la sesión (nullptr = apagado)
+opcode_profile* session_opcodes = nullptr;
+
+// Buffer de save state compartido con JS (se reutiliza entre capturas)
+std::vector<uint8_t> session_state;
+
+// Último hash del estado (get_state_hash)
+uint64_t session_state_hash = 0;
+
+// Historial para rebobinar (nullptr = apagado). Mientras 'rewinding'
+// es true, main_loop retrocede una captura por frame en vez de emular.
+rewind_buffer* session_rewind = nullptr;
+bool rewinding = false;
 
 // --- FUNCIÓN DE LIMPIEZA ---
 // Borra la memoria del juego anterior antes de cargar uno nuevo
 void reset_emulator() {
     is_game_loaded = false;
 
-    if (global_cpu) { delete global_cpu; global_cpu = nullptr; }
-    if (global_timer) { delete global_timer; global_timer = nullptr; }
-    if (global_ppu) { delete global_ppu; global_ppu = nullptr; }
-    if (global_apu) { delete global_apu; global_apu = nullptr; }
-    
-    // MMU se borra al final porque otros componentes dependen de él en su destructor
-    if (global_mmu) { delete global_mmu; global_mmu = nullptr; }
+    // gameboy destruye sus componentes en orden inverso (MMU al final)
+    if (global_gb) { delete global_gb; global_gb = nullptr; }
+
+    // La línea de tiempo es de la sesión anterior: sin volcar se pierde
+    if (session_timeline) { delete session_timeline; session_timeline = nullptr; }
+    if (session_opcodes)  { delete session_opcodes;  session_opcodes  = nullptr; }
+    if (session_rewind)   { delete session_rewind;   session_rewind   = nullptr; }
+    rewinding = false;
     
     std::cout << "[C++] Memoria liberada. Listo para cargar ROM.\n";
 }
@@ -43,7 +57,7 @@ void reset_emulator() {
 extern "C" {
     // --- VIDEO ---
     uint8_t* get_video_buffer() {
-        if (global_ppu) return reinterpret_cast<uint8_t*>(global_ppu->gfx.data());
+        if (global_gb) return reinterpret_cast<uint8_t*>(global_gb->video.gfx.data());
         return nullptr;
     }
     
@@ -51,27 +65,193 @@ extern "C" {
     
     // --- INPUT ---
     void set_button(int button_id, bool pressed) {
-        if (global_mmu) global_mmu->setButton(button_id, pressed);
+        if (global_gb) global_gb->memory.setButton(button_id, pressed);
     }
     
     // --- AUDIO ---
     float* get_audio_buffer() {
-        if (global_apu) return global_apu->getBufferPointer();
+        if (global_gb) return global_gb->apu.getBufferPointer();
         return nullptr;
     }
     
     int get_audio_samples_available() {
-        if (global_apu) return global_apu->getSamplesAvailable();
+        if (global_gb) return global_gb->apu.getSamplesAvailable();
         return 0;
     }
     
     int fill_audio_buffer(int maxSamples) {
-        if (global_apu) return global_apu->fillOutputBuffer(maxSamples);
+        if (global_gb) return global_gb->apu.fillOutputBuffer(maxSamples);
         return 0;
     }
     
     void set_audio_muted(bool muted) {
         audio_muted = muted;
+        if (global_gb) global_gb->audio_enabled = !muted;
+    }
+
+    // --- RUN-AHEAD ---
+    // Muestra cada frame 'frames' frames por delante de la partida: la
+    // respuesta a set_button se ve antes (1-2 bastan para la mayoría de
+    // juegos; cada frame extra cuesta un frame emulado más por refresco)
+    void set_run_ahead(int frames) { run_ahead_frames = frames > 0 ? frames : 0; }
+
+    // --- TELEMETRÍA ---
+    // Puntero al gb_perf_stats del último frame (core/perf/perf_stats.h).
+    // Todos los campos son uint32: JS lo lee con HEAPU32[ptr >> 2 ...].
+    const gb_perf_stats* get_perf_stats() {
+        if (global_gb) return &global_gb->perf;
+        return nullptr;
+    }
+
+    int get_perf_stats_size() { return sizeof(gb_perf_stats); }
+
+    // Mide también el tiempo de host por componente (cpu/ppu/timer/apu)
+    void set_perf_timing(bool enabled) {
+        perf_timing = enabled;
+        if (global_gb) global_gb->perf_timing = enabled;
+    }
+
+    // --- MAPA DE CALOR DEL BUS (build con GB_MEM_HEATMAP) ---
+    // Puntero al gb_mem_heatmap del último frame (cumulative = 0) o al
+    // acumulado desde la carga. Campos uint64: JS usa BigUint64Array.
+    // nullptr si no hay juego o la build no lo incluye.
+    const void* get_mem_heatmap(bool cumulative) {
+#ifdef GB_MEM_HEATMAP
+        if (global_gb) {
+            const mem_heatmap& map = global_gb->memory.memHeatmap();
+            return cumulative ? &map.total() : &map.lastFrame();
+        }
+#endif
+        (void)cumulative;
+        return nullptr;
+    }
+
+    int get_mem_heatmap_size() {
+#ifdef GB_MEM_HEATMAP
+        return sizeof(gb_mem_heatmap);
+#else
+        return 0;
+#endif
+    }
+
+    // Escribe la vista elegida como JSON en el FS virtual (0 = OK)
+    int write_mem_heatmap(char* path, bool cumulative) {
+#ifdef GB_MEM_HEATMAP
+        if (global_gb) {
+            const mem_heatmap& map = global_gb->memory.memHeatmap();
+            return mem_heatmap::write(cumulative ? map.total() : map.lastFrame(), path) ? 0 : -1;
+        }
+#endif
+        (void)path; (void)cumulative;
+        return -1;
+    }
+
+    // --- COSTE POR OPCODE ---
+    // Empieza a contar (o reinicia) para el juego cargado. host_period > 0
+    // cronometra además 1 de cada host_period instrucciones. El JIT no
+    // existe en la build web, así que no cambia el motor.
+    void start_opcode_profile(int host_period) {
+        if (!global_gb) return;
+        delete session_opcodes;
+        session_opcodes = new opcode_profile(host_period > 0 ? host_period : 0);
+        global_gb->processor.setOpcodeProfile(session_opcodes);
+    }
+
+    void stop_opcode_profile() {
+        if (global_gb) global_gb->processor.setOpcodeProfile(nullptr);
+    }
+
+    // Puntero al gb_opcode_profile (core/profiler/opcode_profile.h): campos
+    // uint64, JS los lee con BigUint64Array. Sigue siendo válido tras
+    // stop_opcode_profile() hasta el siguiente start o la próxima ROM.
+    const gb_opcode_profile* get_opcode_profile() {
+        if (session_opcodes) return &session_opcodes->data();
+        return nullptr;
+    }
+
+    int get_opcode_profile_size() { return sizeof(gb_opcode_profile); }
+
+    // Escribe el JSON en el FS virtual (0 = OK)
+    int write_opcode_profile(char* path) {
+        if (!session_opcodes) return -1;
+        return session_opcodes->write(path) ? 0 : -1;
+    }
+
+    // --- SAVE STATES ---
+    // Captura la máquina en el buffer de la sesión y devuelve su tamaño
+    // (0 sin juego). JS copia HEAPU8.subarray(get_state_buffer(), +size).
+    int save_state() {
+        if (!global_gb) return 0;
+        global_gb->saveState(session_state);
+        return static_cast<int>(session_state.size());
+    }
+
+    uint8_t* get_state_buffer() { return session_state.data(); }
+
+    // Para cargar: JS pide un buffer de 'size' bytes, escribe el state
+    // en él y llama a load_state(size). Devuelve 1 si se restauró.
+    uint8_t* prepare_state_buffer(int size) {
+        session_state.resize(size > 0 ? size : 0);
+        return session_state.data();
+    }
+
+    int load_state(int size) {
+        if (!global_gb || size < 0 || static_cast<size_t>(size) > session_state.size()) return 0;
+        return global_gb->loadState(session_state.data(), size) ? 1 : 0;
+    }
+
+    // Hash XXH64 del estado de la máquina (gameboy::stateHash) para
+    // comparar repeticiones frame a frame. Puntero a un uint64: JS lo
+    // lee con BigUint64Array. nullptr si no hay juego.
+    const uint64_t* get_state_hash() {
+        if (!global_gb) return nullptr;
+        session_state_hash = global_gb->stateHash();
+        return &session_state_hash;
+    }
+
+    // --- REBOBINAR ---
+    // Empieza a guardar historial: una captura cada 'interval' frames en
+    // un anillo de 'budget_mb' MB (las capturas viejas se descartan)
+    void start_rewind(int budget_mb, int interval) {
+        delete session_rewind;
+        session_rewind = new rewind_buffer(static_cast<size_t>(budget_mb > 0 ? budget_mb : 0) << 20,
+                                           interval > 0 ? interval : 1);
+        rewinding = false;
+    }
+
+    void stop_rewind() {
+        delete session_rewind;
+        session_rewind = nullptr;
+        rewinding = false;
+    }
+
+    // Mientras está activo (tecla mantenida), cada frame retrocede una
+    // captura; al soltarlo la emulación sigue desde ahí
+    void set_rewinding(bool active) { rewinding = active && session_rewind; }
+
+    // Frames de historial disponibles
+    int get_rewind_frames() {
+        return session_rewind ? static_cast<int>(session_rewind->framesHeld()) : 0;
+    }
+
+    // --- LÍNEA DE TIEMPO (Chrome trace JSON) ---
+    // Empieza a grabar eventos en memoria para el juego cargado
+    void start_timeline() {
+        if (!global_gb || session_timeline) return;
+        session_timeline = new timeline();
+        global_gb->setTimeline(session_timeline);
+    }
+
+    // Termina la sesión y escribe el JSON en el FS virtual (JS lo lee
+    // con FS.readFile). Devuelve los eventos escritos o -1 si falla.
+    int stop_timeline(char* path) {
+        if (!session_timeline) return -1;
+        if (global_gb) global_gb->setTimeline(nullptr);
+
+        int written = session_timeline->write(path) ? static_cast<int>(session_timeline->size()) : -1;
+        delete session_timeline;
+        session_timeline = nullptr;
+        return written;
     }
 
     // ============================================================
@@ -86,22 +266,10 @@ extern "C" {
         try {
             std::string romPath(filename);
 
-            // 1. Inicializar MMU (Carga el archivo desde el FS virtual)
-            global_mmu = new mmu(romPath);
-            
-            // 2. Inicializar resto de componentes
-            const bool enable_debug = false; // Debug off para mejor rendimiento en web
-            
-            global_ppu = new ppu(*global_mmu);
-            global_ppu->enable_debug(enable_debug);
-            
-            global_timer = new timer(*global_mmu);
-            global_timer->enable_debug(enable_debug);
-            
-            global_cpu = new cpu(*global_mmu);
-            
-            global_apu = new APU();
-            global_mmu->setAPU(global_apu);
+            // 1. Inicializar la máquina (el MMU carga el archivo desde el FS virtual)
+            global_gb = new gameboy(romPath);
+            global_gb->audio_enabled = !audio_muted;
+            global_gb->perf_timing = perf_timing;
             
             std::cout << "[C++] Componentes inicializados. Juego arrancando...\n";
             is_game_loaded = true;
@@ -120,28 +288,21 @@ extern "C" {
 // ============================================================
 void main_loop() {
     // Si no hay juego cargado, no hacemos nada (CPU idle)
-    if (!is_game_loaded || !global_cpu) {
+    if (!is_game_loaded || !global_gb) {
         return; 
     }
 
-    const int T_CYCLES_PER_FRAME = 70224;
-    int t_cycles_this_frame = 0;
-
-    while (t_cycles_this_frame < T_CYCLES_PER_FRAME) {
-        int cpu_t_cycles = global_cpu->step();
-        if (cpu_t_cycles < 4) cpu_t_cycles = 4;
-        
-        global_ppu->step(cpu_t_cycles);
-        global_timer->step(cpu_t_cycles);
-        
-        if (!audio_muted) {
-            global_apu->tick(cpu_t_cycles);
-        }
-        
-        t_cycles_this_frame += cpu_t_cycles;
+    if (rewinding) {
+        timeline::host_scope phase(session_timeline, timeline::MainLoop, "rewind");
+        session_rewind->stepBack(*global_gb);
+    } else {
+        timeline::host_scope phase(session_timeline, timeline::MainLoop, "run_frame");
+        global_gb->run_ahead_frame(run_ahead_frames);
+        if (session_rewind) session_rewind->onFrame(*global_gb);
     }
 
     // Dibujar pantalla
+    timeline::host_scope phase(session_timeline, timeline::MainLoop, "draw");
     EM_ASM({
         if (typeof drawCanvas === 'function') {
             drawCanvas();
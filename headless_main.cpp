@@ -0,0 +1,553 @@
+// ============================================================
+// HEADLESS_MAIN.CPP - RUNNER NATIVO (SIN EMSCRIPTEN)
+// ============================================================
+// Ejecuta el mismo core que la build web, sin navegador, para
+// trabajo por lotes y profiling en Linux:
+//
+//   gb-emu-headless <rom.gb> [--frames N] [--cycles N]
+//                   [--hash] [--hash-frames] [--dump salida.ppm]
+//                   [--state-hash] [--state-hash-frames]
+//                   [--engine table|switch|cached|jit] [--perf-map]
+//                   [--no-audio] [--verbose]
+//                   [--sym juego.sym] [--profile-folded pilas.txt]
+//                   [--profile-pprof perfil.pb] [--profile-top N]
+//                   [--perf-stats] [--timeline traza.json]
+//                   [--coverage cobertura.bin|.json]
+//                   [--heatmap accesos.json] [--heatmap-frame]
+//                   [--opcode-profile opcodes.json] [--opcode-top N]
+//                   [--opcode-host-sample N]
+//                   [--load-state estado.gbs] [--save-state estado.gbs]
+//                   [--rewind N] [--rewind-interval N] [--rewind-mb N]
+//                   [--run-ahead N] [--fork N] [--fork-frames N]
+//
+// Al terminar imprime los frames emulados, los T-cycles y los
+// frames por segundo emulados (throughput del core).
+// ============================================================
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/gameboy.h"
+#include "core/profiler/profiler.h"
+#include "core/profiler/opcode_profile.h"
+#include "core/state/rewind_buffer.h"
+
+namespace {
+
+struct Options {
+    std::string rom_path;
+    uint64_t    frames      = 600;   // 10 segundos emulados por defecto
+    uint64_t    cycles      = 0;     // 0 = sin límite de ciclos
+    bool        hash        = false;
+    bool        hash_frames = false;
+    bool        state_hash  = false; // Hash del estado completo al terminar
+    bool        state_hash_frames = false; // ... y después de cada frame
+    std::string dump_path;
+    bool        audio       = true;
+    std::string engine;              // vacío = motor por defecto de la build
+    bool        perf_map    = false;
+    bool        verbose     = false;
+    std::string sym_path;            // Símbolos RGBDS/no$gmb para el profiler
+    std::string folded_path;         // Pilas colapsadas (flamegraph)
+    std::string pprof_path;          // Perfil protobuf de pprof
+    int         profile_top = 0;     // Ubicaciones más calientes a listar
+    bool        perf_stats  = false; // Telemetría del último frame (gb_perf_stats)
+    std::string timeline_path;       // Chrome trace-event JSON de la sesión
+    std::string coverage_path;       // Cobertura de la ROM (build con GB_COVERAGE)
+    std::string heatmap_path;        // Accesos por página/registro (build con GB_MEM_HEATMAP)
+    bool        heatmap_frame = false; // Solo el último frame en vez del acumulado
+    std::string opcode_path;         // Coste por opcode base/CB (JSON)
+    int         opcode_top  = 0;     // Opcodes más caros a listar
+    uint32_t    opcode_host = 0;     // Cronometrar 1 de cada N instrucciones (0 = no)
+    std::string load_state_path;     // Save state a cargar antes de emular
+    std::string save_state_path;     // Save state a guardar al terminar
+    uint64_t    rewind_steps = 0;    // Pasos hacia atrás al terminar (0 = sin historial)
+    uint32_t    rewind_interval = 2; // Frames entre capturas
+    size_t      rewind_mb = 16;      // Tamaño del anillo de deltas
+    int         run_ahead = 0;       // Frames emulados por delante (0 = apagado)
+    int         fork_children = 0;   // Hijos copy-on-write a comprobar al terminar
+    uint64_t    fork_frames = 60;    // Frames que corre cada hijo (y el padre)
+
+    bool opcodeProfiling() const { return !opcode_path.empty() || opcode_top > 0; }
+
+    bool profiling() const { return !folded_path.empty() || !pprof_path.empty() || profile_top > 0; }
+};
+
+void print_usage(const char* argv0)
+{
+    std::cerr << "Uso: " << argv0 << " <rom.gb> [opciones]\n"
+              << "  --frames N     Emular N frames (default 600)\n"
+              << "  --cycles N     Detenerse al alcanzar N T-cycles\n"
+              << "  --hash         Imprimir hash FNV-1a del último frame\n"
+              << "  --hash-frames  Imprimir el hash de cada frame\n"
+              << "  --state-hash   Imprimir el hash XXH64 del estado de la máquina (y su coste)\n"
+              << "  --state-hash-frames  Imprimir el hash del estado de cada frame\n"
+              << "  --dump FILE    Guardar el último frame como PPM (P6)\n"
+              << "  --engine E     Motor de la CPU: table | switch | cached | jit\n"
+              << "  --perf-map     Escribir /tmp/perf-<pid>.map con los bloques del JIT\n"
+              << "  --no-audio     No avanzar la APU\n"
+              << "  --verbose      Mantener los logs del core en stdout\n"
+              << "  --sym FILE     Símbolos .sym (RGBDS/no$gmb) para el profiler\n"
+              << "  --profile-folded FILE  Ciclos por pila de llamadas (flamegraph)\n"
+              << "  --profile-pprof FILE   Perfil protobuf para 'go tool pprof'\n"
+              << "  --profile-top N        Listar las N ubicaciones (banco:PC) más calientes\n"
+              << "  --perf-stats   Imprimir la telemetría del último frame (con tiempos de host)\n"
+              << "  --timeline FILE  Guardar la línea de tiempo (Chrome trace JSON) al terminar\n"
+              << "  --coverage FILE  Guardar la cobertura de la ROM (.json o binario; -DGB_COVERAGE=ON)\n"
+              << "  --heatmap FILE   Guardar los accesos por página y registro de I/O (-DGB_MEM_HEATMAP=ON)\n"
+              << "  --heatmap-frame  Exportar solo el último frame en lugar del acumulado\n"
+              << "  --opcode-profile FILE  Ejecuciones y ciclos por opcode base y CB (JSON)\n"
+              << "  --opcode-top N         Listar los N opcodes con más ciclos\n"
+              << "  --opcode-host-sample N Cronometrar en el host 1 de cada N instrucciones\n"
+              << "  --load-state FILE  Cargar un save state antes de emular (--frames sigue desde su frame)\n"
+              << "  --save-state FILE  Guardar un save state al terminar\n"
+              << "  --rewind N         Guardar historial y rebobinar N pasos al terminar\n"
+              << "  --rewind-interval N  Frames entre capturas del historial (default 2)\n"
+              << "  --rewind-mb N        Memoria del historial en MB (default 16)\n"
+              << "  --run-ahead N  Mostrar cada frame N frames por delante (run-ahead)\n"
+              << "  --fork N       Al terminar, hacer N forks y correrlos en N hilos junto al padre\n"
+              << "  --fork-frames N  Frames que corren el padre y cada hijo (default 60)\n";
+}
+
+bool parse_args(int argc, char** argv, Options& opt)
+{
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (!std::strcmp(arg, "--frames") && has_value) {
+            opt.frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--cycles") && has_value) {
+            opt.cycles = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--hash")) {
+            opt.hash = true;
+        } else if (!std::strcmp(arg, "--hash-frames")) {
+            opt.hash_frames = true;
+        } else if (!std::strcmp(arg, "--state-hash")) {
+            opt.state_hash = true;
+        } else if (!std::strcmp(arg, "--state-hash-frames")) {
+            opt.state_hash_frames = true;
+        } else if (!std::strcmp(arg, "--dump") && has_value) {
+            opt.dump_path = argv[++i];
+        } else if (!std::strcmp(arg, "--engine") && has_value) {
+            opt.engine = argv[++i];
+        } else if (!std::strcmp(arg, "--perf-map")) {
+            opt.perf_map = true;
+        } else if (!std::strcmp(arg, "--no-audio")) {
+            opt.audio = false;
+        } else if (!std::strcmp(arg, "--verbose")) {
+            opt.verbose = true;
+        } else if (!std::strcmp(arg, "--timeline") && has_value) {
+            opt.timeline_path = argv[++i];
+        } else if (!std::strcmp(arg, "--coverage") && has_value) {
+            opt.coverage_path = argv[++i];
+        } else if (!std::strcmp(arg, "--heatmap") && has_value) {
+            opt.heatmap_path = argv[++i];
+        } else if (!std::strcmp(arg, "--heatmap-frame")) {
+            opt.heatmap_frame = true;
+        } else if (!std::strcmp(arg, "--opcode-profile") && has_value) {
+            opt.opcode_path = argv[++i];
+        } else if (!std::strcmp(arg, "--opcode-top") && has_value) {
+            opt.opcode_top = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--opcode-host-sample") && has_value) {
+            opt.opcode_host = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(arg, "--load-state") && has_value) {
+            opt.load_state_path = argv[++i];
+        } else if (!std::strcmp(arg, "--save-state") && has_value) {
+            opt.save_state_path = argv[++i];
+        } else if (!std::strcmp(arg, "--rewind") && has_value) {
+            opt.rewind_steps = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--rewind-interval") && has_value) {
+            opt.rewind_interval = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (!std::strcmp(arg, "--rewind-mb") && has_value) {
+            opt.rewind_mb = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--run-ahead") && has_value) {
+            opt.run_ahead = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--fork") && has_value) {
+            opt.fork_children = std::atoi(argv[++i]);
+        } else if (!std::strcmp(arg, "--fork-frames") && has_value) {
+            opt.fork_frames = std::strtoull(argv[++i], nullptr, 10);
+        } else if (!std::strcmp(arg, "--perf-stats")) {
+            opt.perf_stats = true;
+        } else if (!std::strcmp(arg, "--sym") && has_value) {
+            opt.sym_path = argv[++i];
+        } else if (!std::strcmp(arg, "--profile-folded") && has_value) {
+            opt.folded_path = argv[++i];
+        } else if (!std::strcmp(arg, "--profile-pprof") && has_value) {
+            opt.pprof_path = argv[++i];
+        } else if (!std::strcmp(arg, "--profile-top") && has_value) {
+            opt.profile_top = std::atoi(argv[++i]);
+        } else if (arg[0] != '-' && opt.rom_path.empty()) {
+            opt.rom_path = arg;
+        } else {
+            std::cerr << "Argumento no reconocido: " << arg << "\n";
+            return false;
+        }
+    }
+    return !opt.rom_path.empty();
+}
+
+// FNV-1a de 64 bits sobre el framebuffer (160x144 ABGR)
+uint64_t frame_hash(const std::vector<uint32_t>& gfx)
+{
+    uint64_t h = 0xCBF29CE484222325ULL;
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(gfx.data());
+    for (size_t i = 0; i < gfx.size() * sizeof(uint32_t); i++) {
+        h ^= bytes[i];
+        h *= 0x100000001B3ULL;
+    }
+    return h;
+}
+
+// Guarda el framebuffer como PPM binario (P6). El formato de gfx es
+// 0xAABBGGRR, así que el byte bajo es R.
+bool dump_ppm(const std::string& path, const std::vector<uint32_t>& gfx)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) return false;
+
+    out << "P6\n160 144\n255\n";
+    for (uint32_t px : gfx) {
+        char rgb[3] = {
+            static_cast<char>(px & 0xFF),
+            static_cast<char>((px >> 8) & 0xFF),
+            static_cast<char>((px >> 16) & 0xFF)
+        };
+        out.write(rgb, 3);
+    }
+    return static_cast<bool>(out);
+}
+
+// Microsegundos transcurridos desde 'since'
+double elapsed_us(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Options opt;
+    if (!parse_args(argc, argv, opt)) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    // Los reportes del runner van por 'report'; std::cout queda para los
+    // logs del core y se silencia salvo con --verbose para que la E/S de
+    // la terminal no distorsione la medición.
+    std::ostream report(std::cout.rdbuf());
+    if (!opt.verbose) std::cout.rdbuf(nullptr);
+
+    gameboy gb(opt.rom_path);
+    if (!gb.is_loaded()) {
+        std::cerr << "[Headless] ERROR: no se pudo cargar la ROM: " << opt.rom_path << "\n";
+        return 1;
+    }
+    gb.audio_enabled = opt.audio;
+    gb.perf_timing   = opt.perf_stats;
+
+    if (opt.engine == "table") {
+        gb.processor.setEngine(cpu::Engine::Table);
+    } else if (opt.engine == "switch") {
+        gb.processor.setEngine(cpu::Engine::Switch);
+    } else if (opt.engine == "cached") {
+        gb.processor.setEngine(cpu::Engine::BlockCache);
+    } else if (opt.engine == "jit") {
+        gb.processor.setEngine(cpu::Engine::Jit);
+    } else if (!opt.engine.empty()) {
+        std::cerr << "[Headless] Motor desconocido: " << opt.engine << "\n";
+        return 2;
+    }
+    gb.processor.setJitPerfMap(opt.perf_map);
+
+    // Profiler del juego (desactiva el JIT mientras está conectado)
+    profiler prof(gb.memory);
+    if (opt.profiling() || !opt.sym_path.empty()) {
+        if (!opt.sym_path.empty() && !prof.loadSymbols(opt.sym_path)) return 1;
+        gb.processor.setProfiler(&prof);
+    }
+
+    // Coste por opcode (también desactiva el JIT)
+    opcode_profile opcodes(opt.opcode_host);
+    if (opt.opcodeProfiling()) gb.processor.setOpcodeProfile(&opcodes);
+
+#ifndef GB_COVERAGE
+    if (!opt.coverage_path.empty()) {
+        std::cerr << "[Headless] --coverage necesita una build con -DGB_COVERAGE=ON\n";
+        return 2;
+    }
+#endif
+#ifndef GB_MEM_HEATMAP
+    if (!opt.heatmap_path.empty()) {
+        std::cerr << "[Headless] --heatmap necesita una build con -DGB_MEM_HEATMAP=ON\n";
+        return 2;
+    }
+#endif
+
+    // Línea de tiempo en memoria; se escribe al terminar la sesión
+    std::unique_ptr<timeline> session_timeline;
+    if (!opt.timeline_path.empty()) {
+        session_timeline = std::make_unique<timeline>();
+        gb.setTimeline(session_timeline.get());
+    }
+    timeline* tl = session_timeline.get();
+
+    if (!opt.load_state_path.empty()) {
+        std::ifstream in(opt.load_state_path, std::ios::binary);
+        std::vector<uint8_t> state((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!in.is_open() || state.empty()) {
+            std::cerr << "[Headless] ERROR: no se pudo leer " << opt.load_state_path << "\n";
+            return 1;
+        }
+
+        auto load_start = std::chrono::steady_clock::now();
+        if (!gb.loadState(state.data(), state.size())) return 1;
+        report << "load_state=" << opt.load_state_path << " bytes=" << state.size()
+               << " frame=" << gb.total_frames << " restore_us="
+               << std::fixed << std::setprecision(1) << elapsed_us(load_start) << "\n";
+    }
+
+    // Historial para rebobinar; se captura después de cada frame
+    std::unique_ptr<rewind_buffer> rewind;
+    if (opt.rewind_steps > 0)
+        rewind = std::make_unique<rewind_buffer>(opt.rewind_mb << 20, opt.rewind_interval);
+
+    auto start = std::chrono::steady_clock::now();
+
+    while (gb.total_frames < opt.frames) {
+        if (opt.cycles && gb.total_cycles >= opt.cycles) break;
+
+        {
+            timeline::host_scope phase(tl, timeline::MainLoop, "run_frame");
+            gb.run_ahead_frame(opt.run_ahead);
+        }
+        if (rewind) rewind->onFrame(gb);
+
+        // Una línea por frame: dos ejecuciones se comparan con diff
+        if (opt.hash_frames || opt.state_hash_frames) {
+            timeline::host_scope phase(tl, timeline::MainLoop, "hash");
+            report << "frame " << gb.total_frames << std::hex << std::setfill('0');
+            if (opt.hash_frames)
+                report << " hash=0x" << std::setw(16) << frame_hash(gb.video.gfx);
+            if (opt.state_hash_frames)
+                report << " state=0x" << std::setw(16) << gb.stateHash();
+            report << std::dec << std::setfill(' ') << "\n";
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double fps = seconds > 0.0 ? gb.total_frames / seconds : 0.0;
+
+    static const char* engine_names[] = { "table", "switch", "cached", "jit" };
+
+    report << "rom="     << opt.rom_path
+           << " engine=" << engine_names[static_cast<int>(gb.processor.getEngine())]
+           << " frames=" << gb.total_frames
+           << " cycles=" << gb.total_cycles
+           << " host_s=" << std::fixed << std::setprecision(3) << seconds
+           << " emu_fps=" << std::setprecision(1) << fps
+           << " speed="  << std::setprecision(2) << (fps / 59.7275) << "x"
+           << " halted=" << std::setprecision(1)
+           << (gb.total_cycles ? 100.0 * gb.halted_cycles / gb.total_cycles : 0.0) << "%\n";
+
+    if (rewind) {
+        report << "rewind: snapshots=" << rewind->snapshots() << " frames=" << rewind->framesHeld()
+               << " bytes=" << rewind->bytesUsed() << " budget=" << rewind->budget() << "\n";
+
+        // Un paso por refresco de pantalla: lo que importa es el peor caso
+        uint64_t steps = 0;
+        double   total_us = 0.0, worst_us = 0.0;
+        while (steps < opt.rewind_steps) {
+            auto step_start = std::chrono::steady_clock::now();
+            if (!rewind->stepBack(gb)) break;
+            double us = elapsed_us(step_start);
+            total_us += us;
+            worst_us = std::max(worst_us, us);
+            steps++;
+        }
+        report << "rewind: steps=" << steps << " frame=" << gb.total_frames
+               << std::fixed << std::setprecision(1)
+               << " step_us_avg=" << (steps ? total_us / steps : 0.0)
+               << " step_us_max=" << worst_us << "\n";
+    }
+
+    if (opt.fork_children > 0) {
+        // Cada hijo corre en su hilo mientras el padre sigue en este; sin
+        // entrada, todos deben terminar en el mismo frame y ciclo que el
+        // padre. Con --engine jit el state puede diferir en contadores de
+        // instrucciones y en el scheduler (igual que tras un loadState: el
+        // hijo empieza con la caché de código fría).
+        std::vector<std::unique_ptr<gameboy>> children;
+        auto fork_start = std::chrono::steady_clock::now();
+        for (int i = 0; i < opt.fork_children; i++) {
+            std::unique_ptr<gameboy> child = gb.fork();
+            if (!child) return 1;
+            children.push_back(std::move(child));
+        }
+        double fork_us = elapsed_us(fork_start) / opt.fork_children;
+
+        std::vector<std::thread> threads;
+        for (std::unique_ptr<gameboy>& child : children) {
+            gameboy* machine = child.get();
+            threads.emplace_back([machine, &opt] {
+                for (uint64_t f = 0; f < opt.fork_frames; f++) machine->run_frame();
+            });
+        }
+        for (uint64_t f = 0; f < opt.fork_frames; f++) gb.run_frame();
+        for (std::thread& t : threads) t.join();
+
+        std::vector<uint8_t> parent_state, child_state;
+        gb.saveState(parent_state);
+        uint64_t parent_hash = frame_hash(gb.video.gfx);
+        int    same_frame = 0, identical = 0;
+        size_t private_pages = 0;
+        for (const std::unique_ptr<gameboy>& child : children) {
+            child->saveState(child_state);
+            identical  += child_state == parent_state;
+            same_frame += child->total_cycles == gb.total_cycles && frame_hash(child->video.gfx) == parent_hash;
+            private_pages += child->memory.ownedRamPages();
+        }
+        report << "fork: children=" << children.size() << " frames=" << opt.fork_frames
+               << " same_frame=" << same_frame << " identical=" << identical
+               << " fork_us=" << std::fixed << std::setprecision(1) << fork_us
+               << " private_kb_avg=" << (private_pages * paged_ram::PAGE_SIZE / 1024.0) / children.size()
+               << "\n";
+        if (same_frame != opt.fork_children) return 1;
+    }
+
+    if (opt.hash) {
+        report << "hash=0x" << std::hex << std::setw(16) << std::setfill('0')
+               << frame_hash(gb.video.gfx) << std::dec << "\n";
+    }
+
+    if (opt.state_hash) {
+        // Coste medio de muchas llamadas: una sola dura poco más que el reloj
+        constexpr int repeats = 1000;
+        uint64_t hash = gb.stateHash();
+        auto hash_start = std::chrono::steady_clock::now();
+        for (int i = 0; i < repeats; i++) hash = gb.stateHash();
+        double hash_us = elapsed_us(hash_start) / repeats;
+
+        report << "state_hash=0x" << std::hex << std::setw(16) << std::setfill('0') << hash
+               << std::dec << std::setfill(' ')
+               << " hash_us=" << std::fixed << std::setprecision(2) << hash_us << "\n";
+    }
+
+    if (opt.perf_stats) {
+        static const char* region_names[GB_MEM_REGION_COUNT] = {
+            "rom0", "romx", "vram", "sram", "wram", "oam", "io", "hram"
+        };
+        const gb_perf_stats& p = gb.perf;
+        report << "perf: frame=" << p.frame << " cycles=" << p.cycles
+               << " instructions=" << p.instructions << " halted=" << p.halted_cycles
+               << " bank_switches=" << p.bank_switches << " dma=" << p.dma_transfers
+               << " scanlines=" << p.scanlines << " apu_samples=" << p.apu_samples
+               << " audio_buffered=" << p.audio_buffered << " underruns=" << p.audio_underruns << "\n";
+        report << "perf: reads";
+        for (unsigned r = 0; r < GB_MEM_REGION_COUNT; r++) report << " " << region_names[r] << "=" << p.mem_reads[r];
+        report << "\nperf: writes";
+        for (unsigned r = 0; r < GB_MEM_REGION_COUNT; r++) report << " " << region_names[r] << "=" << p.mem_writes[r];
+        report << "\nperf: host_ns frame=" << p.host_ns_frame << " cpu=" << p.host_ns_cpu
+               << " ppu=" << p.host_ns_ppu << " timer=" << p.host_ns_timer
+               << " apu=" << p.host_ns_apu << "\n";
+    }
+
+    if (opt.profile_top > 0) {
+        report << "profile: top " << opt.profile_top << " de " << prof.totalCycles() << " cycles\n";
+        prof.writeTop(report, opt.profile_top);
+    }
+    if (!opt.folded_path.empty()) {
+        if (!prof.writeFolded(opt.folded_path)) return 1;
+        report << "profile_folded=" << opt.folded_path << "\n";
+    }
+    if (!opt.pprof_path.empty()) {
+        if (!prof.writePprof(opt.pprof_path)) return 1;
+        report << "profile_pprof=" << opt.pprof_path << "\n";
+    }
+
+    if (opt.opcode_top > 0) {
+        report << "opcodes: top " << opt.opcode_top << "\n";
+        opcodes.writeTop(report, opt.opcode_top);
+    }
+    if (!opt.opcode_path.empty()) {
+        if (!opcodes.write(opt.opcode_path)) return 1;
+        report << "opcode_profile=" << opt.opcode_path << "\n";
+    }
+
+    if (session_timeline) {
+        gb.setTimeline(nullptr);
+        if (!session_timeline->write(opt.timeline_path)) return 1;
+        report << "timeline=" << opt.timeline_path << " events=" << session_timeline->size()
+               << " dropped=" << session_timeline->dropped() << "\n";
+    }
+
+#ifdef GB_COVERAGE
+    if (!opt.coverage_path.empty()) {
+        const rom_coverage& cov = gb.memory.romCoverage();
+        uint64_t totals[rom_coverage::KindCount] = {};
+        for (uint16_t bank = 0; bank < cov.bankCount(); bank++) {
+            for (int kind = 0; kind < rom_coverage::KindCount; kind++)
+                totals[kind] += cov.covered(static_cast<rom_coverage::Kind>(kind), bank);
+        }
+        double rom_bytes = static_cast<double>(cov.bankCount()) * rom_coverage::BANK_SIZE;
+
+        if (!cov.write(opt.coverage_path)) return 1;
+        report << "coverage=" << opt.coverage_path << " banks=" << cov.bankCount()
+               << std::fixed << std::setprecision(2)
+               << " opcode=" << 100.0 * totals[rom_coverage::Opcode] / rom_bytes << "%"
+               << " operand=" << 100.0 * totals[rom_coverage::Operand] / rom_bytes << "%"
+               << " data=" << 100.0 * totals[rom_coverage::Data] / rom_bytes << "%\n";
+    }
+#endif
+
+#ifdef GB_MEM_HEATMAP
+    if (!opt.heatmap_path.empty()) {
+        const mem_heatmap& heat = gb.memory.memHeatmap();
+        const gb_mem_heatmap& map = opt.heatmap_frame ? heat.lastFrame() : heat.total();
+        if (!mem_heatmap::write(map, opt.heatmap_path)) return 1;
+        report << "heatmap=" << opt.heatmap_path << " frames=" << map.frames << "\n";
+    }
+#endif
+
+    if (!opt.save_state_path.empty()) {
+        // Segunda captura sobre el mismo vector: ya sin reservar memoria
+        std::vector<uint8_t> state;
+        gb.saveState(state);
+        auto save_start = std::chrono::steady_clock::now();
+        gb.saveState(state);
+        double capture_us = elapsed_us(save_start);
+
+        std::ofstream out(opt.save_state_path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(state.data()), state.size());
+        if (!out) {
+            std::cerr << "[Headless] ERROR: no se pudo escribir " << opt.save_state_path << "\n";
+            return 1;
+        }
+        report << "save_state=" << opt.save_state_path << " bytes=" << state.size()
+               << " capture_us=" << std::fixed << std::setprecision(1) << capture_us << "\n";
+    }
+
+    if (!opt.dump_path.empty()) {
+        if (!dump_ppm(opt.dump_path, gb.video.gfx)) {
+            std::cerr << "[Headless] ERROR: no se pudo escribir " << opt.dump_path << "\n";
+            return 1;
+        }
+        report << "dump=" << opt.dump_path << "\n";
+    }
+
+    return 0;
+}
@@ -0,0 +1,564 @@
+// ============================================================
+// CPU_CONFORMANCE.CPP - TESTS DE CONFORMIDAD DE LA CPU (SM83)
+// ============================================================
+// Red de seguridad para el trabajo de rendimiento en la CPU (dispatch
+// por tabla, switch, PREFIX_CB, flags). Tres modos:
+//
+//   --vectors DIR  Carga los vectores JSON de un solo paso de la
+//                  comunidad (SingleStepTests/sm83, un archivo por
+//                  opcode: "00.json" ... "cb ff.json") y compara
+//                  registros, RAM y ciclos con el estado final.
+//                  Sin el directorio el test se salta (código 77).
+//
+//   --random N     N estados aleatorios por opcode (base y CB) sin
+//                  oráculo: solo exige que todos los motores den el
+//                  mismo resultado, incluida la RAM completa.
+//
+// En los dos primeros modos cada caso se ejecuta con todos los motores de la
+// build (Table, Switch, BlockCache y, con GB_ENABLE_JIT, Jit) sobre un
+// MMU en modo RAM plana, y cualquier diferencia entre ellos es un
+// fallo. Con un solo paso el JIT nunca llega a compilar (setRegisters
+// vacía los bloques), así que ahí solo se prueba su vuelta al
+// intérprete. Los bloques nativos los cubre el tercer modo:
+//
+//   --rom FILE     Corre la ROM con cada motor en paralelo, frame a
+//                  frame, y compara gameboy::stateHash tras cada uno.
+//                  Detecta lo que un solo paso no ve: interrupciones y
+//                  eventos de PPU/timer atendidos en otra instrucción.
+//
+//   gb-cpu-conformance [--vectors DIR] [--random N] [--seed S]
+//                      [--rom FILE] [--frames N] [--max-failures N]
+// ============================================================
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "core/cpu/cpu.h"
+#include "core/gameboy.h"
+
+namespace {
+
+// ============================================================
+// JSON MÍNIMO (solo lo que usan los vectores)
+// ============================================================
+struct json
+{
+    enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+    double      number = 0.0;
+    std::string text;
+    std::vector<json>                        items;
+    std::vector<std::pair<std::string, json>> fields;
+
+    const json* get(const char* key) const
+    {
+        for (const auto& field : fields)
+            if (field.first == key) return &field.second;
+        return nullptr;
+    }
+};
+
+class json_parser
+{
+public:
+    explicit json_parser(const std::string& source) : src(source) {}
+
+    bool parse(json& out)
+    {
+        if (!value(out)) return false;
+        skipSpace();
+        return pos == src.size();
+    }
+
+private:
+    const std::string& src;
+    size_t pos = 0;
+
+    void skipSpace()
+    {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) pos++;
+    }
+
+    bool literal(const char* word)
+    {
+        size_t len = std::strlen(word);
+        if (src.compare(pos, len, word) != 0) return false;
+        pos += len;
+        return true;
+    }
+
+    bool string(std::string& out)
+    {
+        if (src[pos] != '"') return false;
+        pos++;
+        while (pos < src.size() && src[pos] != '"') {
+            if (src[pos] == '\\' && pos + 1 < src.size()) pos++;   // Los vectores no usan \u
+            out += src[pos++];
+        }
+        if (pos >= src.size()) return false;
+        pos++;
+        return true;
+    }
+
+    bool value(json& out)
+    {
+        skipSpace();
+        if (pos >= src.size()) return false;
+
+        char c = src[pos];
+        if (c == '{') {
+            out.type = json::Object;
+            pos++;
+            skipSpace();
+            if (src[pos] == '}') { pos++; return true; }
+            while (true) {
+                skipSpace();
+                std::string key;
+                if (!string(key)) return false;
+                skipSpace();
+                if (src[pos++] != ':') return false;
+                out.fields.emplace_back(std::move(key), json{});
+                if (!value(out.fields.back().second)) return false;
+                skipSpace();
+                if (src[pos] == ',') { pos++; continue; }
+                if (src[pos] == '}') { pos++; return true; }
+                return false;
+            }
+        }
+        if (c == '[') {
+            out.type = json::Array;
+            pos++;
+            skipSpace();
+            if (src[pos] == ']') { pos++; return true; }
+            while (true) {
+                out.items.emplace_back();
+                if (!value(out.items.back())) return false;
+                skipSpace();
+                if (src[pos] == ',') { pos++; continue; }
+                if (src[pos] == ']') { pos++; return true; }
+                return false;
+            }
+        }
+        if (c == '"') { out.type = json::String; return string(out.text); }
+        if (literal("null"))  { out.type = json::Null; return true; }
+        if (literal("true"))  { out.type = json::Bool; out.number = 1; return true; }
+        if (literal("false")) { out.type = json::Bool; out.number = 0; return true; }
+
+        char* end = nullptr;
+        out.type   = json::Number;
+        out.number = std::strtod(src.c_str() + pos, &end);
+        if (end == src.c_str() + pos) return false;
+        pos = static_cast<size_t>(end - src.c_str());
+        return true;
+    }
+};
+
+// ============================================================
+// CASOS
+// ============================================================
+struct MachineState
+{
+    cpu::Registers regs{};
+    std::vector<std::pair<uint16_t, uint8_t>> ram;   // Direcciones relevantes
+};
+
+struct TestCase
+{
+    std::string  name;
+    MachineState initial;
+    MachineState expected;
+    int          cycles = -1;   // T-cycles esperados (-1 = sin oráculo)
+};
+
+bool readState(const json& node, MachineState& state)
+{
+    static const char* const names[] = { "pc", "sp", "a", "f", "b", "c", "d", "e", "h", "l" };
+    int values[10];
+    for (int i = 0; i < 10; i++) {
+        const json* field = node.get(names[i]);
+        if (!field || field->type != json::Number) return false;
+        values[i] = static_cast<int>(field->number);
+    }
+
+    cpu::Registers& r = state.regs;
+    r.pc = static_cast<uint16_t>(values[0]);
+    r.sp = static_cast<uint16_t>(values[1]);
+    r.a = values[2]; r.f = values[3]; r.b = values[4]; r.c = values[5];
+    r.d = values[6]; r.e = values[7]; r.h = values[8]; r.l = values[9];
+
+    // "ei" = EI pendiente: en este core EI arma IME_scheduled y step()
+    // lo aplica al terminar la instrucción
+    const json* ime = node.get("ime");
+    const json* ei  = node.get("ei");
+    r.ime           = ime && ime->number != 0;
+    r.ime_scheduled = ei && ei->number != 0;
+    r.halted = r.stopped = false;
+
+    if (const json* ram = node.get("ram")) {
+        for (const json& entry : ram->items) {
+            if (entry.items.size() < 2) return false;
+            state.ram.emplace_back(static_cast<uint16_t>(entry.items[0].number),
+                                   static_cast<uint8_t>(entry.items[1].number));
+        }
+    }
+    return true;
+}
+
+bool loadVectors(const std::string& path, std::vector<TestCase>& cases)
+{
+    std::ifstream in(path);
+    if (!in.is_open()) return false;
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    std::string source = buffer.str();
+
+    json root;
+    if (!json_parser(source).parse(root) || root.type != json::Array) return false;
+
+    for (const json& test : root.items) {
+        const json* name    = test.get("name");
+        const json* initial = test.get("initial");
+        const json* final   = test.get("final");
+        const json* cycles  = test.get("cycles");
+        if (!initial || !final) return false;
+
+        TestCase tc;
+        tc.name = name ? name->text : path;
+        if (!readState(*initial, tc.initial) || !readState(*final, tc.expected)) return false;
+        tc.cycles = cycles ? static_cast<int>(cycles->items.size()) * 4 : -1;
+        cases.push_back(std::move(tc));
+    }
+    return true;
+}
+
+// ============================================================
+// EJECUCIÓN
+// ============================================================
+struct Engine
+{
+    cpu::Engine id;
+    const char* name;
+};
+
+const Engine ENGINES[] = {
+    { cpu::Engine::Table,      "table"  },
+    { cpu::Engine::Switch,     "switch" },
+    { cpu::Engine::BlockCache, "cached" },
+#ifdef GB_ENABLE_JIT
+    { cpu::Engine::Jit,        "jit"    },
+#endif
+};
+constexpr int ENGINE_COUNT = sizeof(ENGINES) / sizeof(ENGINES[0]);
+
+// Un MMU de RAM plana y una CPU por motor
+struct Machine
+{
+    mmu memory{ mmu::FlatRam{} };
+    cpu processor{ memory };
+
+    explicit Machine(cpu::Engine engine) { processor.setEngine(engine); }
+};
+
+struct Result
+{
+    cpu::Registers regs;
+    int            cycles;
+};
+
+Result runStep(Machine& machine, const MachineState& initial)
+{
+    uint8_t* ram = machine.memory.flatRam();
+    for (const auto& entry : initial.ram) ram[entry.first] = entry.second;
+
+    machine.processor.setRegisters(initial.regs);
+    int cycles = machine.processor.step();
+    return Result{ machine.processor.getRegisters(), cycles };
+}
+
+// IME visto desde fuera: EI pendiente cuenta como habilitado
+bool imeEnabled(const cpu::Registers& r) { return r.ime || r.ime_scheduled; }
+
+std::string diffRegisters(const cpu::Registers& got, const cpu::Registers& want)
+{
+    std::ostringstream out;
+    auto check = [&](const char* name, unsigned g, unsigned w) {
+        if (g != w) out << " " << name << "=" << std::hex << g << "(esperado " << w << ")" << std::dec;
+    };
+    check("pc", got.pc, want.pc);
+    check("sp", got.sp, want.sp);
+    check("a", got.a, want.a); check("f", got.f, want.f);
+    check("b", got.b, want.b); check("c", got.c, want.c);
+    check("d", got.d, want.d); check("e", got.e, want.e);
+    check("h", got.h, want.h); check("l", got.l, want.l);
+    check("ime", imeEnabled(got), imeEnabled(want));
+    return out.str();
+}
+
+struct Report
+{
+    uint64_t cases    = 0;
+    uint64_t failures = 0;
+    int      max_failures;
+
+    void fail(const std::string& message)
+    {
+        if (static_cast<int>(failures) < max_failures) std::cout << "FALLO " << message << "\n";
+        failures++;
+    }
+};
+
+// Modo --vectors: oráculo + acuerdo entre motores
+void runVectors(const std::vector<TestCase>& cases, Machine* machines[], Report& report)
+{
+    for (const TestCase& tc : cases) {
+        Result results[ENGINE_COUNT];
+        std::vector<uint8_t> final_ram[ENGINE_COUNT];
+
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            results[e] = runStep(*machines[e], tc.initial);
+
+            uint8_t* ram = machines[e]->memory.flatRam();
+            for (const auto& entry : tc.expected.ram) final_ram[e].push_back(ram[entry.first]);
+
+            // Dejar la RAM a cero para el siguiente caso
+            for (const auto& entry : tc.initial.ram)  ram[entry.first] = 0;
+            for (const auto& entry : tc.expected.ram) ram[entry.first] = 0;
+        }
+        report.cases++;
+
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            std::string where = tc.name + " [" + ENGINES[e].name + "]";
+
+            std::string regs = diffRegisters(results[e].regs, tc.expected.regs);
+            if (!regs.empty()) report.fail(where + regs);
+
+            if (tc.cycles >= 0 && results[e].cycles != tc.cycles) {
+                report.fail(where + " ciclos=" + std::to_string(results[e].cycles) +
+                            " (esperado " + std::to_string(tc.cycles) + ")");
+            }
+
+            for (size_t i = 0; i < tc.expected.ram.size(); i++) {
+                if (final_ram[e][i] != tc.expected.ram[i].second) {
+                    std::ostringstream msg;
+                    msg << where << " ram[" << std::hex << tc.expected.ram[i].first << "]="
+                        << int(final_ram[e][i]) << " (esperado " << int(tc.expected.ram[i].second) << ")";
+                    report.fail(msg.str());
+                }
+            }
+        }
+    }
+}
+
+// Opcodes sin handler en el SM83 (ILLEGAL imprime y no hace nada útil)
+bool isIllegal(int opcode)
+{
+    static const int illegal[] = { 0xD3, 0xDB, 0xDD, 0xE3, 0xE4, 0xEB, 0xEC, 0xED, 0xF4, 0xFC, 0xFD };
+    return std::find(std::begin(illegal), std::end(illegal), opcode) != std::end(illegal);
+}
+
+// xorshift64: mismos estados en todas las máquinas y en cada ejecución
+struct Rng
+{
+    uint64_t state;
+    uint64_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    uint8_t byte() { return static_cast<uint8_t>(next() >> 24); }
+};
+
+// Modo --random: solo acuerdo entre motores, con la RAM completa
+void runRandom(int per_opcode, uint64_t seed, Machine* machines[], Report& report)
+{
+    Rng rng{ seed ? seed : 1 };
+
+    // Misma RAM aleatoria de partida en todas las máquinas
+    for (size_t i = 0; i < 0x10000; i++) {
+        uint8_t value = rng.byte();
+        for (int e = 0; e < ENGINE_COUNT; e++) machines[e]->memory.flatRam()[i] = value;
+    }
+
+    for (int slot = 0; slot < 0x200; slot++) {
+        int opcode = slot & 0xFF;
+        if (slot < 0x100 && (isIllegal(opcode) || opcode == 0xCB)) continue;
+
+        for (int n = 0; n < per_opcode; n++) {
+            MachineState initial;
+            cpu::Registers& r = initial.regs;
+            r.pc = static_cast<uint16_t>(rng.next());
+            r.sp = static_cast<uint16_t>(rng.next());
+            r.a = rng.byte(); r.f = rng.byte() & 0xF0;
+            r.b = rng.byte(); r.c = rng.byte(); r.d = rng.byte();
+            r.e = rng.byte(); r.h = rng.byte(); r.l = rng.byte();
+            r.ime = rng.byte() & 1;
+            r.ime_scheduled = false;
+            r.halted = r.stopped = false;
+
+            // Instrucción en PC; los inmediatos son lo que ya haya en la RAM
+            if (slot < 0x100) {
+                initial.ram.emplace_back(r.pc, static_cast<uint8_t>(opcode));
+            } else {
+                initial.ram.emplace_back(r.pc, 0xCB);
+                initial.ram.emplace_back(static_cast<uint16_t>(r.pc + 1), static_cast<uint8_t>(opcode));
+            }
+
+            Result results[ENGINE_COUNT];
+            for (int e = 0; e < ENGINE_COUNT; e++) results[e] = runStep(*machines[e], initial);
+            report.cases++;
+
+            char name[32];
+            std::snprintf(name, sizeof(name), slot < 0x100 ? "%02X #%d" : "CB %02X #%d", opcode, n);
+
+            for (int e = 1; e < ENGINE_COUNT; e++) {
+                std::string where = std::string(name) + " [" + ENGINES[e].name + " vs " + ENGINES[0].name + "]";
+
+                std::string regs = diffRegisters(results[e].regs, results[0].regs);
+                if (!regs.empty()) report.fail(where + regs);
+                if (results[e].cycles != results[0].cycles) {
+                    report.fail(where + " ciclos=" + std::to_string(results[e].cycles) +
+                                " (esperado " + std::to_string(results[0].cycles) + ")");
+                }
+                if (std::memcmp(machines[e]->memory.flatRam(), machines[0]->memory.flatRam(), 0x10000) != 0)
+                    report.fail(where + " la RAM difiere");
+            }
+        }
+    }
+}
+
+// Modo --rom: la ROM completa con cada motor, comparando el estado
+// entero tras cada frame. Al primer frame distinto se para: a partir
+// de ahí todos los siguientes difieren.
+bool runRom(const std::string& path, int frames, Report& report)
+{
+    std::vector<std::unique_ptr<gameboy>> machines;
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        machines.push_back(std::make_unique<gameboy>(path));
+        if (!machines.back()->is_loaded()) {
+            std::cerr << "[Conformance] ERROR: no se pudo cargar " << path << "\n";
+            return false;
+        }
+        machines.back()->processor.setEngine(ENGINES[e].id);
+    }
+
+    for (int frame = 1; frame <= frames; frame++) {
+        uint64_t hashes[ENGINE_COUNT];
+        for (int e = 0; e < ENGINE_COUNT; e++) {
+            machines[e]->run_frame();
+            hashes[e] = machines[e]->stateHash();
+        }
+        report.cases++;
+
+        bool same = true;
+        for (int e = 1; e < ENGINE_COUNT; e++) {
+            if (hashes[e] == hashes[0]) continue;
+            std::ostringstream msg;
+            msg << "frame " << frame << " [" << ENGINES[e].name << " vs " << ENGINES[0].name
+                << "] state=0x" << std::hex << hashes[e] << " (esperado 0x" << hashes[0] << ")"
+                << std::dec << " ciclos=" << machines[e]->total_cycles
+                << " (esperado " << machines[0]->total_cycles << ")";
+            report.fail(msg.str());
+            same = false;
+        }
+        if (!same) break;
+    }
+    return true;
+}
+
+std::vector<std::string> listJson(const std::string& dir)
+{
+    std::vector<std::string> files;
+    DIR* handle = opendir(dir.c_str());
+    if (!handle) return files;
+    while (dirent* entry = readdir(handle)) {
+        std::string name = entry->d_name;
+        if (name.size() > 5 && name.compare(name.size() - 5, 5, ".json") == 0)
+            files.push_back(dir + "/" + name);
+    }
+    closedir(handle);
+    std::sort(files.begin(), files.end());
+    return files;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string vectors_dir;
+    int         random_cases = 0;
+    uint64_t    seed         = 0x9E3779B97F4A7C15ULL;
+    int         max_failures = 20;
+    std::string rom_path;
+    int         rom_frames   = 600;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (!std::strcmp(argv[i], "--vectors") && has_value) {
+            vectors_dir = argv[++i];
+        } else if (!std::strcmp(argv[i], "--random") && has_value) {
+            random_cases = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--seed") && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (!std::strcmp(argv[i], "--rom") && has_value) {
+            rom_path = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frames") && has_value) {
+            rom_frames = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--max-failures") && has_value) {
+            max_failures = std::atoi(argv[++i]);
+        } else {
+            std::cerr << "Uso: " << argv[0] << " [--vectors DIR] [--random N] [--seed S]"
+                      << " [--rom FILE] [--frames N] [--max-failures N]\n";
+            return 2;
+        }
+    }
+
+    std::vector<std::unique_ptr<Machine>> owned;
+    Machine* machines[ENGINE_COUNT];
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        owned.push_back(std::make_unique<Machine>(ENGINES[e].id));
+        machines[e] = owned.back().get();
+    }
+
+    Report report;
+    report.max_failures = max_failures;
+
+    if (!vectors_dir.empty()) {
+        std::vector<std::string> files = listJson(vectors_dir);
+        if (files.empty()) {
+            std::cout << "[Conformance] Sin vectores en " << vectors_dir << ": test omitido\n";
+            return 77;
+        }
+
+        for (const std::string& file : files) {
+            std::vector<TestCase> cases;
+            if (!loadVectors(file, cases)) {
+                std::cerr << "[Conformance] ERROR: no se pudo leer " << file << "\n";
+                return 1;
+            }
+            runVectors(cases, machines, report);
+        }
+        std::cout << "[Conformance] vectores: " << files.size() << " archivos\n";
+    }
+
+    if (random_cases > 0) runRandom(random_cases, seed, machines, report);
+
+    if (!rom_path.empty() && !runRom(rom_path, rom_frames, report)) return 1;
+
+    std::cout << "[Conformance] casos=" << report.cases << " motores=" << ENGINE_COUNT
+              << " fallos=" << report.failures << "\n";
+    return report.failures ? 1 : 0;
+}
@@ -0,0 +1,428 @@
+// ============================================================
+// STATE_TESTS.CPP - TESTS DEL ESTADO DE LA MÁQUINA
+// ============================================================
+// Comprueba las piezas que guardan, restauran o comparan el estado
+// completo de un gameboy, usando gameboy::stateHash como oráculo:
+//
+//   savestate  saveState/loadState: el hash vuelve a ser el mismo al
+//              cargar (en la misma máquina y en una nueva) y la
+//              ejecución sigue igual que sin restaurar. Un state
+//              truncado o de otra versión se rechaza.
+//
+//   rewind     encode/apply de los deltas sobre buffers sintéticos
+//              (ida y vuelta exacta, delta vacío, delta corrupto) y
+//              stepBack sobre la ROM hasta hashes de frames conocidos.
+//
+//   fork       gameboy::fork: el hijo nace con el hash del padre, y a
+//              partir de ahí cada uno sigue por su cuenta. Lo que
+//              escribe el hijo no llega al padre (copy-on-write) y el
+//              padre sigue igual que una máquina que nunca hizo fork.
+//
+//   determinism  dos máquinas construidas sobre memoria rellena con
+//              bytes distintos (0x00 y 0xA5) acaban con el mismo hash
+//              y los mismos bytes de save state: ningún campo sin
+//              inicializar ni relleno entre campos llega al estado.
+//
+//   xxh64      state_hasher contra vectores de referencia de XXH64
+//              (semilla 0) y el mismo digest troceando la entrada de
+//              cualquier forma. No necesita ROM.
+//
+//   gb-state-tests TEST [--rom FILE] [--frames N]
+// ============================================================
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "core/gameboy.h"
+#include "core/state/rewind_buffer.h"
+#include "core/state/state_hash.h"
+
+// operator new global que rellena cada bloque con heap_fill (si es >= 0),
+// para que la basura de la memoria nueva sea distinta en cada máquina.
+// gameboy está sobrealineado, así que también hacen falta las versiones
+// con std::align_val_t.
+static int heap_fill = -1;
+
+static void* filledBlock(std::size_t size, std::size_t alignment)
+{
+    size = size ? size : 1;
+    void* block = alignment > alignof(std::max_align_t)
+                ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                : std::malloc(size);
+    if (!block) throw std::bad_alloc();
+    if (heap_fill >= 0) std::memset(block, heap_fill, size);
+    return block;
+}
+
+void* operator new(std::size_t size) { return filledBlock(size, 0); }
+void* operator new(std::size_t size, std::align_val_t al) { return filledBlock(size, static_cast<std::size_t>(al)); }
+void operator delete(void* block) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t) noexcept { std::free(block); }
+void operator delete(void* block, std::align_val_t) noexcept { std::free(block); }
+void operator delete(void* block, std::size_t, std::align_val_t) noexcept { std::free(block); }
+
+namespace {
+
+struct Report
+{
+    int failures = 0;
+
+    void check(bool ok, const std::string& what)
+    {
+        if (ok) return;
+        std::cout << "FALLO " << what << "\n";
+        failures++;
+    }
+};
+
+std::string hex(uint64_t value)
+{
+    std::ostringstream out;
+    out << "0x" << std::hex << value;
+    return out.str();
+}
+
+void runFrames(gameboy& gb, int frames)
+{
+    for (int i = 0; i < frames; i++) gb.run_frame();
+}
+
+std::unique_ptr<gameboy> loadRom(const std::string& path)
+{
+    auto gb = std::make_unique<gameboy>(path);
+    if (!gb->is_loaded()) {
+        std::cerr << "[State] ERROR: no se pudo cargar " << path << "\n";
+        return nullptr;
+    }
+    return gb;
+}
+
+// ============================================================
+// SAVE STATE
+// ============================================================
+bool testSaveState(const std::string& rom, int frames, Report& report)
+{
+    std::unique_ptr<gameboy> gb = loadRom(rom);
+    if (!gb) return false;
+
+    runFrames(*gb, frames);
+    std::vector<uint8_t> state;
+    gb->saveState(state);
+    const uint64_t saved = gb->stateHash();
+
+    runFrames(*gb, frames);
+    const uint64_t later = gb->stateHash();
+    report.check(later != saved, "el estado no cambia al avanzar " + std::to_string(frames) + " frames");
+
+    // Misma máquina: vuelve al punto guardado y sigue igual
+    report.check(gb->loadState(state.data(), state.size()), "loadState en la misma máquina");
+    report.check(gb->stateHash() == saved,
+                 "hash tras cargar " + hex(gb->stateHash()) + " (esperado " + hex(saved) + ")");
+    runFrames(*gb, frames);
+    report.check(gb->stateHash() == later,
+                 "hash tras cargar y avanzar " + hex(gb->stateHash()) + " (esperado " + hex(later) + ")");
+
+    // Máquina nueva con la misma ROM
+    std::unique_ptr<gameboy> fresh = loadRom(rom);
+    if (!fresh) return false;
+    report.check(fresh->loadState(state.data(), state.size()), "loadState en una máquina nueva");
+    report.check(fresh->stateHash() == saved,
+                 "hash en la máquina nueva " + hex(fresh->stateHash()) + " (esperado " + hex(saved) + ")");
+
+    // States inválidos: se rechazan sin tocar la máquina
+    const uint64_t before = fresh->stateHash();
+    std::vector<uint8_t> truncated(state.begin(), state.begin() + state.size() / 2);
+    report.check(!fresh->loadState(truncated.data(), truncated.size()), "se acepta un state truncado");
+
+    std::vector<uint8_t> other_version = state;
+    state_header header;
+    std::memcpy(&header, other_version.data(), sizeof(header));
+    header.version++;
+    std::memcpy(other_version.data(), &header, sizeof(header));
+    report.check(!fresh->loadState(other_version.data(), other_version.size()),
+                 "se acepta un state de otra versión");
+    report.check(fresh->stateHash() == before, "un state rechazado cambia la máquina");
+
+    std::cout << "[State] savestate: " << state.size() << " bytes, hash " << hex(saved) << "\n";
+    return true;
+}
+
+// ============================================================
+// REWIND
+// ============================================================
+// xorshift64: mismos buffers en cada ejecución
+struct Rng
+{
+    uint64_t state;
+    uint64_t next()
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+void checkDelta(const std::vector<uint8_t>& older, const std::vector<uint8_t>& newer,
+                const std::string& name, Report& report)
+{
+    std::vector<uint8_t> encoded;
+    rewind_buffer::encode(older.data(), newer.data(), newer.size(), encoded);
+
+    std::vector<uint8_t> state = newer;
+    bool ok = rewind_buffer::apply(encoded.data(), encoded.size(), state.data(), state.size());
+    report.check(ok && state == older, "delta " + name + ": apply(encode) no reconstruye el buffer");
+}
+
+bool testRewind(const std::string& rom, int frames, Report& report)
+{
+    // --- Deltas sobre buffers sintéticos ---
+    Rng rng{ 0x9E3779B97F4A7C15ULL };
+    std::vector<uint8_t> older(4096);
+    for (uint8_t& b : older) b = static_cast<uint8_t>(rng.next());
+
+    std::vector<uint8_t> same = older;
+    std::vector<uint8_t> encoded;
+    rewind_buffer::encode(older.data(), same.data(), same.size(), encoded);
+    report.check(encoded.empty(), "delta de dos buffers iguales no vacío");
+    checkDelta(older, same, "igual", report);
+
+    std::vector<uint8_t> sparse = older;
+    sparse[0] ^= 0x01;                                         // Primer byte
+    sparse[100] ^= 0xFF; sparse[103] ^= 0x10;                  // Tramo con un hueco corto
+    for (size_t i = 2000; i < 2300; i++) sparse[i] ^= 0x5A;    // Tramo largo
+    sparse[sparse.size() - 1] ^= 0x80;                         // Último byte
+    checkDelta(older, sparse, "disperso", report);
+
+    std::vector<uint8_t> different(older.size());
+    for (uint8_t& b : different) b = static_cast<uint8_t>(rng.next());
+    checkDelta(older, different, "distinto", report);
+
+    rewind_buffer::encode(older.data(), sparse.data(), sparse.size(), encoded);
+    std::vector<uint8_t> state = sparse;
+    report.check(!rewind_buffer::apply(encoded.data(), encoded.size() - 1, state.data(), state.size()),
+                 "se acepta un delta truncado");
+
+    // --- stepBack sobre la ROM: una captura cada 2 frames ---
+    std::unique_ptr<gameboy> gb = loadRom(rom);
+    if (!gb) return false;
+
+    const int total = frames | 1;   // Impar: el último frame queda sin capturar
+    std::vector<uint64_t> hashes(total + 1);
+    rewind_buffer rewind(1 << 20, 2);
+    hashes[0] = gb->stateHash();
+    for (int f = 1; f <= total; f++) {
+        gb->run_frame();
+        rewind.onFrame(*gb);
+        hashes[f] = gb->stateHash();
+    }
+
+    // Primero vuelve a la última captura (frame total-1) y después
+    // retrocede de 2 en 2
+    int frame = total - 1;
+    for (int step = 0; step < 5; step++, frame -= 2) {
+        if (!rewind.stepBack(*gb)) {
+            report.check(false, "stepBack sin historial en el frame " + std::to_string(frame));
+            break;
+        }
+        report.check(gb->stateHash() == hashes[frame],
+                     "stepBack al frame " + std::to_string(frame) + ": hash " + hex(gb->stateHash()) +
+                     " (esperado " + hex(hashes[frame]) + ")");
+    }
+
+    // Desde el punto rebobinado la ejecución sigue igual
+    frame += 2;
+    gb->run_frame();
+    gb->run_frame();
+    report.check(gb->stateHash() == hashes[frame + 2],
+                 "avanzar tras rebobinar: hash " + hex(gb->stateHash()) +
+                 " (esperado " + hex(hashes[frame + 2]) + ")");
+
+    std::cout << "[State] rewind: " << rewind.snapshots() << " capturas, "
+              << rewind.bytesUsed() << " bytes de deltas\n";
+    return true;
+}
+
+// ============================================================
+// FORK
+// ============================================================
+bool testFork(const std::string& rom, int frames, Report& report)
+{
+    std::unique_ptr<gameboy> parent    = loadRom(rom);
+    std::unique_ptr<gameboy> reference = loadRom(rom);   // Nunca hace fork
+    if (!parent || !reference) return false;
+
+    runFrames(*parent, frames);
+    runFrames(*reference, frames);
+    const uint64_t at_fork = parent->stateHash();
+
+    std::unique_ptr<gameboy> child = parent->fork();
+    if (!child) {
+        report.check(false, "fork devolvió nullptr");
+        return true;
+    }
+    report.check(child->stateHash() == at_fork,
+                 "hash del hijo al nacer " + hex(child->stateHash()) + " (esperado " + hex(at_fork) + ")");
+
+    // Escritura directa del hijo en WRAM: copia la página solo para él
+    const uint16_t address = 0xC000;
+    const uint8_t  original = parent->memory.readMemory(address);
+    child->memory.writeMemory(address, static_cast<uint8_t>(original ^ 0xFF));
+    report.check(parent->memory.readMemory(address) == original, "una escritura del hijo llega al padre");
+    report.check(child->stateHash() != at_fork, "el hash del hijo no cambia tras escribir en WRAM");
+    report.check(parent->stateHash() == at_fork, "el hash del padre cambia por una escritura del hijo");
+
+    // El hijo corre con botones pulsados; el padre no debe enterarse
+    child->memory.setButton(4, true);    // A
+    child->memory.setButton(7, true);    // Start
+    runFrames(*child, frames);
+    report.check(parent->stateHash() == at_fork, "el hash del padre cambia mientras corre el hijo");
+
+    runFrames(*parent, frames);
+    runFrames(*reference, frames);
+    report.check(parent->stateHash() == reference->stateHash(),
+                 "padre tras el fork " + hex(parent->stateHash()) + " (sin fork " +
+                 hex(reference->stateHash()) + ")");
+    report.check(child->stateHash() != parent->stateHash(), "padre e hijo no divergen");
+
+    // Un segundo hijo del mismo punto, sin tocar nada, repite al padre
+    std::unique_ptr<gameboy> twin = parent->fork();
+    if (twin) {
+        runFrames(*twin, frames);
+        runFrames(*parent, frames);
+        report.check(twin->stateHash() == parent->stateHash(),
+                     "hijo sin cambios " + hex(twin->stateHash()) + " (padre " + hex(parent->stateHash()) + ")");
+    }
+
+    std::cout << "[State] fork: páginas propias del hijo " << child->memory.ownedRamPages() << "\n";
+    return true;
+}
+
+// ============================================================
+// DETERMINISM
+// ============================================================
+std::unique_ptr<gameboy> loadRomOnHeap(const std::string& path, uint8_t fill)
+{
+    heap_fill = fill;
+    std::unique_ptr<gameboy> gb = loadRom(path);
+    heap_fill = -1;
+    return gb;
+}
+
+bool testDeterminism(const std::string& rom, int frames, Report& report)
+{
+    std::unique_ptr<gameboy> zeros   = loadRomOnHeap(rom, 0x00);
+    std::unique_ptr<gameboy> garbage = loadRomOnHeap(rom, 0xA5);
+    if (!zeros || !garbage) return false;
+
+    report.check(zeros->stateHash() == garbage->stateHash(),
+                 "hash al arrancar " + hex(zeros->stateHash()) + " / " + hex(garbage->stateHash()));
+
+    runFrames(*zeros, frames);
+    runFrames(*garbage, frames);
+    report.check(zeros->stateHash() == garbage->stateHash(),
+                 "hash tras " + std::to_string(frames) + " frames " + hex(zeros->stateHash()) +
+                 " / " + hex(garbage->stateHash()));
+
+    std::vector<uint8_t> a, b;
+    zeros->saveState(a, STATE_FRAMEBUFFER);
+    garbage->saveState(b, STATE_FRAMEBUFFER);
+    size_t differing = 0;
+    for (size_t i = 0; i < std::min(a.size(), b.size()); i++) differing += (a[i] != b[i]);
+    report.check(a.size() == b.size() && differing == 0,
+                 "save states distintos: " + std::to_string(differing) + " bytes de " +
+                 std::to_string(a.size()) + " / " + std::to_string(b.size()));
+
+    std::cout << "[State] determinism: " << a.size() << " bytes de state iguales\n";
+    return true;
+}
+
+// ============================================================
+// XXH64
+// ============================================================
+uint64_t xxh64(const void* data, size_t size)
+{
+    state_hasher hasher;
+    hasher.update(data, size);
+    return hasher.digest();
+}
+
+bool testXxh64(Report& report)
+{
+    struct Vector { const char* text; uint64_t hash; };
+    static const Vector vectors[] = {
+        { "",                                        0xEF46DB3751D8E999ULL },
+        { "a",                                       0xD24EC4F1A98C6E5BULL },
+        { "Nobody inspects the spammish repetition", 0xFBCEA83C8A378BF1ULL },
+    };
+    for (const Vector& v : vectors) {
+        uint64_t got = xxh64(v.text, std::strlen(v.text));
+        report.check(got == v.hash, "XXH64(\"" + std::string(v.text) + "\") = " + hex(got) +
+                                    " (esperado " + hex(v.hash) + ")");
+    }
+
+    // Streaming: cualquier troceo da el mismo digest que un solo update
+    // (trozos de 1 a 70 bytes: cruzan el bloque de 32 de todas las formas)
+    Rng rng{ 0x243F6A8885A308D3ULL };
+    std::vector<uint8_t> data(1000);
+    for (uint8_t& b : data) b = static_cast<uint8_t>(rng.next());
+    const uint64_t whole = xxh64(data.data(), data.size());
+
+    for (size_t chunk = 1; chunk <= 70; chunk++) {
+        state_hasher hasher;
+        for (size_t at = 0; at < data.size(); at += chunk)
+            hasher.update(data.data() + at, std::min(chunk, data.size() - at));
+        report.check(hasher.digest() == whole, "digest troceado de " + std::to_string(chunk) + " bytes");
+    }
+
+    std::cout << "[State] xxh64: " << (sizeof(vectors) / sizeof(vectors[0])) << " vectores\n";
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    std::string test;
+    std::string rom    = GB_TEST_DEFAULT_ROM;
+    int         frames = 120;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_value = (i + 1 < argc);
+        if (!std::strcmp(argv[i], "--rom") && has_value) {
+            rom = argv[++i];
+        } else if (!std::strcmp(argv[i], "--frames") && has_value) {
+            frames = std::atoi(argv[++i]);
+        } else if (argv[i][0] != '-' && test.empty()) {
+            test = argv[i];
+        } else {
+            test.clear();
+            break;
+        }
+    }
+
+    Report report;
+    bool ran = false;
+    if (test == "savestate")   ran = testSaveState(rom, frames, report);
+    else if (test == "rewind") ran = testRewind(rom, frames, report);
+    else if (test == "fork")   ran = testFork(rom, frames, report);
+    else if (test == "determinism") ran = testDeterminism(rom, frames, report);
+    else if (test == "xxh64")  ran = testXxh64(report);
+    else {
+        std::cerr << "Uso: " << argv[0] << " savestate|rewind|fork|determinism|xxh64 [--rom FILE] [--frames N]\n";
+        return 2;
+    }
+
+    if (!ran) return 1;
+    std::cout << "[State] " << test << ": fallos=" << report.failures << "\n";
+    return report.failures ? 1 : 0;
+}